@@ -21,7 +21,9 @@
 #include "dxc/DXIL/DxilSubobject.h"
 #include "dxc/DXIL/DxilTypeSystem.h"
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -189,7 +191,13 @@ public:
   /// Note: this method not update Metadata for ViewIdState.
   void ReEmitDxilResources();
   /// Deserialize DXIL metadata form into in-memory form.
+  /// Type annotations and subobjects are only parsed on first access. The
+  /// deferred loads take a lock, so const accessors may race to trigger them.
+  /// Erasing a function runs RemoveFunction through the module's remove
+  /// hook, which loads the annotations before the function goes away.
   void LoadDxilMetadata();
+  /// Parse any metadata categories deferred by LoadDxilMetadata.
+  void LoadPendingDxilMetadata();
   /// Return true if non-fatal metadata error was detected.
   bool HasMetadataErrors();
 
@@ -396,11 +404,20 @@ private:
   uint32_t m_IntermediateFlags = 0;
   uint32_t m_AutoBindingSpace = UINT_MAX;
 
-  std::unique_ptr<DxilSubobjects> m_pSubobjects;
+  // Mutable so that const accessors can load it on first access.
+  mutable std::unique_ptr<DxilSubobjects> m_pSubobjects;
 
   // m_bMetadataErrors is true if non-fatal metadata errors were encountered.
   // Validator will fail in this case, but should not block module load.
-  bool m_bMetadataErrors = false;
+  mutable bool m_bMetadataErrors = false;
+
+  // Metadata categories deferred by LoadDxilMetadata until first access.
+  // The flags are checked without the lock and cleared once a load is done.
+  mutable std::atomic<bool> m_bTypeSystemPending{false};
+  mutable std::atomic<bool> m_bSubobjectsPending{false};
+  mutable std::mutex m_PendingMetadataLock;
+  void LoadPendingTypeSystem() const;
+  void LoadPendingSubobjects() const;
 
   // DXIL metadata serialization/deserialization.
   llvm::MDTuple *EmitDxilResources();
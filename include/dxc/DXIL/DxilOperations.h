@@ -23,7 +23,9 @@ class Value;
 class Instruction;
 class CallInst;
 } // namespace llvm
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Attributes.h"
 
@@ -55,9 +57,15 @@ public:
   void FixOverloadNames();
 
   // RefreshCache places DXIL types and operation overloads from the module into
-  // caches.
+  // caches. Functions already in the cache are skipped. Only declarations that
+  // have calls are found, since the opcode is read from the first call.
   void RefreshCache();
 
+  // AddToCache places F, a declaration of opCode added to the module without
+  // GetOpFunc, into the caches. This is for declarations copied from another
+  // module before any calls to them exist, such as during linking.
+  void AddToCache(OpCode opCode, llvm::Function *F);
+
   // The single llvm::Type * "OverloadType" has one of these forms:
   // No overloads (NumOverloadDims == 0):
   //  - TS_Void: VoidTy
@@ -77,8 +85,11 @@ public:
   llvm::Function *GetOpFunc(OpCode OpCode,
                             llvm::ArrayRef<llvm::Type *> OverloadTypes);
 
-  const llvm::SmallMapVector<llvm::Type *, llvm::Function *, 8> &
-  GetOpFuncList(OpCode OpCode) const;
+  // Overloads of an opcode class as (overload type, function), in creation
+  // order.
+  typedef llvm::SmallVector<std::pair<llvm::Type *, llvm::Function *>, 8>
+      OverloadList;
+  const OverloadList &GetOpFuncList(OpCode OpCode) const;
   bool IsDxilOpUsed(OpCode opcode) const;
   void RemoveFunction(llvm::Function *F);
   llvm::LLVMContext &GetCtx() { return m_Ctx; }
@@ -222,10 +233,14 @@ private:
   llvm::Type *m_pCBufferRetType[TS_BasicCount];
 
   struct OpCodeCacheItem {
-    llvm::SmallMapVector<llvm::Type *, llvm::Function *, 8> pOverloads;
+    OverloadList pOverloads;
   };
   OpCodeCacheItem m_OpCodeClassCache[(unsigned)OpCodeClass::NumOpClasses];
-  std::unordered_map<const llvm::Function *, OpCodeClass> m_FunctionToOpClass;
+  // Flat lookup of (opcode class, overload type) used by GetOpFunc; the
+  // per-class lists above are only kept for ordered iteration.
+  llvm::DenseMap<std::pair<unsigned, llvm::Type *>, llvm::Function *>
+      m_OverloadCache;
+  llvm::DenseMap<const llvm::Function *, OpCodeClass> m_FunctionToOpClass;
   void UpdateCache(OpCodeClass opClass, llvm::Type *Ty, llvm::Function *F);
 
 public:
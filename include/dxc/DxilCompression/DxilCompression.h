@@ -40,4 +40,22 @@ typedef void *ZlibCallbackFn(void *pUserData, size_t RequiredSize);
 ZlibResult ZlibCompress(IMalloc *pMalloc, const void *pData, size_t pDataSize,
                         void *pUserData, ZlibCallbackFn *Callback,
                         size_t *pOutCompressedSize);
+
+//
+// Same contract as ZlibCompress, but the input is split into blocks of
+// ZlibParallelBlockSize bytes that are deflated concurrently, then joined into
+// one zlib stream that ZlibDecompress (or any other inflater) reads as usual.
+// Blocks do not share a dictionary, so the output is slightly larger than the
+// serial one. It is deterministic and does not depend on NumThreads.
+//
+// Inputs smaller than two blocks go through ZlibCompress. NumThreads of 0
+// uses one thread per hardware thread.
+//
+static const size_t ZlibParallelBlockSize = 128 * 1024;
+
+ZlibResult ZlibCompressParallel(IMalloc *pMalloc, const void *pData,
+                                size_t pDataSize, void *pUserData,
+                                ZlibCallbackFn *Callback,
+                                size_t *pOutCompressedSize,
+                                unsigned NumThreads = 0);
 } // namespace hlsl
@@ -11,7 +11,8 @@
 //
 // Calling ZlibCompressAppend on a buffer appends the compressed data to the
 // end. If at any point the compression fails, the buffer will be shrunk to
-// the original size.
+// the original size. With bParallel set, large inputs are compressed with
+// ZlibCompressParallel.
 //
 
 #include "DxilCompression.h"
@@ -23,7 +24,8 @@ namespace hlsl {
 
 template <typename Buffer>
 ZlibResult ZlibCompressAppend(IMalloc *pMalloc, const void *pData,
-                              size_t dataSize, Buffer &outBuffer) {
+                              size_t dataSize, Buffer &outBuffer,
+                              bool bParallel = false) {
   static_assert(sizeof(typename Buffer::value_type) == sizeof(uint8_t),
                 "Cannot append to a non-byte-sized buffer.");
 
@@ -49,16 +51,20 @@ ZlibResult ZlibCompressAppend(IMalloc *pMalloc, const void *pData,
   const size_t sizeBeforeCompress = outBuffer.size();
   size_t compressedDataSize = 0;
 
-  ZlibResult ret = ZlibCompress(
-      pMalloc, pData, dataSize, &outBuffer,
-      [](void *pUserData, size_t requiredSize) -> void * {
-        Buffer *pBuffer = (Buffer *)pUserData;
-        const size_t lastSize = pBuffer->size();
-        pBuffer->resize(pBuffer->size() + requiredSize);
-        void *ptr = pBuffer->data() + lastSize;
-        return ptr;
-      },
-      &compressedDataSize);
+  ZlibCallbackFn *callback = [](void *pUserData,
+                                size_t requiredSize) -> void * {
+    Buffer *pBuffer = (Buffer *)pUserData;
+    const size_t lastSize = pBuffer->size();
+    pBuffer->resize(pBuffer->size() + requiredSize);
+    void *ptr = pBuffer->data() + lastSize;
+    return ptr;
+  };
+
+  ZlibResult ret =
+      bParallel ? ZlibCompressParallel(pMalloc, pData, dataSize, &outBuffer,
+                                       callback, &compressedDataSize)
+                : ZlibCompress(pMalloc, pData, dataSize, &outBuffer, callback,
+                               &compressedDataSize);
 
   if (ret == ZlibResult::Success) {
     // Resize the buffer to what was actually added to the end.
@@ -71,16 +77,18 @@ ZlibResult ZlibCompressAppend(IMalloc *pMalloc, const void *pData,
 
 template ZlibResult ZlibCompressAppend<llvm::SmallVectorImpl<char>>(
     IMalloc *pMalloc, const void *pData, size_t dataSize,
-    llvm::SmallVectorImpl<char> &outBuffer);
+    llvm::SmallVectorImpl<char> &outBuffer, bool bParallel);
 template ZlibResult ZlibCompressAppend<llvm::SmallVectorImpl<uint8_t>>(
     IMalloc *pMalloc, const void *pData, size_t dataSize,
-    llvm::SmallVectorImpl<uint8_t> &outBuffer);
+    llvm::SmallVectorImpl<uint8_t> &outBuffer, bool bParallel);
 template ZlibResult
 ZlibCompressAppend<std::vector<char>>(IMalloc *pMalloc, const void *pData,
                                       size_t dataSize,
-                                      std::vector<char> &outBuffer);
+                                      std::vector<char> &outBuffer,
+                                      bool bParallel);
 template ZlibResult
 ZlibCompressAppend<std::vector<uint8_t>>(IMalloc *pMalloc, const void *pData,
                                          size_t dataSize,
-                                         std::vector<uint8_t> &outBuffer);
+                                         std::vector<uint8_t> &outBuffer,
+                                         bool bParallel);
 } // namespace hlsl
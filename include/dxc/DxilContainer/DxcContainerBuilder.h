@@ -22,10 +22,6 @@
 #include "llvm/ADT/SmallVector.h"
 
 using namespace hlsl;
-namespace hlsl {
-class AbstractMemoryStream;
-}
-
 class DxcContainerBuilder : public IDxcContainerBuilder {
 public:
   // Loads DxilContainer to the builder
@@ -55,12 +51,26 @@ protected:
   DXC_MICROCOM_TM_REF_FIELDS()
 
 private:
+  // A part is either a blob added through AddPart, or a reference to a part
+  // header in the loaded container, which is kept alive by m_pContainer.
   class DxilPart {
   public:
     UINT32 m_fourCC;
     CComPtr<IDxcBlob> m_Blob;
+    const DxilPartHeader *m_pSourceHeader;
     DxilPart(UINT32 fourCC, IDxcBlob *pSource)
-        : m_fourCC(fourCC), m_Blob(pSource) {}
+        : m_fourCC(fourCC), m_Blob(pSource), m_pSourceHeader(nullptr) {}
+    explicit DxilPart(const DxilPartHeader *pSourceHeader)
+        : m_fourCC(pSourceHeader->PartFourCC), m_pSourceHeader(pSourceHeader) {
+    }
+    UINT32 GetSize() const {
+      return m_pSourceHeader ? m_pSourceHeader->PartSize
+                             : (UINT32)m_Blob->GetBufferSize();
+    }
+    const void *GetData() const {
+      return m_pSourceHeader ? (const void *)(m_pSourceHeader + 1)
+                             : m_Blob->GetBufferPointer();
+    }
   };
   typedef llvm::SmallVector<DxilPart, 8> PartList;
 
@@ -77,9 +87,6 @@ private:
   void HashAndUpdate(DxilContainerHeader *ContainerHeader);
 
   UINT32 ComputeContainerSize();
-  HRESULT UpdateContainerHeader(AbstractMemoryStream *pStream,
-                                uint32_t containerSize);
-  HRESULT UpdateOffsetTable(AbstractMemoryStream *pStream);
-  HRESULT UpdateParts(AbstractMemoryStream *pStream);
+  void WriteContainer(char *pDest, uint32_t containerSize);
   void AddPart(DxilPart &&part);
 };
@@ -300,6 +300,19 @@ struct DxilCompilerVersion {
 //        char Content[ ContentSizeInBytes ]
 //        (0-3 zero bytes to align to a 4-byte boundary)
 //
+// With ZlibPerEntry compression, each entry is compressed on its own, so that
+// a single source can be read without decompressing the others:
+//
+//     DxilSourceInfo_SourceContentsIndexEntry[ Count ]
+//
+//     char Stream[ SizeInBytes ] of entry 0
+//     (0-3 zero bytes to align to a 4-byte boundary)
+//
+//     ...
+//
+//     char Stream[ SizeInBytes ] of entry Count - 1
+//     (0-3 zero bytes to align to a 4-byte boundary)
+//
 // ================ 3. Args ==================================
 //
 //   DxilSourceInfo_Args
@@ -380,7 +393,11 @@ struct DxilSourceInfo_SourceNamesEntry {
   // boundary.
 };
 
-enum class DxilSourceInfo_SourceContentsCompressType : uint16_t { None, Zlib };
+enum class DxilSourceInfo_SourceContentsCompressType : uint16_t {
+  None,
+  Zlib,
+  ZlibPerEntry
+};
 
 struct DxilSourceInfo_SourceContents {
   uint32_t AlignedSizeInBytes; // Size of the entry including this header.
@@ -408,6 +425,18 @@ struct DxilSourceInfo_SourceContentsEntry {
   // 4-byte boundary.
 };
 
+struct DxilSourceInfo_SourceContentsIndexEntry {
+  uint32_t Flags;         // Reserved, must be set to 0.
+  uint32_t OffsetInBytes; // Offset of the stream from the end of the index.
+                          // Aligned to 4-byte boundary.
+  uint32_t SizeInBytes;   // Size of the stream. The entry is stored
+                          // uncompressed when this equals
+                          // UncompressedSizeInBytes.
+  uint32_t UncompressedSizeInBytes; // AlignedSizeInBytes of the
+                                    // DxilSourceInfo_SourceContentsEntry
+                                    // held by the stream.
+};
+
 #pragma pack(pop)
 
 enum class DxilShaderPDBInfoVersion : uint16_t {
@@ -653,6 +682,8 @@ enum class SerializeDxilFlags : uint32_t {
   IncludeReflectionPart = 1 << 4,       // Include reflection in STAT part.
   StripRootSignature =
       1 << 5, // Strip Root Signature from main shader container.
+  ParallelBitcodeWriter =
+      1 << 6, // Encode function blocks of the DXIL bitcode on worker threads.
 };
 inline SerializeDxilFlags &operator|=(SerializeDxilFlags &l,
                                       const SerializeDxilFlags &r) {
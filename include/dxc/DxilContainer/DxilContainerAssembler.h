@@ -21,7 +21,8 @@ class DxilPipelineStateValidation;
 
 namespace llvm {
 class Module;
-}
+class raw_ostream;
+} // namespace llvm
 
 namespace hlsl {
 
@@ -80,6 +81,14 @@ void StripAndCreateReflectionStream(
     llvm::Module *pReflectionM, uint32_t *pReflectionPartSizeInBytes,
     AbstractMemoryStream **ppReflectionStreamOut);
 
+// Write the bitcode of M. With SerializeDxilFlags::ParallelBitcodeWriter,
+// function blocks are encoded on NumThreads threads, or one per hardware
+// thread if it is zero; the output is the same.
+void WriteBitcodeForContainer(const llvm::Module *M, llvm::raw_ostream &OS,
+                              bool ShouldPreserveUseListOrder,
+                              SerializeDxilFlags Flags,
+                              unsigned NumThreads = 0);
+
 void WriteProgramPart(const hlsl::ShaderModel *pModel,
                       AbstractMemoryStream *pModuleBitcode, IStream *pStream);
 
@@ -90,7 +99,8 @@ void SerializeDxilContainerForModule(
     DxilShaderHash *pShaderHashOut = nullptr,
     AbstractMemoryStream *pReflectionStreamOut = nullptr,
     AbstractMemoryStream *pRootSigStreamOut = nullptr,
-    void *pPrivateData = nullptr, size_t PrivateDataSize = 0);
+    void *pPrivateData = nullptr, size_t PrivateDataSize = 0,
+    unsigned BitcodeWriterThreads = 0);
 void SerializeDxilContainerForRootSignature(
     hlsl::RootSignatureHandle *pRootSigHandle, AbstractMemoryStream *pStream);
 
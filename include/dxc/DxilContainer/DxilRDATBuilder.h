@@ -26,6 +26,7 @@ class DxilRDATBuilder {
   StringBufferPart *m_pStringBufferPart = nullptr;
   IndexArraysPart *m_pIndexArraysPart = nullptr;
   RawBytesPart *m_pRawBytesPart = nullptr;
+  NameIndexPart *m_pNameIndexPart = nullptr;
   RDATTable *m_pTables[(size_t)RDAT::RecordTableIndex::RecordTableCount] = {};
 
   bool m_bRecordDeduplicationEnabled = true;
@@ -80,6 +81,9 @@ public:
     return *GetOrAddPart(&m_pIndexArraysPart);
   }
   RawBytesPart &GetRawBytesPart() { return *GetOrAddPart(&m_pRawBytesPart); }
+  NameIndexPart &GetNameIndexPart() {
+    return *GetOrAddPart(&m_pNameIndexPart);
+  }
 
   struct SizeInfo {
     uint32_t sizeInBytes;
@@ -19,6 +19,7 @@
 
 #include <set>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -34,11 +35,29 @@ public:
   virtual ~RDATPart() {}
 };
 
+// Append-only byte buffer laid out exactly as the part is written. Entries
+// are looked up by hash and compared in place against the buffer, so every
+// distinct entry is stored once and never copied before Write.
+class DeduplicatingBuffer {
+private:
+  std::vector<char> m_Data;
+  // Hash of the entry bytes to the offset and size of the entry in m_Data.
+  std::unordered_multimap<size_t, std::pair<uint32_t, uint32_t>> m_Index;
+
+public:
+  // Returns the offset of bytes in the buffer, appending them unless an
+  // identical entry exists and bDeduplicate is set. With bNullTerminate, a
+  // null byte is stored after the entry and is part of the comparison.
+  uint32_t Insert(llvm::StringRef bytes, bool bDeduplicate = true,
+                  bool bNullTerminate = false);
+  const char *data() const { return m_Data.data(); }
+  size_t size() const { return m_Data.size(); }
+  bool empty() const { return m_Data.empty(); }
+};
+
 class StringBufferPart : public RDATPart {
 private:
-  std::unordered_map<std::string, uint32_t> m_Map;
-  std::vector<llvm::StringRef> m_List;
-  size_t m_Size = 0;
+  DeduplicatingBuffer m_Buffer;
 
 public:
   StringBufferPart() {
@@ -51,7 +70,7 @@ public:
   RDAT::RuntimeDataPartType GetType() const {
     return RDAT::RuntimeDataPartType::StringBuffer;
   }
-  uint32_t GetPartSize() const { return m_Size; }
+  uint32_t GetPartSize() const { return m_Buffer.size(); }
   void Write(void *ptr);
 };
 
@@ -111,9 +130,7 @@ public:
 
 class RawBytesPart : public RDATPart {
 private:
-  std::unordered_map<std::string, uint32_t> m_Map;
-  std::vector<llvm::StringRef> m_List;
-  size_t m_Size = 0;
+  DeduplicatingBuffer m_Buffer;
 
 public:
   RawBytesPart() {}
@@ -128,16 +145,35 @@ public:
   RDAT::RuntimeDataPartType GetType() const {
     return RDAT::RuntimeDataPartType::RawBytes;
   }
-  uint32_t GetPartSize() const { return m_Size; }
+  uint32_t GetPartSize() const { return m_Buffer.size(); }
+  void Write(void *ptr);
+};
+
+// Hash index over record names; see RuntimeDataNameIndexHeader.
+class NameIndexPart : public RDATPart {
+private:
+  std::vector<RDAT::RuntimeDataNameIndexEntry> m_Entries;
+  std::set<std::tuple<uint32_t, uint32_t, uint32_t>> m_EntrySet;
+  uint32_t m_IndexedTables = 0;
+  uint32_t GetBucketCount() const;
+
+public:
+  // Marks table as fully indexed, so readers can rely on the index for it.
+  void AddTable(RDAT::RuntimeDataPartType table);
+  void Insert(RDAT::RuntimeDataPartType table, llvm::StringRef name,
+              uint32_t nameOffset, uint32_t row);
+
+  RDAT::RuntimeDataPartType GetType() const {
+    return RDAT::RuntimeDataPartType::NameIndex;
+  }
+  uint32_t GetPartSize() const;
   void Write(void *ptr);
 };
 
 class RDATTable : public RDATPart {
 protected:
-  // m_map is map of records to their index.
-  // Used to alias identical records.
-  std::unordered_map<std::string, uint32_t> m_map;
-  std::vector<llvm::StringRef> m_rows;
+  // Rows back to back, aliasing identical records when deduplicating.
+  DeduplicatingBuffer m_rows;
   size_t m_RecordStride = 0;
   bool m_bDeduplicationEnabled = false;
   RDAT::RuntimeDataPartType m_Type = RDAT::RuntimeDataPartType::Invalid;
@@ -155,7 +191,7 @@ public:
   }
 
   uint32_t Count() {
-    size_t count = m_rows.size();
+    size_t count = m_RecordStride ? m_rows.size() / m_RecordStride : 0;
     return (count < UINT32_MAX) ? count : 0;
   }
 
@@ -14,6 +14,7 @@
 #include "dxc/DXIL/DxilConstants.h"
 
 #include <cstddef>
+#include <cstring>
 
 #define RDAT_NULL_REF ((uint32_t)0xFFFFFFFF)
 
@@ -34,6 +35,10 @@ namespace RDAT {
 //      byte UTF8Data[part.Size];
 //    - else if part.Type is Index:
 //      uint32_t IndexData[part.Size / 4];
+//    - else if part.Type is NameIndex:
+//      RuntimeDataNameIndexHeader index;
+//      uint32_t BucketStart[index.BucketCount + 1];
+//      RuntimeDataNameIndexEntry Entries[index.EntryCount];
 
 enum RuntimeDataVersion {
   // Cannot be mistaken for part count from prerelease version
@@ -80,6 +85,7 @@ enum class RuntimeDataPartType : uint32_t {
   CSInfoTable,
   MSInfoTable,
   ASInfoTable,
+  NameIndex,
 
   LastPlus1,
   LastExperimental = LastPlus1 - 1,
@@ -161,6 +167,35 @@ struct RuntimeDataTableHeader {
   // byte TableData[RecordCount * RecordStride];
 };
 
+// Optional hash index over record names, so that a record can be found by
+// name without scanning its table. Entries of bucket b are
+// Entries[BucketStart[b]] up to Entries[BucketStart[b + 1]], and a name lands
+// in bucket RDATNameHash(name) & (BucketCount - 1).
+struct RuntimeDataNameIndexHeader {
+  uint32_t BucketCount;   // Power of two.
+  uint32_t EntryCount;
+  uint32_t IndexedTables; // Bit (1 << PartType) set for each indexed table.
+};
+struct RuntimeDataNameIndexEntry {
+  RuntimeDataPartType Table;
+  uint32_t Hash; // RDATNameHash of the name
+  uint32_t Name; // Offset in the string buffer
+  uint32_t Row;  // Record index in Table
+};
+
+// 32-bit FNV-1a, part of the NameIndex format.
+inline uint32_t RDATNameHash(const char *name, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= (uint8_t)name[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+inline uint32_t RDATNameHash(const char *name) {
+  return RDATNameHash(name, strlen(name));
+}
+
 ///////////////////////////////////////
 // Raw Reader Classes
 
@@ -259,6 +294,70 @@ public:
   const char *Data() const { return m_table; }
 };
 
+class NameIndexReader {
+  const RuntimeDataNameIndexHeader *m_pHeader = nullptr;
+  const uint32_t *m_pBucketStart = nullptr;
+  const RuntimeDataNameIndexEntry *m_pEntries = nullptr;
+
+public:
+  // Leaves the reader invalid if the part is malformed.
+  void Init(const void *data, uint32_t size) {
+    *this = NameIndexReader();
+    if (size < sizeof(RuntimeDataNameIndexHeader))
+      return;
+    const RuntimeDataNameIndexHeader *pHeader =
+        reinterpret_cast<const RuntimeDataNameIndexHeader *>(data);
+    const uint64_t bucketBytes =
+        ((uint64_t)pHeader->BucketCount + 1) * sizeof(uint32_t);
+    const uint64_t entryBytes =
+        (uint64_t)pHeader->EntryCount * sizeof(RuntimeDataNameIndexEntry);
+    if (!pHeader->BucketCount ||
+        (pHeader->BucketCount & (pHeader->BucketCount - 1)) ||
+        sizeof(RuntimeDataNameIndexHeader) + bucketBytes + entryBytes > size)
+      return;
+    m_pHeader = pHeader;
+    m_pBucketStart = reinterpret_cast<const uint32_t *>(pHeader + 1);
+    m_pEntries = reinterpret_cast<const RuntimeDataNameIndexEntry *>(
+        m_pBucketStart + pHeader->BucketCount + 1);
+  }
+  bool Valid() const { return m_pHeader != nullptr; }
+  operator bool() const { return Valid(); }
+  uint32_t BucketCount() const { return Valid() ? m_pHeader->BucketCount : 0; }
+  uint32_t EntryCount() const { return Valid() ? m_pHeader->EntryCount : 0; }
+  const RuntimeDataNameIndexEntry *Entries() const { return m_pEntries; }
+  const uint32_t *BucketStart() const { return m_pBucketStart; }
+
+  // Whether every named record of table is in the index.
+  bool Indexes(RuntimeDataPartType table) const {
+    return Valid() && (uint32_t)table < 32 &&
+           (m_pHeader->IndexedTables & (1u << (uint32_t)table));
+  }
+
+  // Returns the lowest row of table with the given name, or RDAT_NULL_REF.
+  uint32_t Find(RuntimeDataPartType table, const char *name,
+                const StringTableReader &strings) const {
+    if (!Valid())
+      return RDAT_NULL_REF;
+    const size_t nameSize = strlen(name);
+    const uint32_t hash = RDATNameHash(name, nameSize);
+    const uint32_t bucket = hash & (m_pHeader->BucketCount - 1);
+    uint32_t begin = m_pBucketStart[bucket];
+    uint32_t end = m_pBucketStart[bucket + 1];
+    if (end > m_pHeader->EntryCount)
+      end = m_pHeader->EntryCount;
+    uint32_t row = RDAT_NULL_REF;
+    for (uint32_t i = begin; i < end; i++) {
+      const RuntimeDataNameIndexEntry &entry = m_pEntries[i];
+      if (entry.Table == table && entry.Hash == hash && entry.Row < row &&
+          entry.Name < strings.Size() &&
+          nameSize < strings.Size() - entry.Name &&
+          memcmp(strings.Get(entry.Name), name, nameSize + 1) == 0)
+        row = entry.Row;
+    }
+    return row;
+  }
+};
+
 class RawBytesReader {
   const void *m_table;
   uint32_t m_size;
@@ -307,6 +406,7 @@ struct RDATContext {
   StringTableReader StringBuffer;
   IndexTableReader IndexTable;
   RawBytesReader RawBytes;
+  NameIndexReader NameIndex;
   TableReader Tables[(unsigned)RecordTableIndex::RecordTableCount];
   const TableReader &Table(RecordTableIndex idx) const {
     if (idx < RecordTableIndex::RecordTableCount)
@@ -640,6 +740,25 @@ public:
   uint32_t size() const { return Count(); }
   const _RecordReader operator[](uint32_t index) const { return Row(index); }
   operator bool() { return m_pContext && Count(); }
+
+  // Returns the first record matching name, or an invalid reader. Uses the
+  // NameIndex part when it covers this table, and scans the table otherwise.
+  // Only defined for records with a RecordNameMatches overload.
+  _RecordReader FindByName(const char *name) const {
+    typedef typename _RecordReader::RecordType RecordType;
+    const RuntimeDataPartType table = RecordTraits<RecordType>::PartType();
+    if (m_pContext->NameIndex.Indexes(table)) {
+      uint32_t row =
+          m_pContext->NameIndex.Find(table, name, m_pContext->StringBuffer);
+      return row != RDAT_NULL_REF ? Row(row) : _RecordReader();
+    }
+    for (uint32_t i = 0; i < Count(); i++) {
+      _RecordReader reader = Row(i);
+      if (RecordNameMatches(reader, name))
+        return reader;
+    }
+    return {};
+  }
 };
 
 /////////////////////////////
@@ -658,6 +777,17 @@ public:
 #define DEF_RDAT_TYPES DEF_RDAT_READER_DECL
 #include "dxc/DxilContainer/RDAT_Macros.inl"
 
+// Names FindByName matches, which are also the names put in the NameIndex.
+inline bool RecordNameMatches(const RuntimeDataFunctionInfo_Reader &reader,
+                              const char *name) {
+  return reader && (strcmp(reader.getName(), name) == 0 ||
+                    strcmp(reader.getUnmangledName(), name) == 0);
+}
+inline bool RecordNameMatches(const RuntimeDataSubobjectInfo_Reader &reader,
+                              const char *name) {
+  return reader && strcmp(reader.getName(), name) == 0;
+}
+
 /////////////////////////////
 /////////////////////////////
 
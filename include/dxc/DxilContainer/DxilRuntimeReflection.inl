@@ -139,6 +139,10 @@ bool DxilRuntimeData::InitFromRDAT(const void *pRDAT, size_t size) {
           m_Context.RawBytes.Init(PR.ReadArray<char>(part.Size), part.Size);
           break;
         }
+        case RuntimeDataPartType::NameIndex: {
+          m_Context.NameIndex.Init(PR.ReadArray<char>(part.Size), part.Size);
+          break;
+        }
 
 // Once per table.
 #define RDAT_STRUCT_TABLE(type, table)                                         \
@@ -278,12 +282,49 @@ static bool ValidateRecordTable(RDATContext &ctx, RecordTableIndex tableIndex) {
   return true;
 }
 
+static bool ValidateNameIndex(const RDATContext &ctx) {
+  const NameIndexReader &index = ctx.NameIndex;
+  if (!index)
+    return true;
+  // Buckets must be ordered and in range, and entries must be in the right
+  // bucket and point at existing strings and rows.
+  const uint32_t *bucketStart = index.BucketStart();
+  if (bucketStart[0] != 0 ||
+      bucketStart[index.BucketCount()] != index.EntryCount())
+    return false;
+  for (uint32_t b = 0; b < index.BucketCount(); b++) {
+    if (bucketStart[b] > bucketStart[b + 1])
+      return false;
+    for (uint32_t i = bucketStart[b]; i < bucketStart[b + 1]; i++) {
+      const RuntimeDataNameIndexEntry &entry = index.Entries()[i];
+      if ((entry.Hash & (index.BucketCount() - 1)) != b ||
+          !ValidateStringRef(ctx, entry.Name))
+        return false;
+      switch (entry.Table) {
+#define RDAT_STRUCT_TABLE(type, table)                                         \
+  case RuntimeDataPartType::table:                                             \
+    if (!ValidateRecordRef<type>(ctx, entry.Row))                              \
+      return false;                                                            \
+    break;
+#define DEF_RDAT_TYPES DEF_RDAT_DEFAULTS
+#include "dxc/DxilContainer/RDAT_Macros.inl"
+      default:
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 bool DxilRuntimeData::Validate() {
   if (m_Context.StringBuffer.Size()) {
     if (m_Context.StringBuffer.Data()[m_Context.StringBuffer.Size() - 1] != 0)
       return false;
   }
 
+  if (!ValidateNameIndex(m_Context))
+    return false;
+
   // Once per table.
 #define RDAT_STRUCT_TABLE(type, table)                                         \
   ValidateRecordTable<type>(m_Context, RecordTableIndex::table);
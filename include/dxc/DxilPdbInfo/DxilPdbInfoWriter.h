@@ -18,7 +18,9 @@ struct IMalloc;
 
 namespace hlsl {
 
+// With bParallelDeflate, large data is compressed with ZlibCompressParallel.
 HRESULT WritePdbInfoPart(IMalloc *pMalloc, const void *pUncompressedPdbInfoData,
-                         size_t size, std::vector<char> *outBuffer);
+                         size_t size, std::vector<char> *outBuffer,
+                         bool bParallelDeflate = false);
 
 }
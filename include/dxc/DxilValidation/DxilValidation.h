@@ -49,11 +49,14 @@ HRESULT ValidateLoadModuleFromContainer(
     std::unique_ptr<llvm::Module> &pDebugModule, llvm::LLVMContext &Ctx,
     llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream);
 // Lazy loads module from container, validating load, but not module.
+// With bSkipProgramIfDebug, only the debug module is loaded when the container
+// has one; the DXIL part must still be present.
 HRESULT ValidateLoadModuleFromContainerLazy(
     const void *pContainer, uint32_t ContainerSize,
     std::unique_ptr<llvm::Module> &pModule,
     std::unique_ptr<llvm::Module> &pDebugModule, llvm::LLVMContext &Ctx,
-    llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream);
+    llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream,
+    bool bSkipProgramIfDebug = false);
 
 // Load and validate Dxil module from bitcode.
 HRESULT ValidateDxilBitcode(const char *pIL, uint32_t ILLength,
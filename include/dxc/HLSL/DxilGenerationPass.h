@@ -17,6 +17,7 @@ class ModulePass;
 class Function;
 class FunctionPass;
 class Instruction;
+class PassManagerBuilder;
 class PassRegistry;
 class StringRef;
 struct PostDominatorTree;
@@ -151,4 +152,8 @@ void initializeDxilSimpleGVNEliminateRegionPass(llvm::PassRegistry &);
 ModulePass *createDxilModuleInitPass();
 void initializeDxilModuleInitPass(llvm::PassRegistry &);
 
+ModulePass *createDxilParallelLibOptPass();
+ModulePass *createDxilParallelLibOptPass(const PassManagerBuilder &Builder);
+void initializeDxilParallelLibOptPass(llvm::PassRegistry &);
+
 } // namespace llvm
@@ -50,6 +50,20 @@ static constexpr Toggle TOGGLE_STRUCTURIZE_LOOP_EXITS_FOR_UNROLL = {
 static constexpr Toggle TOGGLE_DEBUG_NOPS = {"debug-nops", DEFAULT_ON};
 static constexpr Toggle TOGGLE_STRUCTURIZE_RETURNS = {"structurize-returns",
                                                       DEFAULT_OFF};
+static constexpr Toggle TOGGLE_PARALLEL_LIB_OPT = {"parallel-lib-opt",
+                                                   DEFAULT_OFF};
+static constexpr Toggle TOGGLE_PARALLEL_BITCODE_WRITER = {
+    "parallel-bitcode-writer", DEFAULT_OFF};
+static constexpr Toggle TOGGLE_PARALLEL_DEFLATE = {"parallel-deflate",
+                                                   DEFAULT_OFF};
+
+// Numeric selects, set with -opt-select <name> <value>.
+static constexpr llvm::StringRef SELECT_SROA_MAX_AGGREGATE_LEAVES =
+    "sroa-max-aggregate-leaves";
+static constexpr llvm::StringRef SELECT_SROA_MEMORY_BUDGET_KB =
+    "sroa-memory-budget-kb";
+static constexpr llvm::StringRef SELECT_PARALLEL_BITCODE_WRITER_THREADS =
+    "parallel-bitcode-writer-threads";
 
 struct OptimizationToggles {
   // Optimization pass enables, disables and selects
@@ -67,6 +81,14 @@ struct OptimizationToggles {
       return It->second;
     return Opt.Default;
   }
+  unsigned GetSelectUnsigned(llvm::StringRef Name, unsigned Default) const {
+    auto It = Selects.find(Name.str());
+    unsigned Value = 0;
+    if (It == Selects.end() ||
+        llvm::StringRef(It->second).getAsInteger(0, Value))
+      return Default;
+    return Value;
+  }
 };
 
 } // namespace options
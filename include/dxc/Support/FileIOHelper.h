@@ -224,6 +224,8 @@ public:
 HRESULT CreateMemoryStream(IMalloc *pMalloc,
                            AbstractMemoryStream **ppResult) throw();
 HRESULT CreateReadOnlyBlobStream(IDxcBlob *pSource, IStream **ppResult) throw();
+// Creates or truncates pFileName, and returns a write-only stream over it.
+HRESULT CreateFileWriteStream(LPCWSTR pFileName, IStream **ppResult) throw();
 HRESULT CreateFixedSizeMemoryStream(LPBYTE pBuffer, size_t size,
                                     AbstractMemoryStream **ppResult) throw();
 
@@ -139,6 +139,7 @@ public:
 
   llvm::StringRef AssemblyCode;               // OPT_Fc
   llvm::StringRef DebugFile;                  // OPT_Fd
+  llvm::StringRef DisassembleFunction;        // OPT_disasm_function
   llvm::StringRef EntryPoint;                 // OPT_entrypoint
   llvm::StringRef ExternalFn;                 // OPT_external_fn
   llvm::StringRef ExternalLib;                // OPT_external_lib
@@ -215,6 +216,7 @@ public:
   bool StripDebug = false;                   // OPT Qstrip_debug
   bool EmbedDebug = false;                   // OPT Qembed_debug
   bool SourceInDebugModule = false;          // OPT Zs
+  bool SourceCompressPerFile = false;        // OPT_Qsource_compress_per_file
   bool SourceOnlyDebug = false;              // OPT Qsource_only_debug
   bool PdbInPrivate = false;                 // OPT Qpdb_in_private
   bool StripRootSignature = false;           // OPT_Qstrip_rootsignature
@@ -242,6 +244,7 @@ public:
   bool TimeReport = false;              // OPT_ftime_report
   std::string TimeTrace = "";           // OPT_ftime_trace[EQ]
   unsigned TimeTraceGranularity = 500;  // OPT_ftime_trace_granularity_EQ
+  bool TimeTracePassCosts = false;      // OPT_ftime_trace_pass_costs
   bool VerifyDiagnostics = false;       // OPT_verify
   UnusedResourceBinding UnusedResourceBindings =
       UnusedResourceBinding::Strip; // OPT_fhlsl_unused_resource_bindings_EQ
@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// WorkerThreads.h                                                           //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Helpers to run work on worker threads under the caller's allocator.       //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace hlsl {
+
+// Returns the number of threads to use when Requested were asked for. Zero
+// means one per hardware thread.
+unsigned GetWorkerThreadCount(unsigned Requested);
+
+// Runs a function on a worker thread with the thread malloc that was current
+// when the runner was created, so memory allocated by the work can be
+// released on the creating thread.
+typedef std::function<void(const std::function<void()> &)> WorkerRunner;
+WorkerRunner CreateWorkerRunner();
+
+// Calls Work(i) for every i in [0, Count), on the calling thread and on up to
+// NumThreads - 1 worker threads that run under CreateWorkerRunner. NumThreads
+// of zero uses GetWorkerThreadCount. If a thread cannot be started, the
+// running ones pick up its share. The first exception thrown by Work is
+// rethrown once all threads are done; remaining indices are skipped.
+void ParallelFor(unsigned NumThreads, size_t Count,
+                 const std::function<void(size_t)> &Work);
+
+} // namespace hlsl
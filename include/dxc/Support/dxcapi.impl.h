@@ -33,6 +33,33 @@ public:
   ~raw_stream_ostream() override { flush(); }
 };
 
+// Writes to any IStream through a fixed-size buffer, so text reaches the
+// stream while it is being produced rather than all at once.
+class raw_istream_ostream : public llvm::raw_ostream {
+private:
+  CComPtr<IStream> m_pStream;
+  uint64_t m_Pos = 0;
+  void write_impl(const char *Ptr, size_t Size) override {
+    while (Size) {
+      ULONG cbChunk = (ULONG)std::min<size_t>(Size, UINT32_MAX);
+      ULONG cbWritten;
+      IFT(m_pStream->Write(Ptr, cbChunk, &cbWritten));
+      IFTBOOL(cbWritten == cbChunk, E_FAIL);
+      Ptr += cbChunk;
+      Size -= cbChunk;
+      m_Pos += cbChunk;
+    }
+  }
+  uint64_t current_pos() const override { return m_Pos; }
+
+public:
+  raw_istream_ostream(IStream *pStream, size_t BufferSize = 64 * 1024)
+      : m_pStream(pStream) {
+    SetBufferSize(BufferSize);
+  }
+  ~raw_istream_ostream() override { flush(); }
+};
+
 namespace {
 HRESULT TranslateUtf8StringForOutput(LPCSTR pStr, SIZE_T size, UINT32 codePage,
                                      IDxcBlobEncoding **ppBlobEncoding) {
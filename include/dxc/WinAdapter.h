@@ -208,6 +208,7 @@
 
 //===--------------------- HRESULT Related Macros -------------------------===//
 
+#define E_PENDING (HRESULT)0x8000000A
 #define E_BOUNDS (HRESULT)0x8000000B
 #define E_NOT_VALID_STATE (HRESULT)0x8007139F
 
@@ -351,4 +351,39 @@ public:
   virtual HRESULT STDMETHODCALLTYPE
   UnRegisterDxilContainerEventHandler(UINT64 cookie) = 0;
 };
+
+CROSS_PLATFORM_UUIDOF(IDxcFunctionDisassembler,
+                      "a6568ce5-810c-4118-a014-682d307427d7")
+struct IDxcFunctionDisassembler : public IUnknown {
+public:
+  /// Disassembles a single function of a program. Signatures, resources and
+  /// other module metadata are printed as usual, but only the body of the
+  /// named function is loaded from the bitcode.
+  virtual HRESULT STDMETHODCALLTYPE DisassembleFunction(
+      const DxcBuffer *pObject, // Program to disassemble: dxil container or
+                                // bitcode.
+      LPCSTR pFunctionName,     // Name of the function to disassemble.
+      REFIID riid,
+      LPVOID *ppResult // IDxcResult: status, disassembly text, and errors
+      ) = 0;
+};
+
+CROSS_PLATFORM_UUIDOF(IDxcStreamDisassembler,
+                      "5e0ce5f3-43c6-4a4c-9b0d-7e6b4dc6d0a2")
+struct IDxcStreamDisassembler : public IUnknown {
+public:
+  /// Disassembles a program into pOutput while it is printed, with only a
+  /// bounded amount of text buffered, instead of into a result blob. The text
+  /// is UTF-8 without a terminating null. If pFunctionName is set, only that
+  /// function's body is printed, as with DisassembleFunction.
+  virtual HRESULT STDMETHODCALLTYPE DisassembleToStream(
+      const DxcBuffer *pObject, // Program to disassemble: dxil container or
+                                // bitcode.
+      LPCSTR pFunctionName,     // Optional name of the function to
+                                // disassemble.
+      IStream *pOutput,         // Receives the disassembly text.
+      REFIID riid,
+      LPVOID *ppResult // IDxcResult: status and errors
+      ) = 0;
+};
 #endif
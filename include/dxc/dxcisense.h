@@ -178,7 +178,12 @@ typedef enum DxcTranslationUnitFlags {
   DxcTranslationUnitFlags_IncludeBriefCommentsInCodeCompletion = 0x80,
 
   // Used to indicate that compilation should occur on the caller's thread.
-  DxcTranslationUnitFlags_UseCallerThread = 0x800
+  DxcTranslationUnitFlags_UseCallerThread = 0x800,
+
+  // Used to indicate that the bodies of non-template functions declared in
+  // files included from the main file's preamble should be skipped on every
+  // parse and reparse. Their declarations are still parsed.
+  DxcTranslationUnitFlags_SkipPreambleFunctionBodies = 0x1000
 } DxcTranslationUnitFlags;
 
 typedef enum DxcCursorFormatting {
@@ -651,11 +656,13 @@ struct IDxcDiagnostic;
 struct IDxcFile;
 struct IDxcInclusion;
 struct IDxcIntelliSense;
+struct IDxcIntelliSenseOperation;
 struct IDxcIndex;
 struct IDxcSourceLocation;
 struct IDxcSourceRange;
 struct IDxcToken;
 struct IDxcTranslationUnit;
+struct IDxcTranslationUnit2;
 struct IDxcType;
 struct IDxcUnsavedFile;
 struct IDxcCodeCompleteResults;
@@ -939,6 +946,52 @@ struct IDxcCompletionString : public IUnknown {
   GetCompletionChunkText(unsigned chunkNumber, _Out_ LPSTR *pResult) = 0;
 };
 
+// An operation queued by IDxcTranslationUnit2 on the worker thread of a
+// translation unit. Results are immutable snapshots that stay valid after
+// later operations complete.
+CROSS_PLATFORM_UUIDOF(IDxcIntelliSenseOperation,
+                      "4fdc24b8-4e20-4e78-bf81-ed7be7838d51")
+struct IDxcIntelliSenseOperation : public IUnknown {
+  // Cancels the operation. A queued operation never runs; the result of a
+  // running operation is discarded once it completes.
+  virtual HRESULT STDMETHODCALLTYPE Cancel() = 0;
+  // Blocks until the operation has completed or has been cancelled.
+  virtual HRESULT STDMETHODCALLTYPE Wait() = 0;
+  // Gets E_PENDING while the operation is queued or running, E_ABORT if it
+  // was cancelled, and the result of the operation otherwise.
+  virtual HRESULT STDMETHODCALLTYPE GetStatus(_Out_ HRESULT *pStatus) = 0;
+  // Gets the translation unit produced by ReparseAsync.
+  virtual HRESULT STDMETHODCALLTYPE GetTranslationUnit(
+      _Outptr_result_nullonfailure_ IDxcTranslationUnit **pResult) = 0;
+  // Gets the results produced by CodeCompleteAtAsync.
+  virtual HRESULT STDMETHODCALLTYPE GetCodeCompleteResults(
+      _Outptr_result_nullonfailure_ IDxcCodeCompleteResults **pResult) = 0;
+};
+
+// Translation unit with background reparse and code completion. Each
+// translation unit returned by IDxcIndex::ParseTranslationUnit owns a worker
+// thread that is shared with the translation units produced from it, so
+// different files are processed concurrently while requests for one file run
+// in order. Queuing an operation cancels the earlier operations of the same
+// kind that have not completed yet.
+CROSS_PLATFORM_UUIDOF(IDxcTranslationUnit2,
+                      "f9df48f8-5874-4557-bfd7-64d7b78bacfb")
+struct IDxcTranslationUnit2 : public IDxcTranslationUnit {
+  // Parses the file again with the given unsaved files into a new
+  // translation unit; this translation unit is left unchanged.
+  virtual HRESULT STDMETHODCALLTYPE ReparseAsync(
+      _In_count_(numUnsavedFiles) IDxcUnsavedFile **pUnsavedFiles,
+      unsigned numUnsavedFiles,
+      _COM_Outptr_ IDxcIntelliSenseOperation **pOperation) = 0;
+  // Computes code completion results on the worker thread. The unsaved files
+  // are referenced until the operation completes.
+  virtual HRESULT STDMETHODCALLTYPE CodeCompleteAtAsync(
+      _In_ const char *fileName, unsigned line, unsigned column,
+      _In_count_(numUnsavedFiles) IDxcUnsavedFile **pUnsavedFiles,
+      unsigned numUnsavedFiles, _In_ DxcCodeCompleteFlags options,
+      _COM_Outptr_ IDxcIntelliSenseOperation **pOperation) = 0;
+};
+
 // Fun fact: 'extern' is required because const is by default static in C++, so
 // CLSID_DxcIntelliSense is not visible externally (this is OK in C, since const
 // is not by default static in C)
@@ -10,16 +10,23 @@
 #ifndef LLVM_ANALYSIS_DXILVALUECACHE_H
 #define LLVM_ANALYSIS_DXILVALUECACHE_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/ValueMap.h"
 #include "llvm/Pass.h"
 
+#include <map>
+#include <memory>
+#include <vector>
+
 namespace llvm {
 
 class Module;
+class Function;
 class DominatorTree;
 class Constant;
 class ConstantInt;
 class PHINode;
+class raw_ostream;
 
 struct DxilValueCache : public ImmutablePass {
   static char ID;
@@ -28,14 +35,16 @@ struct DxilValueCache : public ImmutablePass {
   struct WeakValueMap {
     struct ValueVH : public CallbackVH {
       ValueVH(Value *V) : CallbackVH(V) {}
-      void allUsesReplacedWith(Value *) override { setValPtr(nullptr); }
+      WeakValueMap *Owner = nullptr;
+      void allUsesReplacedWith(Value *) override;
     };
     struct ValueEntry {
       WeakTrackingVH Value;
       ValueVH Self;
       ValueEntry() : Value(nullptr), Self(nullptr) {}
-      inline void Set(llvm::Value *Key, llvm::Value *V) {
+      inline void Set(llvm::Value *Key, llvm::Value *V, WeakValueMap *Owner) {
         Self = Key;
+        Self.Owner = Owner;
         Value = V;
       }
       inline bool IsStale() const { return Self == nullptr; }
@@ -46,17 +55,39 @@ struct DxilValueCache : public ImmutablePass {
     bool Seen(Value *v);
     void SetSentinel(Value *V);
     void ResetUnknowns();
+    void ResetUnknowns(const Function &F);
     void ResetAll();
     void dump() const;
 
   private:
     Value *GetSentinel(LLVMContext &Ctx);
+    bool IsSentinel(const Value *V) const;
+    void ResetUnknownUsers(Value *V);
     std::unique_ptr<PHINode> Sentinel;
+    // Keys set to the sentinel, by function, so that the unknowns of one
+    // function can be reset without going through the whole map. Deleted
+    // keys become null. A list is compacted whenever it doubles in size, so
+    // it stays proportional to the number of unknowns in the function.
+    struct UnknownList {
+      std::vector<WeakVH> Keys;
+      size_t CompactAt = 0;
+    };
+    DenseMap<const Function *, UnknownList> UnknownsByFunction;
+    void CompactUnknowns(UnknownList &List);
   };
 
 private:
-  WeakValueMap Map;
+  // Values computed without skipping anything.
+  WeakValueMap DefaultMap;
+  // Values computed with a skip callback installed, kept per callback since
+  // skipping changes what can be deduced.
+  std::map<bool (*)(Value *), std::unique_ptr<WeakValueMap>> SkipMaps;
+  WeakValueMap *Map = &DefaultMap;
   bool (*ShouldSkipCallback)(Value *V) = nullptr;
+  // Lookups answered from the cache and lookups that had to compute the
+  // value, reported under -ftime-report.
+  unsigned NumHits = 0;
+  unsigned NumMisses = 0;
 
   void MarkUnreachable(BasicBlock *BB);
   bool IsUnreachable_(BasicBlock *BB);
@@ -73,23 +104,30 @@ private:
 public:
   StringRef getPassName() const override;
   DxilValueCache();
+  ~DxilValueCache() override;
   void getAnalysisUsage(AnalysisUsage &) const override;
 
   void dump() const;
   Value *GetValue(Value *V, DominatorTree *DT = nullptr);
   Constant *GetConstValue(Value *V, DominatorTree *DT = nullptr);
   ConstantInt *GetConstInt(Value *V, DominatorTree *DT = nullptr);
-  void ResetUnknowns() { Map.ResetUnknowns(); }
-  void ResetAll() { Map.ResetAll(); }
+  // Unknown values are recomputed on the next query. Values that turned out
+  // constant stay cached; they are dropped when replaced or deleted.
+  void ResetUnknowns();
+  // Same as above for values in F only, for passes that changed just F.
+  void ResetUnknowns(Function &F);
+  void ResetAll();
   bool IsUnreachable(BasicBlock *BB, DominatorTree *DT = nullptr);
-  void SetShouldSkipCallback(bool (*Callback)(Value *V)) {
-    ShouldSkipCallback = Callback;
-  };
+  void SetShouldSkipCallback(bool (*Callback)(Value *V));
 };
 
 void initializeDxilValueCachePass(class llvm::PassRegistry &);
 Pass *createDxilValueCachePass();
 
+// Prints the lookups of the value caches destroyed while pass timing was
+// enabled, and resets the counts.
+void printDxilValueCacheReport(raw_ostream &OS);
+
 } // namespace llvm
 
 #endif
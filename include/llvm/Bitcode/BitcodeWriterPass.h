@@ -16,6 +16,7 @@
 #define LLVM_BITCODE_BITCODEWRITERPASS_H
 
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Bitcode/ReaderWriter.h" // HLSL Change
 
 namespace llvm {
 class Module;
@@ -31,6 +32,10 @@ class PreservedAnalyses;
 /// reproduced when deserialized.
 ModulePass *createBitcodeWriterPass(raw_ostream &Str,
                                     bool ShouldPreserveUseListOrder = false);
+// HLSL Change - Encode function blocks on worker threads.
+ModulePass *createBitcodeWriterPass(raw_ostream &Str,
+                                    bool ShouldPreserveUseListOrder,
+                                    const BitcodeWriterThreads &Threads);
 
 /// \brief Pass for writing a module of IR out to a bitcode file.
 ///
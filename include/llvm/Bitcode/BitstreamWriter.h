@@ -15,10 +15,12 @@
 #ifndef LLVM_BITCODE_BITSTREAMWRITER_H
 #define LLVM_BITCODE_BITSTREAMWRITER_H
 
+#include "llvm/ADT/ArrayRef.h" // HLSL Change
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Bitcode/BitCodes.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/ErrorHandling.h" // HLSL Change
 #include <vector>
 
 namespace llvm {
@@ -141,6 +143,21 @@ public:
     }
   }
 
+  // HLSL Change Begin
+  /// EmitAlignedWords - Append whole words encoded by another writer. Both
+  /// streams must be 32-bit aligned, and the words must have been encoded at
+  /// the current abbreviation width with the same block info. Misaligned
+  /// words would silently corrupt the stream, so this is checked in release
+  /// builds too.
+  void EmitAlignedWords(ArrayRef<char> Words) {
+    if (CurBit != 0)
+      report_fatal_error("Bitstream is not 32-bit aligned");
+    if ((Words.size() & 3) != 0)
+      report_fatal_error("Spliced bitstream is not a whole number of words");
+    Out.append(Words.begin(), Words.end());
+  }
+  // HLSL Change End
+
   void EmitVBR(uint32_t Val, unsigned NumBits) {
     assert(NumBits <= 32 && "Too many bits to emit!");
     uint32_t Threshold = 1U << (NumBits-1);
@@ -18,6 +18,7 @@
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <functional> // HLSL Change
 #include <memory>
 #include <string>
 
@@ -71,6 +72,25 @@ namespace llvm {
   void WriteBitcodeToFile(const Module *M, raw_ostream &Out,
                           bool ShouldPreserveUseListOrder = false);
 
+  // HLSL Change Begin
+  /// Settings for encoding function blocks on worker threads.
+  struct BitcodeWriterThreads {
+    /// Maximum number of threads, including the calling one. With fewer
+    /// than two, everything is written on the calling thread.
+    unsigned NumThreads = 0;
+    /// If set, each worker thread runs its work through this, so the caller
+    /// can set up per-thread state such as the allocator around it.
+    std::function<void(const std::function<void()> &)> RunOnWorker;
+  };
+
+  /// \brief Write the specified module, encoding function blocks on up to
+  /// \c Threads.NumThreads threads. The output is bit-identical to
+  /// WriteBitcodeToFile.
+  void WriteBitcodeToFile(const Module *M, raw_ostream &Out,
+                          bool ShouldPreserveUseListOrder,
+                          const BitcodeWriterThreads &Threads);
+  // HLSL Change End
+
   /// isBitcodeWrapper - Return true if the given bytes are the magic bytes
   /// for an LLVM IR bitcode wrapper.
   ///
@@ -10,6 +10,7 @@
 #ifndef LLVM_SUPPORT_TIME_PROFILER_H
 #define LLVM_SUPPORT_TIME_PROFILER_H
 
+#include "llvm/ADT/ArrayRef.h" // HLSL Change
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -21,7 +22,10 @@ extern TimeTraceProfiler *TimeTraceProfilerInstance;
 /// Initialize the time trace profiler.
 /// This sets up the global \p TimeTraceProfilerInstance
 /// variable to be the profiler instance.
-void timeTraceProfilerInitialize(unsigned TimeTraceGranularity);
+/// If \p RecordPassCosts is set, the pass managers also record instruction
+/// counts before and after each pass (HLSL Change).
+void timeTraceProfilerInitialize(unsigned TimeTraceGranularity,
+                                 bool RecordPassCosts = false);
 
 /// Cleanup the time trace profiler, if it was initialized.
 void timeTraceProfilerCleanup();
@@ -31,6 +35,11 @@ inline bool timeTraceProfilerEnabled() {
   return TimeTraceProfilerInstance != nullptr;
 }
 
+// HLSL Change Begin - Per-function pass costs.
+/// Should the pass managers record per-function pass costs?
+bool timeTraceProfilerPassCostsEnabled();
+// HLSL Change End
+
 /// Write profiling data to output file.
 /// Data produced is JSON, in Chrome "Trace Event" format, see
 /// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU/preview
@@ -47,6 +56,27 @@ void timeTraceProfilerBegin(StringRef Name,
 /// Manually end the last time section.
 void timeTraceProfilerEnd();
 
+// HLSL Change Begin - Per-function pass costs.
+/// Attach an argument to the innermost open time section. Sections with
+/// arguments, and the sections they are nested in, are written regardless of
+/// the time granularity.
+void timeTraceProfilerAddArg(StringRef Name, StringRef Value);
+void timeTraceProfilerAddArg(StringRef Name, int64_t Value);
+
+/// Instruction counts of one function around a pass.
+struct TimeTraceFunctionCost {
+  StringRef Function;
+  int64_t InstsBefore;
+  int64_t InstsAfter;
+};
+
+/// Attach an argument listing \p Costs, as an array of objects with
+/// "function", "instsBefore" and "instsAfter" members, to the innermost open
+/// time section.
+void timeTraceProfilerAddFunctionCosts(StringRef Name,
+                                       ArrayRef<TimeTraceFunctionCost> Costs);
+// HLSL Change End
+
 /// The TimeTraceScope is a helper class to call the begin and end functions
 /// of the time trace profiler.  When the object is constructed, it begins
 /// the section; and when it is destroyed, it stops it. If the time profiler
@@ -140,7 +140,11 @@ public:
   bool HLSLEnableDebugNops = false; // HLSL Change
   bool HLSLEarlyInlining = true; // HLSL Change
   bool HLSLNoSink = false; // HLSL Change
+  bool HLSLParallelLibOpt = false; // HLSL Change
+  unsigned HLSLSROAMaxAggregateLeaves = 0; // HLSL Change
+  unsigned HLSLSROAMemoryBudgetKB = 0; // HLSL Change
   void addHLSLPasses(legacy::PassManagerBase &MPM); // HLSL Change
+  void addHLSLScalarOptPasses(legacy::PassManagerBase &MPM); // HLSL Change
 
 private:
   /// ExtensionList - This is list of all of the extensions that are registered.
@@ -170,6 +174,12 @@ public:
 
   /// populateModulePassManager - This sets up the primary pass manager.
   void populateModulePassManager(legacy::PassManagerBase &MPM);
+  // HLSL Change Begin
+  /// populateHLSLScalarOptPassManager - This sets up a standalone pass manager
+  /// that runs only the function-level scalar optimizations of the module
+  /// pipeline, for modules optimized outside of it.
+  void populateHLSLScalarOptPassManager(legacy::PassManagerBase &PM);
+  // HLSL Change End
   void populateLTOPassManager(legacy::PassManagerBase &PM);
 };
 
@@ -116,7 +116,8 @@ void initializeHLExpandStoreIntrinsicsPass(PassRegistry&);
 // ScalarReplAggregatesHLSL - Break up argument's of aggregates into multiple arguments
 // for hlsl. Array will not change, all structures will be broken up.
 //
-ModulePass *createSROA_Parameter_HLSL();
+ModulePass *createSROA_Parameter_HLSL(unsigned MaxAggregateLeaves = 0,
+                                      unsigned MemoryBudgetKB = 0);
 void initializeSROA_Parameter_HLSLPass(PassRegistry&);
 
 //===----------------------------------------------------------------------===//
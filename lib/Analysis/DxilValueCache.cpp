@@ -12,7 +12,7 @@
 
 #include "dxc/DXIL/DxilConstants.h"
 #include "dxc/Support/Global.h"
-#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/DxilSimplify.h"
 #include "llvm/Analysis/InstructionSimplify.h"
@@ -26,10 +26,14 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Scalar.h"
 
 #include "llvm/Analysis/DxilValueCache.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -37,6 +41,17 @@
 
 using namespace llvm;
 
+namespace {
+struct ValueCacheReport {
+  sys::SmartMutex<true> Lock;
+  uint64_t Hits = 0;
+  uint64_t Misses = 0;
+  bool Recorded = false;
+};
+} // namespace
+
+static ManagedStatic<ValueCacheReport> TheValueCacheReport;
+
 static bool IsConstantTrue(const Value *V) {
   if (const ConstantInt *C = dyn_cast<ConstantInt>(V))
     return C->getLimitedValue() != 0;
@@ -53,7 +68,7 @@ static bool IsEntryBlock(const BasicBlock *BB) {
 }
 
 void DxilValueCache::MarkUnreachable(BasicBlock *BB) {
-  Map.Set(BB, ConstantInt::get(Type::getInt1Ty(BB->getContext()), 0));
+  Map->Set(BB, ConstantInt::get(Type::getInt1Ty(BB->getContext()), 0));
 }
 
 bool DxilValueCache::MayBranchTo(BasicBlock *A, BasicBlock *B) {
@@ -90,7 +105,7 @@ bool DxilValueCache::MayBranchTo(BasicBlock *A, BasicBlock *B) {
 }
 
 bool DxilValueCache::IsUnreachable_(BasicBlock *BB) {
-  if (Value *V = Map.Get(BB))
+  if (Value *V = Map->Get(BB))
     if (IsConstantFalse(V))
       return true;
   return false;
@@ -150,7 +165,7 @@ Value *DxilValueCache::ProcessAndSimplify_PHI(Instruction *I,
   // value that were computed previously.
   if (!Simplified) {
     if (SimplifiedNotDominating)
-      if (Value *CachedV = Map.Get(SimplifiedNotDominating))
+      if (Value *CachedV = Map->Get(SimplifiedNotDominating))
         Simplified = CachedV;
   }
 
@@ -344,7 +359,7 @@ Value *DxilValueCache::SimplifyAndCacheResult(Instruction *I,
   }
 
   if (Simplified && isa<Constant>(Simplified))
-    Map.Set(I, Simplified);
+    Map->Set(I, Simplified);
 
   return Simplified;
 }
@@ -376,8 +391,38 @@ Value *DxilValueCache::WeakValueMap::Get(Value *V) {
   return Result;
 }
 
+static const Function *GetParentFunction(const Value *V) {
+  const BasicBlock *BB = dyn_cast<BasicBlock>(V);
+  if (const Instruction *I = dyn_cast<Instruction>(V))
+    BB = I->getParent();
+  return BB ? BB->getParent() : nullptr;
+}
+
 void DxilValueCache::WeakValueMap::SetSentinel(Value *Key) {
-  Map[Key].Set(Key, GetSentinel(Key->getContext()));
+  Map[Key].Set(Key, GetSentinel(Key->getContext()), this);
+  UnknownList &List = UnknownsByFunction[GetParentFunction(Key)];
+  List.Keys.emplace_back(Key);
+  if (List.Keys.size() > List.CompactAt)
+    CompactUnknowns(List);
+}
+
+// Drops keys that were deleted, are no longer unknown, or are listed twice.
+void DxilValueCache::WeakValueMap::CompactUnknowns(UnknownList &List) {
+  SmallPtrSet<const Value *, 16> Kept;
+  auto IsObsolete = [&](const WeakVH &Key) {
+    if (!Key || !Kept.insert(Key).second)
+      return true;
+    auto FindIt = Map.find(Key);
+    return FindIt == Map.end() || !IsSentinel(FindIt->second.Value);
+  };
+  List.Keys.erase(
+      std::remove_if(List.Keys.begin(), List.Keys.end(), IsObsolete),
+      List.Keys.end());
+  List.CompactAt = std::max<size_t>(16, 2 * List.Keys.size());
+}
+
+bool DxilValueCache::WeakValueMap::IsSentinel(const Value *V) const {
+  return Sentinel && V == Sentinel.get();
 }
 
 Value *DxilValueCache::WeakValueMap::GetSentinel(LLVMContext &Ctx) {
@@ -387,7 +432,10 @@ Value *DxilValueCache::WeakValueMap::GetSentinel(LLVMContext &Ctx) {
   return Sentinel.get();
 }
 
-void DxilValueCache::WeakValueMap::ResetAll() { Map.clear(); }
+void DxilValueCache::WeakValueMap::ResetAll() {
+  Map.clear();
+  UnknownsByFunction.clear();
+}
 
 void DxilValueCache::WeakValueMap::ResetUnknowns() {
   if (!Sentinel)
@@ -395,10 +443,27 @@ void DxilValueCache::WeakValueMap::ResetUnknowns() {
 
   for (auto it = Map.begin(); it != Map.end();) {
     auto nextIt = std::next(it);
-    if (it->second.Value == Sentinel.get())
+    if (IsSentinel(it->second.Value))
       Map.erase(it);
     it = nextIt;
   }
+  UnknownsByFunction.clear();
+}
+
+void DxilValueCache::WeakValueMap::ResetUnknowns(const Function &F) {
+  for (const Function *Parent : {&F, (const Function *)nullptr}) {
+    auto FindIt = UnknownsByFunction.find(Parent);
+    if (FindIt == UnknownsByFunction.end())
+      continue;
+    for (const WeakVH &Key : FindIt->second.Keys) {
+      if (!Key)
+        continue;
+      auto MapIt = Map.find(Key);
+      if (MapIt != Map.end() && IsSentinel(MapIt->second.Value))
+        Map.erase(MapIt);
+    }
+    UnknownsByFunction.erase(FindIt);
+  }
 }
 
 LLVM_DUMP_METHOD
@@ -458,13 +523,40 @@ void DxilValueCache::WeakValueMap::dump() const {
 }
 
 void DxilValueCache::WeakValueMap::Set(Value *Key, Value *V) {
-  Map[Key].Set(Key, V);
+  Map[Key].Set(Key, V, this);
+}
+
+// A value whose uses were replaced may make its users deducible. Forget the
+// users that are still unknown, and in turn their unknown users.
+void DxilValueCache::WeakValueMap::ValueVH::allUsesReplacedWith(Value *) {
+  Value *Old = getValPtr();
+  setValPtr(nullptr);
+  if (Owner && Old)
+    Owner->ResetUnknownUsers(Old);
+}
+
+void DxilValueCache::WeakValueMap::ResetUnknownUsers(Value *V) {
+  if (!Sentinel)
+    return;
+
+  SmallVector<Value *, 16> WorkList(V->user_begin(), V->user_end());
+  while (!WorkList.empty()) {
+    Value *U = WorkList.pop_back_val();
+    // The entry of V itself is still being updated for the replacement.
+    if (U == V)
+      continue;
+    auto FindIt = Map.find(U);
+    if (FindIt == Map.end() || !IsSentinel(FindIt->second.Value))
+      continue;
+    Map.erase(FindIt);
+    WorkList.append(U->user_begin(), U->user_end());
+  }
 }
 
 // If there's a cached value, return it. Otherwise, return
 // the value itself.
 Value *DxilValueCache::TryGetCachedValue(Value *V) {
-  if (Value *Simplified = Map.Get(V))
+  if (Value *Simplified = Map->Get(V))
     return Simplified;
   return V;
 }
@@ -473,14 +565,46 @@ DxilValueCache::DxilValueCache() : ImmutablePass(ID) {
   initializeDxilValueCachePass(*PassRegistry::getPassRegistry());
 }
 
+DxilValueCache::~DxilValueCache() {
+  if (!TimePassesIsEnabled)
+    return;
+  ValueCacheReport &Report = *TheValueCacheReport;
+  sys::SmartScopedLock<true> Guard(Report.Lock);
+  Report.Hits += NumHits;
+  Report.Misses += NumMisses;
+  Report.Recorded = true;
+}
+
+void llvm::printDxilValueCacheReport(raw_ostream &OS) {
+  ValueCacheReport &Report = *TheValueCacheReport;
+  sys::SmartScopedLock<true> Guard(Report.Lock);
+  if (!Report.Recorded)
+    return;
+
+  // Same header as the timer groups printed alongside it.
+  StringRef Name = "DXIL Value Cache";
+  OS << "===" << std::string(73, '-') << "===\n";
+  OS.indent((80 - Name.size()) / 2) << Name << '\n';
+  OS << "===" << std::string(73, '-') << "===\n";
+  OS << "  Value lookups: " << Report.Hits << " hits, " << Report.Misses
+     << " misses\n\n";
+
+  Report.Hits = 0;
+  Report.Misses = 0;
+  Report.Recorded = false;
+}
+
 StringRef DxilValueCache::getPassName() const { return "Dxil Value Cache"; }
 
 Value *DxilValueCache::GetValue(Value *V, DominatorTree *DT) {
   if (dyn_cast<Constant>(V))
     return V;
-  if (Value *NewV = Map.Get(V))
+  if (Value *NewV = Map->Get(V)) {
+    NumHits++;
     return NewV;
+  }
 
+  NumMisses++;
   return ProcessValue(V, DT);
 }
 
@@ -501,8 +625,38 @@ bool DxilValueCache::IsUnreachable(BasicBlock *BB, DominatorTree *DT) {
   return IsUnreachable_(BB);
 }
 
+void DxilValueCache::ResetUnknowns() {
+  DefaultMap.ResetUnknowns();
+  for (auto &It : SkipMaps)
+    It.second->ResetUnknowns();
+}
+
+void DxilValueCache::ResetUnknowns(Function &F) {
+  DefaultMap.ResetUnknowns(F);
+  for (auto &It : SkipMaps)
+    It.second->ResetUnknowns(F);
+}
+
+void DxilValueCache::ResetAll() {
+  DefaultMap.ResetAll();
+  for (auto &It : SkipMaps)
+    It.second->ResetAll();
+}
+
+void DxilValueCache::SetShouldSkipCallback(bool (*Callback)(Value *V)) {
+  ShouldSkipCallback = Callback;
+  if (!Callback) {
+    Map = &DefaultMap;
+    return;
+  }
+  std::unique_ptr<WeakValueMap> &SkipMap = SkipMaps[Callback];
+  if (!SkipMap)
+    SkipMap.reset(new WeakValueMap());
+  Map = SkipMap.get();
+}
+
 LLVM_DUMP_METHOD
-void DxilValueCache::dump() const { Map.dump(); }
+void DxilValueCache::dump() const { Map->dump(); }
 
 void DxilValueCache::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.setPreservesAll();
@@ -537,15 +691,15 @@ Value *DxilValueCache::ProcessValue(Value *NewV, DominatorTree *DT) {
 
     // If we haven't seen this value, go in and push things it depends on
     // into the worklist.
-    if (!Map.Seen(V)) {
-      Map.SetSentinel(V);
+    if (!Map->Seen(V)) {
+      Map->SetSentinel(V);
       if (Instruction *I = dyn_cast<Instruction>(V)) {
 
         for (Use &U : I->operands()) {
           Instruction *UseI = dyn_cast<Instruction>(U.get());
           if (!UseI)
             continue;
-          if (!Map.Seen(UseI))
+          if (!Map->Seen(UseI))
             WorkList.push_back(UseI);
         }
 
@@ -553,9 +707,9 @@ Value *DxilValueCache::ProcessValue(Value *NewV, DominatorTree *DT) {
           for (unsigned i = 0; i < PN->getNumIncomingValues(); i++) {
             BasicBlock *BB = PN->getIncomingBlock(i);
             TerminatorInst *Term = BB->getTerminator();
-            if (!Map.Seen(Term))
+            if (!Map->Seen(Term))
               WorkList.push_back(Term);
-            if (!Map.Seen(BB))
+            if (!Map->Seen(BB))
               WorkList.push_back(BB);
           }
         }
@@ -564,9 +718,9 @@ Value *DxilValueCache::ProcessValue(Value *NewV, DominatorTree *DT) {
              PI++) {
           BasicBlock *PredBB = *PI;
           TerminatorInst *Term = PredBB->getTerminator();
-          if (!Map.Seen(Term))
+          if (!Map->Seen(Term))
             WorkList.push_back(Term);
-          if (!Map.Seen(PredBB))
+          if (!Map->Seen(PredBB))
             WorkList.push_back(PredBB);
         }
       }
@@ -31,7 +31,9 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cctype>
+#include <exception> // HLSL Change
 #include <map>
+#include <thread> // HLSL Change
 using namespace llvm;
 
 /// These are manifest constants used by the bitcode writer. They do not need to
@@ -2366,9 +2368,134 @@ static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
+// HLSL Change Begin - Parallel function block encoding.
+namespace {
+/// A contiguous run of function bodies, encoded into a buffer of its own.
+struct FunctionChunk {
+  std::vector<const Function *> Functions;
+  UseListOrderStack UseListOrders;
+  SmallVector<char, 0> Buffer;
+  size_t Begin = 0;
+  size_t End = 0;
+  std::exception_ptr Error;
+};
+} // namespace
+
+/// WriteFunctionChunk - Encode the function blocks of Chunk. The private
+/// stream is put in the state the module stream is in when function blocks
+/// start: inside the module block, with the same block info, word aligned.
+/// Function blocks only depend on that state and on the enumerator, so the
+/// encoded words can be spliced into the module stream as they are.
+static void WriteFunctionChunk(const ValueEnumerator &VE,
+                               FunctionChunk &Chunk) {
+  try {
+    std::unique_ptr<ValueEnumerator> ChunkVE = VE.cloneModuleState();
+    ChunkVE->UseListOrders = std::move(Chunk.UseListOrders);
+    BitstreamWriter Stream(Chunk.Buffer);
+    Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+    WriteBlockInfo(*ChunkVE, Stream);
+    Chunk.Begin = Chunk.Buffer.size();
+    for (const Function *F : Chunk.Functions)
+      WriteFunction(*F, *ChunkVE, Stream);
+    Chunk.End = Chunk.Buffer.size();
+    Stream.ExitBlock();
+  } catch (...) {
+    Chunk.Error = std::current_exception();
+  }
+}
+
+static uint64_t GetFunctionSize(const Function &F) {
+  uint64_t Size = 0;
+  for (const BasicBlock &BB : F)
+    Size += BB.size();
+  return Size;
+}
+
+/// WriteFunctionsInParallel - Emit the function bodies of M, encoding runs
+/// of them on worker threads. Returns false, without writing anything, if
+/// there is too little to split.
+static bool WriteFunctionsInParallel(const Module *M, ValueEnumerator &VE,
+                                     BitstreamWriter &Stream,
+                                     const BitcodeWriterThreads &Threads) {
+  if (Threads.NumThreads < 2)
+    return false;
+
+  std::vector<const Function *> Bodies;
+  uint64_t TotalSize = 0;
+  for (const Function &F : *M) {
+    if (F.isDeclaration())
+      continue;
+    Bodies.push_back(&F);
+    TotalSize += GetFunctionSize(F);
+  }
+  unsigned NumChunks =
+      std::min<size_t>(Threads.NumThreads, Bodies.size());
+  if (NumChunks < 2)
+    return false;
+
+  // Split the bodies, in module order, into chunks of similar size.
+  std::vector<FunctionChunk> Chunks(NumChunks);
+  DenseMap<const Function *, unsigned> ChunkOf;
+  uint64_t TargetSize = (TotalSize + NumChunks - 1) / NumChunks;
+  uint64_t ChunkSize = 0;
+  unsigned Cur = 0;
+  for (const Function *F : Bodies) {
+    if (ChunkSize >= TargetSize && Cur + 1 < NumChunks) {
+      ++Cur;
+      ChunkSize = 0;
+    }
+    Chunks[Cur].Functions.push_back(F);
+    ChunkOf[F] = Cur;
+    ChunkSize += GetFunctionSize(*F);
+  }
+
+  // The module-level use-list orders have been written already. The rest is
+  // a stack with the first function's entries on top; give every chunk its
+  // own entries, in the same relative order.
+  for (UseListOrder &Order : VE.UseListOrders) {
+    assert(Order.F && "module-level use-list order left");
+    Chunks[ChunkOf[Order.F]].UseListOrders.push_back(std::move(Order));
+  }
+  VE.UseListOrders.clear();
+
+  // The first chunk is encoded on this thread.
+  std::vector<std::thread> Workers;
+  std::vector<FunctionChunk *> Unstarted;
+  for (unsigned I = 1; I != NumChunks; ++I) {
+    FunctionChunk *Chunk = &Chunks[I];
+    if (Chunk->Functions.empty())
+      continue;
+    try {
+      Workers.emplace_back([&VE, Chunk, &Threads]() {
+        if (Threads.RunOnWorker)
+          Threads.RunOnWorker([&]() { WriteFunctionChunk(VE, *Chunk); });
+        else
+          WriteFunctionChunk(VE, *Chunk);
+      });
+    } catch (...) {
+      Unstarted.push_back(Chunk);
+    }
+  }
+  WriteFunctionChunk(VE, Chunks[0]);
+  for (FunctionChunk *Chunk : Unstarted)
+    WriteFunctionChunk(VE, *Chunk);
+  for (std::thread &Worker : Workers)
+    Worker.join();
+
+  for (FunctionChunk &Chunk : Chunks) {
+    if (Chunk.Error)
+      std::rethrow_exception(Chunk.Error);
+    Stream.EmitAlignedWords(makeArrayRef(Chunk.Buffer.data() + Chunk.Begin,
+                                         Chunk.End - Chunk.Begin));
+  }
+  return true;
+}
+// HLSL Change End
+
 /// WriteModule - Emit the specified module to the bitstream.
 static void WriteModule(const Module *M, BitstreamWriter &Stream,
-                        bool ShouldPreserveUseListOrder) {
+                        bool ShouldPreserveUseListOrder,
+                        const BitcodeWriterThreads &Threads) { // HLSL Change
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
 
   SmallVector<unsigned, 1> Vals;
@@ -2414,9 +2541,11 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream,
     WriteUseListBlock(nullptr, VE, Stream);
 
   // Emit function bodies.
-  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream);
+  if (!WriteFunctionsInParallel(M, VE, Stream, Threads)) { // HLSL Change
+    for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+      if (!F->isDeclaration())
+        WriteFunction(*F, VE, Stream);
+  } // HLSL Change
 
   Stream.ExitBlock();
 }
@@ -2495,6 +2624,15 @@ static void EmitDarwinBCHeaderAndTrailer(SmallVectorImpl<char> &Buffer,
 /// stream.
 void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
                               bool ShouldPreserveUseListOrder) {
+  // HLSL Change Begin
+  WriteBitcodeToFile(M, Out, ShouldPreserveUseListOrder,
+                     BitcodeWriterThreads());
+}
+
+void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
+                              bool ShouldPreserveUseListOrder,
+                              const BitcodeWriterThreads &Threads) {
+  // HLSL Change End
   SmallVector<char, 0> Buffer;
   Buffer.reserve(256*1024);
 
@@ -2517,7 +2655,7 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
     Stream.Emit(0xD, 4);
 
     // Emit the module.
-    WriteModule(M, Stream, ShouldPreserveUseListOrder);
+    WriteModule(M, Stream, ShouldPreserveUseListOrder, Threads); // HLSL Change
   }
 
   if (TT.isOSDarwin())
@@ -27,17 +27,20 @@ namespace {
   class WriteBitcodePass : public ModulePass {
     raw_ostream &OS; // raw_ostream to print on
     bool ShouldPreserveUseListOrder;
+    BitcodeWriterThreads Threads; // HLSL Change
 
   public:
     static char ID; // Pass identification, replacement for typeid
-    explicit WriteBitcodePass(raw_ostream &o, bool ShouldPreserveUseListOrder)
+    explicit WriteBitcodePass(raw_ostream &o, bool ShouldPreserveUseListOrder,
+                              const BitcodeWriterThreads &Threads) // HLSL Change
         : ModulePass(ID), OS(o),
-          ShouldPreserveUseListOrder(ShouldPreserveUseListOrder) {}
+          ShouldPreserveUseListOrder(ShouldPreserveUseListOrder),
+          Threads(Threads) {} // HLSL Change
 
     StringRef getPassName() const override { return "Bitcode Writer"; }
 
     bool runOnModule(Module &M) override {
-      WriteBitcodeToFile(&M, OS, ShouldPreserveUseListOrder);
+      WriteBitcodeToFile(&M, OS, ShouldPreserveUseListOrder, Threads); // HLSL Change
       return false;
     }
   };
@@ -47,5 +50,14 @@ char WriteBitcodePass::ID = 0;
 
 ModulePass *llvm::createBitcodeWriterPass(raw_ostream &Str,
                                           bool ShouldPreserveUseListOrder) {
-  return new WriteBitcodePass(Str, ShouldPreserveUseListOrder);
+  return new WriteBitcodePass(Str, ShouldPreserveUseListOrder,
+                              BitcodeWriterThreads()); // HLSL Change
 }
+
+// HLSL Change Begin
+ModulePass *llvm::createBitcodeWriterPass(raw_ostream &Str,
+                                          bool ShouldPreserveUseListOrder,
+                                          const BitcodeWriterThreads &Threads) {
+  return new WriteBitcodePass(Str, ShouldPreserveUseListOrder, Threads);
+}
+// HLSL Change End
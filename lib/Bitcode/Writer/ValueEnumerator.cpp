@@ -397,6 +397,27 @@ ValueEnumerator::ValueEnumerator(const Module &M,
   OptimizeConstants(FirstConstant, Values.size());
 }
 
+// HLSL Change Begin
+ValueEnumerator::ValueEnumerator(const ValueEnumerator &VE, CloneTag)
+    : TypeMap(VE.TypeMap), Types(VE.Types), ValueMap(VE.ValueMap),
+      Values(VE.Values), Comdats(VE.Comdats), MDs(VE.MDs),
+      MDValueMap(VE.MDValueMap), HasMDString(VE.HasMDString),
+      HasDILocation(VE.HasDILocation), HasGenericDINode(VE.HasGenericDINode),
+      ShouldPreserveUseListOrder(VE.ShouldPreserveUseListOrder),
+      AttributeGroupMap(VE.AttributeGroupMap),
+      AttributeGroups(VE.AttributeGroups), AttributeMap(VE.AttributeMap),
+      Attribute(VE.Attribute), InstructionCount(0), NumModuleValues(0),
+      NumModuleMDs(0), FirstFuncConstantID(0), FirstInstID(0) {
+  assert(VE.BasicBlocks.empty() && VE.FunctionLocalMDs.empty() &&
+         "cannot clone while a function is incorporated");
+}
+
+std::unique_ptr<ValueEnumerator> ValueEnumerator::cloneModuleState() const {
+  return std::unique_ptr<ValueEnumerator>(
+      new ValueEnumerator(*this, CloneTag()));
+}
+// HLSL Change End
+
 unsigned ValueEnumerator::getInstructionID(const Instruction *Inst) const {
   InstructionMapType::const_iterator I = InstructionMap.find(Inst);
   assert(I != InstructionMap.end() && "Instruction is not mapped!");
@@ -19,6 +19,7 @@
 #include "llvm/ADT/UniqueVector.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/UseListOrder.h"
+#include <memory> // HLSL Change
 #include <vector>
 
 namespace llvm {
@@ -102,9 +103,20 @@ private:
 
   ValueEnumerator(const ValueEnumerator &) = delete;
   void operator=(const ValueEnumerator &) = delete;
+  // HLSL Change Begin
+  struct CloneTag {};
+  ValueEnumerator(const ValueEnumerator &VE, CloneTag);
+  // HLSL Change End
 public:
   ValueEnumerator(const Module &M, bool ShouldPreserveUseListOrder);
 
+  // HLSL Change Begin
+  /// cloneModuleState - Copy the module-level numbering so that function
+  /// blocks can be written with an independent enumerator. Use-list orders
+  /// are not copied. Must not be called while a function is incorporated.
+  std::unique_ptr<ValueEnumerator> cloneModuleState() const;
+  // HLSL Change End
+
   void dump() const;
   void print(raw_ostream &OS, const ValueMapType &Map, const char *Name) const;
   void print(raw_ostream &OS, const MetadataMapType &Map,
@@ -90,6 +90,7 @@ const char *kWaveOpsIncludeHelperLanesString = "waveops-include-helper-lanes";
 
 void SetDxilHook(Module &M);
 void ClearDxilHook(Module &M);
+void DxilModule_RemoveGlobal(llvm::Module *M, llvm::GlobalObject *G);
 
 //------------------------------------------------------------------------------
 //
@@ -979,6 +980,7 @@ static void ConvertUsedResource(std::unordered_set<unsigned> &immResID,
 void DxilModule::RemoveFunction(llvm::Function *F) {
   DXASSERT_NOMSG(F != nullptr);
   m_DxilEntryPropsMap.erase(F);
+  LoadPendingTypeSystem();
   if (m_pTypeSystem.get()->GetFunctionAnnotation(F))
     m_pTypeSystem.get()->EraseFunctionAnnotation(F);
   m_pOP->RemoveFunction(F);
@@ -1364,18 +1366,26 @@ bool DxilModule::StripRootSignatureFromMetadata() {
   return false;
 }
 
-DxilSubobjects *DxilModule::GetSubobjects() { return m_pSubobjects.get(); }
+DxilSubobjects *DxilModule::GetSubobjects() {
+  LoadPendingSubobjects();
+  return m_pSubobjects.get();
+}
 const DxilSubobjects *DxilModule::GetSubobjects() const {
+  LoadPendingSubobjects();
   return m_pSubobjects.get();
 }
 DxilSubobjects *DxilModule::ReleaseSubobjects() {
+  LoadPendingSubobjects();
   return m_pSubobjects.release();
 }
 void DxilModule::ResetSubobjects(DxilSubobjects *subobjects) {
+  m_bSubobjectsPending = false;
   m_pSubobjects.reset(subobjects);
 }
 
 bool DxilModule::StripSubobjectsFromMetadata() {
+  // Subobjects stay available in memory after the metadata is gone.
+  LoadPendingSubobjects();
   NamedMDNode *pSubobjectsNamedMD =
       GetModule()->getNamedMetadata(DxilMDHelper::kDxilSubobjectsMDName);
   if (pSubobjectsNamedMD) {
@@ -1393,9 +1403,13 @@ void DxilModule::ResetSerializedRootSignature(std::vector<uint8_t> &Value) {
   m_SerializedRootSignature.assign(Value.begin(), Value.end());
 }
 
-DxilTypeSystem &DxilModule::GetTypeSystem() { return *m_pTypeSystem; }
+DxilTypeSystem &DxilModule::GetTypeSystem() {
+  LoadPendingTypeSystem();
+  return *m_pTypeSystem;
+}
 
 const DxilTypeSystem &DxilModule::GetTypeSystem() const {
+  LoadPendingTypeSystem();
   return *m_pTypeSystem;
 }
 
@@ -1407,6 +1421,7 @@ const std::vector<unsigned> &DxilModule::GetSerializedViewIdState() const {
 }
 
 void DxilModule::ResetTypeSystem(DxilTypeSystem *pValue) {
+  m_bTypeSystemPending = false;
   m_pTypeSystem.reset(pValue);
 }
 
@@ -1476,6 +1491,9 @@ void DxilModule::ClearDxilMetadata(Module &M) {
   // root signature, function properties.
   // Other cases for libs pending.
   // LLVM used is a global variable - handle separately.
+  // Anything still deferred must be parsed before its metadata goes away.
+  if (M.HasDxilModule())
+    M.GetDxilModule().LoadPendingDxilMetadata();
   SmallVector<NamedMDNode *, 8> nodes;
   for (NamedMDNode &b : M.named_metadata()) {
     StringRef name = b.getName();
@@ -1500,6 +1518,7 @@ void DxilModule::ClearDxilMetadata(Module &M) {
 }
 
 void DxilModule::EmitDxilMetadata() {
+  LoadPendingDxilMetadata();
   m_pMDHelper->EmitDxilVersion(m_DxilMajor, m_DxilMinor);
   m_pMDHelper->EmitValidatorVersion(m_ValMajor, m_ValMinor);
   m_pMDHelper->EmitDxilShaderModel(m_pSM);
@@ -1591,7 +1610,11 @@ bool DxilModule::IsKnownNamedMetaData(llvm::NamedMDNode &Node) {
   return DxilMDHelper::IsKnownNamedMetaData(Node);
 }
 
-bool DxilModule::HasMetadataErrors() { return m_bMetadataErrors; }
+bool DxilModule::HasMetadataErrors() {
+  // Deferred categories may still report errors.
+  LoadPendingDxilMetadata();
+  return m_bMetadataErrors;
+}
 
 void DxilModule::LoadDxilMetadata() {
   m_bMetadataErrors = false;
@@ -1666,12 +1689,8 @@ void DxilModule::LoadDxilMetadata() {
       m_DxilEntryPropsMap[pFunc] = std::move(pEntryProps);
     }
 
-    // Load Subobjects
-    std::unique_ptr<DxilSubobjects> pSubobjects(new DxilSubobjects());
-    m_pMDHelper->LoadSubobjects(*pSubobjects);
-    if (pSubobjects->GetSubobjects().size()) {
-      ResetSubobjects(pSubobjects.release());
-    }
+    // Subobjects are loaded on first access.
+    m_bSubobjectsPending = true;
   } else {
     std::unique_ptr<DxilEntryProps> pEntryProps =
         make_unique<DxilEntryProps>(entryFuncProps, m_bUseMinPrecision);
@@ -1688,14 +1707,41 @@ void DxilModule::LoadDxilMetadata() {
 
   LoadDxilResources(*pEntryResources);
 
-  // Type system is not required for consumption of dxil.
+  // Type annotations are by far the largest part of library metadata and are
+  // not needed by reflection or hashing, so they are loaded on first access.
+  m_bTypeSystemPending = true;
+
+  m_pMDHelper->LoadRootSignature(m_SerializedRootSignature);
+
+  m_pMDHelper->LoadDxilViewIdState(m_SerializedState);
+
+  // The deferred loaders update this again, since they can also find extra
+  // metadata.
+  m_bMetadataErrors |= m_pMDHelper->HasExtraMetadata();
+}
+
+void DxilModule::LoadPendingDxilMetadata() {
+  LoadPendingTypeSystem();
+  LoadPendingSubobjects();
+}
+
+void DxilModule::LoadPendingTypeSystem() const {
+  if (!m_bTypeSystemPending.load(std::memory_order_acquire))
+    return;
+  std::lock_guard<std::mutex> Lock(m_PendingMetadataLock);
+  if (!m_bTypeSystemPending.load(std::memory_order_relaxed))
+    return;
+  // Annotations of functions erased without the hook would be stale.
+  DXASSERT(m_pModule->pfnRemoveGlobal == &DxilModule_RemoveGlobal,
+           "otherwise functions may have been erased without RemoveFunction");
+
+  // Type system is not required for consumption of dxil. This runs from
+  // whichever accessor comes first, so errors are only recorded for the
+  // validator rather than thrown into the caller.
   try {
     m_pMDHelper->LoadDxilTypeSystem(*m_pTypeSystem.get());
   } catch (hlsl::Exception &) {
     m_bMetadataErrors = true;
-#ifndef NDEBUG
-    throw;
-#endif
     m_pTypeSystem->GetStructAnnotationMap().clear();
     m_pTypeSystem->GetFunctionAnnotationMap().clear();
   }
@@ -1705,17 +1751,32 @@ void DxilModule::LoadDxilMetadata() {
     m_pMDHelper->LoadDxrPayloadAnnotations(*m_pTypeSystem.get());
   } catch (hlsl::Exception &) {
     m_bMetadataErrors = true;
-#ifndef NDEBUG
-    throw;
-#endif
     m_pTypeSystem->GetPayloadAnnotationMap().clear();
   }
 
-  m_pMDHelper->LoadRootSignature(m_SerializedRootSignature);
+  m_bMetadataErrors |= m_pMDHelper->HasExtraMetadata();
+  m_bTypeSystemPending.store(false, std::memory_order_release);
+}
 
-  m_pMDHelper->LoadDxilViewIdState(m_SerializedState);
+void DxilModule::LoadPendingSubobjects() const {
+  if (!m_bSubobjectsPending.load(std::memory_order_acquire))
+    return;
+  std::lock_guard<std::mutex> Lock(m_PendingMetadataLock);
+  if (!m_bSubobjectsPending.load(std::memory_order_relaxed))
+    return;
+
+  std::unique_ptr<DxilSubobjects> pSubobjects(new DxilSubobjects());
+  try {
+    m_pMDHelper->LoadSubobjects(*pSubobjects);
+    if (pSubobjects->GetSubobjects().size()) {
+      m_pSubobjects = std::move(pSubobjects);
+    }
+  } catch (hlsl::Exception &) {
+    m_bMetadataErrors = true;
+  }
 
   m_bMetadataErrors |= m_pMDHelper->HasExtraMetadata();
+  m_bSubobjectsPending.store(false, std::memory_order_release);
 }
 
 MDTuple *DxilModule::EmitDxilResources() {
@@ -1826,6 +1887,7 @@ ResourceTypeRequiresTranslation(const StructType *Ty,
 }
 
 bool DxilModule::StripReflection() {
+  LoadPendingTypeSystem();
   bool bChanged = false;
   bool bIsLib = GetShaderModel()->IsLib();
 
@@ -1950,6 +2012,7 @@ static void RemoveUsedTypesFromSet(std::vector<std::unique_ptr<TResource>> &vec,
 }
 
 void DxilModule::RemoveUnusedTypeAnnotations() {
+  LoadPendingTypeSystem();
   // Collect annotated types
   const DxilTypeSystem::StructAnnotationMap &SAMap =
       m_pTypeSystem->GetStructAnnotationMap();
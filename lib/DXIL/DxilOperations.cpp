@@ -4088,7 +4088,6 @@ OP::OP(LLVMContext &Ctx, Module *pModule)
       m_LowPrecisionMode(DXIL::LowPrecisionMode::Undefined) {
   memset(m_pResRetType, 0, sizeof(m_pResRetType));
   memset(m_pCBufferRetType, 0, sizeof(m_pCBufferRetType));
-  memset(m_OpCodeClassCache, 0, sizeof(m_OpCodeClassCache));
 
   m_pHandleType = GetOrCreateStructType(m_Ctx, Type::getInt8PtrTy(m_Ctx),
                                         "dx.types.Handle", pModule);
@@ -4151,6 +4150,8 @@ OP::OP(LLVMContext &Ctx, Module *pModule)
 
 void OP::RefreshCache() {
   for (Function &F : m_pModule->functions()) {
+    if (m_FunctionToOpClass.count(&F))
+      continue;
     if (OP::IsDxilOpFunc(&F) && !F.user_empty()) {
       CallInst *CI = cast<CallInst>(*F.user_begin());
       OpCode OpCode = OP::GetDxilOpFuncCallInst(CI);
@@ -4186,8 +4187,29 @@ void OP::FixOverloadNames() {
   }
 }
 
+void OP::AddToCache(OpCode opCode, llvm::Function *F) {
+  if (m_FunctionToOpClass.count(F))
+    return;
+  UpdateCache(GetOpCodeClass(opCode), GetOverloadType(opCode, F), F);
+}
+
 void OP::UpdateCache(OpCodeClass opClass, Type *Ty, llvm::Function *F) {
-  m_OpCodeClassCache[(unsigned)opClass].pOverloads[Ty] = F;
+  auto Inserted =
+      m_OverloadCache.insert({std::make_pair((unsigned)opClass, Ty), F});
+  if (Inserted.second) {
+    m_OpCodeClassCache[(unsigned)opClass].pOverloads.emplace_back(Ty, F);
+  } else if (Inserted.first->second != F) {
+    // Replace the stale entry for this overload rather than adding a second
+    // one for the same type.
+    m_FunctionToOpClass.erase(Inserted.first->second);
+    Inserted.first->second = F;
+    for (auto &Overload : m_OpCodeClassCache[(unsigned)opClass].pOverloads) {
+      if (Overload.first == Ty) {
+        Overload.second = F;
+        break;
+      }
+    }
+  }
   m_FunctionToOpClass[F] = opClass;
 }
 
@@ -4246,12 +4268,10 @@ Function *OP::GetOpFunc(OpCode opCode, Type *pOverloadType) {
   // but these will be caught by the validator, and this is not a regression.
 
   OpCodeClass opClass = OpProps.opCodeClass;
-  Function *&F =
-      m_OpCodeClassCache[(unsigned)opClass].pOverloads[pOverloadType];
-  if (F != nullptr) {
-    UpdateCache(opClass, pOverloadType, F);
-    return F;
-  }
+  auto CacheIt =
+      m_OverloadCache.find(std::make_pair((unsigned)opClass, pOverloadType));
+  if (CacheIt != m_OverloadCache.end())
+    return CacheIt->second;
 
   SmallVector<Type *, 32> ArgTypes; // RetType is ArgTypes[0]
   Type *pETy = pOverloadType;
@@ -6737,12 +6757,11 @@ Function *OP::GetOpFunc(OpCode opCode, Type *pOverloadType) {
   if (Function *existF = m_pModule->getFunction(FuncName)) {
     if (existF->getFunctionType() != pFT)
       return nullptr;
-    F = existF;
-    UpdateCache(opClass, pOverloadType, F);
-    return F;
+    UpdateCache(opClass, pOverloadType, existF);
+    return existF;
   }
 
-  F = cast<Function>(m_pModule->getOrInsertFunction(FuncName, pFT));
+  Function *F = cast<Function>(m_pModule->getOrInsertFunction(FuncName, pFT));
 
   UpdateCache(opClass, pOverloadType, F);
   F->setCallingConv(CallingConv::C);
@@ -6753,8 +6772,7 @@ Function *OP::GetOpFunc(OpCode opCode, Type *pOverloadType) {
   return F;
 }
 
-const SmallMapVector<llvm::Type *, llvm::Function *, 8> &
-OP::GetOpFuncList(OpCode opCode) const {
+const OP::OverloadList &OP::GetOpFuncList(OpCode opCode) const {
   return m_OpCodeClassCache[(unsigned)GetOpCodeProps(opCode).opCodeClass]
       .pOverloads;
 }
@@ -6774,14 +6792,17 @@ bool OP::IsDxilOpUsed(OpCode opcode) const {
 }
 
 void OP::RemoveFunction(Function *F) {
-  if (OP::IsDxilOpFunc(F)) {
-    OpCodeClass opClass = m_FunctionToOpClass[F];
-    for (auto it : m_OpCodeClassCache[(unsigned)opClass].pOverloads) {
-      if (it.second == F) {
-        m_OpCodeClassCache[(unsigned)opClass].pOverloads.erase(it.first);
-        m_FunctionToOpClass.erase(F);
-        break;
-      }
+  auto FuncIt = m_FunctionToOpClass.find(F);
+  if (FuncIt == m_FunctionToOpClass.end())
+    return;
+  unsigned opClass = (unsigned)FuncIt->second;
+  m_FunctionToOpClass.erase(FuncIt);
+  OverloadList &Overloads = m_OpCodeClassCache[opClass].pOverloads;
+  for (auto it = Overloads.begin(), e = Overloads.end(); it != e; ++it) {
+    if (it->second == F) {
+      m_OverloadCache.erase(std::make_pair(opClass, it->first));
+      Overloads.erase(it);
+      break;
     }
   }
 }
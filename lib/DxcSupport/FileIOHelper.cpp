@@ -1334,6 +1334,86 @@ public:
   }
 };
 
+// Write-only stream over a file, for output that is produced incrementally.
+class FileWriteStream : public IStream {
+private:
+  DXC_MICROCOM_TM_REF_FIELDS()
+  HANDLE m_hFile = INVALID_HANDLE_VALUE;
+
+public:
+  DXC_MICROCOM_TM_ADDREF_RELEASE_IMPL()
+  DXC_MICROCOM_TM_CTOR(FileWriteStream)
+  ~FileWriteStream() {
+    if (m_hFile != INVALID_HANDLE_VALUE)
+      CloseHandle(m_hFile);
+  }
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+                                           void **ppvObject) override {
+    return DoBasicQueryInterface<IStream, ISequentialStream>(this, iid,
+                                                             ppvObject);
+  }
+
+  HRESULT Init(LPCWSTR pFileName) {
+    m_hFile = CreateFileW(pFileName, GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                          CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_hFile == INVALID_HANDLE_VALUE)
+      return HRESULT_FROM_WIN32(GetLastError());
+    return S_OK;
+  }
+
+  // ISequentialStream implementation.
+  HRESULT STDMETHODCALLTYPE Read(void *, ULONG, ULONG *) override {
+    return STG_E_ACCESSDENIED;
+  }
+
+  HRESULT STDMETHODCALLTYPE Write(void const *pv, ULONG cb,
+                                  ULONG *pcbWritten) override {
+    if (!pv || !pcbWritten)
+      return E_POINTER;
+    DWORD written;
+    if (!WriteFile(m_hFile, pv, cb, &written, nullptr))
+      return HRESULT_FROM_WIN32(GetLastError());
+    *pcbWritten = written;
+    return S_OK;
+  }
+
+  // IStream implementation.
+  HRESULT STDMETHODCALLTYPE SetSize(ULARGE_INTEGER) override {
+    return E_NOTIMPL;
+  }
+
+  HRESULT STDMETHODCALLTYPE CopyTo(IStream *, ULARGE_INTEGER, ULARGE_INTEGER *,
+                                   ULARGE_INTEGER *) override {
+    return E_NOTIMPL;
+  }
+
+  HRESULT STDMETHODCALLTYPE Commit(DWORD) override { return E_NOTIMPL; }
+
+  HRESULT STDMETHODCALLTYPE Revert(void) override { return E_NOTIMPL; }
+
+  HRESULT STDMETHODCALLTYPE LockRegion(ULARGE_INTEGER, ULARGE_INTEGER,
+                                       DWORD) override {
+    return E_NOTIMPL;
+  }
+
+  HRESULT STDMETHODCALLTYPE UnlockRegion(ULARGE_INTEGER, ULARGE_INTEGER,
+                                         DWORD) override {
+    return E_NOTIMPL;
+  }
+
+  HRESULT STDMETHODCALLTYPE Clone(IStream **) override { return E_NOTIMPL; }
+
+  HRESULT STDMETHODCALLTYPE Seek(LARGE_INTEGER, DWORD,
+                                 ULARGE_INTEGER *) override {
+    return E_NOTIMPL;
+  }
+
+  HRESULT STDMETHODCALLTYPE Stat(STATSTG *, DWORD) override {
+    return E_NOTIMPL;
+  }
+};
+
 class ReadOnlyBlobStream : public IStream {
 private:
   DXC_MICROCOM_TM_REF_FIELDS()
@@ -1587,6 +1667,25 @@ HRESULT CreateReadOnlyBlobStream(IDxcBlob *pSource,
   return (*ppResult == nullptr) ? E_OUTOFMEMORY : S_OK;
 }
 
+HRESULT CreateFileWriteStream(LPCWSTR pFileName, IStream **ppResult) throw() {
+  if (pFileName == nullptr || ppResult == nullptr) {
+    return E_POINTER;
+  }
+
+  *ppResult = nullptr;
+  CComPtr<FileWriteStream> stream =
+      FileWriteStream::Alloc(DxcGetThreadMallocNoRef());
+  if (stream.p == nullptr) {
+    return E_OUTOFMEMORY;
+  }
+  HRESULT hr = stream->Init(pFileName);
+  if (FAILED(hr)) {
+    return hr;
+  }
+  *ppResult = stream.Detach();
+  return S_OK;
+}
+
 HRESULT CreateFixedSizeMemoryStream(LPBYTE pBuffer, size_t size,
                                     AbstractMemoryStream **ppResult) throw() {
   if (pBuffer == nullptr || ppResult == nullptr) {
@@ -800,6 +800,7 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   opts.DefaultRowMajor = Args.hasFlag(OPT_Zpr, OPT_INVALID, false);
   opts.DefaultColMajor = Args.hasFlag(OPT_Zpc, OPT_INVALID, false);
   opts.DumpBin = Args.hasFlag(OPT_dumpbin, OPT_INVALID, false);
+  opts.DisassembleFunction = Args.getLastArgValue(OPT_disasm_function);
   opts.Link = Args.hasFlag(OPT_link, OPT_INVALID, false);
   bool NotUseLegacyCBufLoad =
       Args.hasFlag(OPT_no_legacy_cbuf_layout, OPT_INVALID, false);
@@ -825,6 +826,8 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   opts.EmbedDebug = Args.hasFlag(OPT_Qembed_debug, OPT_INVALID, false);
   opts.SourceInDebugModule =
       Args.hasFlag(OPT_Qsource_in_debug_module, OPT_INVALID, false);
+  opts.SourceCompressPerFile =
+      Args.hasFlag(OPT_Qsource_compress_per_file, OPT_INVALID, false);
   opts.SourceOnlyDebug = Args.hasFlag(OPT_Zs, OPT_INVALID, false);
   opts.PdbInPrivate = Args.hasFlag(OPT_Qpdb_in_private, OPT_INVALID, false);
   opts.StripRootSignature =
@@ -894,6 +897,8 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
              << opts.TimeTraceGranularity << " microseconds.";
     }
   }
+  opts.TimeTracePassCosts =
+      Args.hasFlag(OPT_ftime_trace_pass_costs, OPT_INVALID, false);
 
   opts.EnablePayloadQualifiers =
       Args.hasFlag(OPT_enable_payload_qualifiers, OPT_INVALID,
@@ -1470,6 +1475,9 @@ SerializeDxilFlags ComputeSerializeDxilFlags(const options::DxcOpts &opts) {
   if (opts.StripRootSignature) {
     SerializeFlags |= SerializeDxilFlags::StripRootSignature;
   }
+  if (opts.OptToggles.IsEnabled(TOGGLE_PARALLEL_BITCODE_WRITER)) {
+    SerializeFlags |= SerializeDxilFlags::ParallelBitcodeWriter;
+  }
   return SerializeFlags;
 }
 
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// WorkerThreads.cpp                                                         //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Helpers to run work on worker threads under the caller's allocator.       //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/Support/WorkerThreads.h"
+#include "dxc/Support/Global.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+unsigned hlsl::GetWorkerThreadCount(unsigned Requested) {
+  if (Requested)
+    return Requested;
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+hlsl::WorkerRunner hlsl::CreateWorkerRunner() {
+  IMalloc *pMalloc = DxcGetThreadMallocNoRef();
+  return [pMalloc](const std::function<void()> &Work) {
+    DxcThreadMalloc TM(pMalloc);
+    Work();
+  };
+}
+
+void hlsl::ParallelFor(unsigned NumThreads, size_t Count,
+                       const std::function<void(size_t)> &Work) {
+  std::atomic<size_t> NextIndex(0);
+  std::exception_ptr FirstException;
+  std::mutex ExceptionMutex;
+  auto DoWork = [&]() {
+    try {
+      for (size_t i = NextIndex++; i < Count; i = NextIndex++)
+        Work(i);
+    } catch (...) {
+      NextIndex = Count;
+      std::lock_guard<std::mutex> Lock(ExceptionMutex);
+      if (!FirstException)
+        FirstException = std::current_exception();
+    }
+  };
+
+  NumThreads = (unsigned)std::min<size_t>(GetWorkerThreadCount(NumThreads),
+                                          Count);
+  WorkerRunner RunOnWorker = CreateWorkerRunner();
+  std::vector<std::thread> Threads;
+  Threads.reserve(NumThreads ? NumThreads - 1 : 0);
+  for (unsigned i = 1; i < NumThreads; i++) {
+    try {
+      Threads.emplace_back(RunOnWorker, std::function<void()>(DoWork));
+    } catch (const std::system_error &) {
+      break; // Carry on with the threads we have.
+    }
+  }
+  DoWork();
+  for (std::thread &T : Threads)
+    T.join();
+  if (FirstException)
+    std::rethrow_exception(FirstException);
+}
@@ -7,13 +7,19 @@
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 //
-// Helper wrapper functions for zlib deflate and inflate. Entirely
-// self-contained, only depends on IMalloc interface.
+// Helper wrapper functions for zlib deflate and inflate. Only depends on
+// IMalloc interface, and on the DxcSupport worker threads for the parallel
+// deflate.
 //
 
 #include "dxc/DxilCompression/DxilCompression.h"
 #include "dxc/Support/Global.h"
 #include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/WorkerThreads.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 #include "miniz.h"
 typedef size_t ZlibSize_t;
@@ -26,7 +32,7 @@ namespace {
 //
 class Zlib {
 public:
-  enum Operation { INFLATE, DEFLATE };
+  enum Operation { INFLATE, DEFLATE, DEFLATE_RAW };
   Zlib(Operation Op, IMalloc *pAllocator)
       : m_Stream{}, m_Op(Op), m_Initalized(false) {
     m_Stream = {};
@@ -40,6 +46,11 @@ public:
     int ret = Z_ERRNO;
     if (Op == INFLATE) {
       ret = inflateInit(&m_Stream);
+    } else if (Op == DEFLATE_RAW) {
+      // Same settings as deflateInit, but without the zlib header and
+      // trailer, so that the output can be spliced into a larger stream.
+      ret = deflateInit2(&m_Stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         -MZ_DEFAULT_WINDOW_BITS, 9, Z_DEFAULT_STRATEGY);
     } else {
       ret = deflateInit(&m_Stream, Z_DEFAULT_COMPRESSION);
     }
@@ -152,3 +163,121 @@ hlsl::ZlibResult hlsl::ZlibCompress(IMalloc *pMalloc, const void *pData,
   *pOutCompressedSize = pStream->total_out;
   return ZlibResult::Success;
 }
+
+namespace {
+// Combines the adler-32 checksums of two adjacent buffers, where Len2 is the
+// size of the second one. Same math as zlib's adler32_combine, which miniz
+// does not provide.
+uint32_t Adler32Combine(uint32_t Adler1, uint32_t Adler2, size_t Len2) {
+  const uint32_t Base = 65521;
+  const uint32_t Rem = (uint32_t)(Len2 % Base);
+  uint32_t Sum1 = Adler1 & 0xffff;
+  uint32_t Sum2 = (uint32_t)(((uint64_t)Rem * Sum1) % Base);
+  Sum1 += (Adler2 & 0xffff) + Base - 1;
+  Sum2 += ((Adler1 >> 16) & 0xffff) + ((Adler2 >> 16) & 0xffff) + Base - Rem;
+  if (Sum1 >= Base)
+    Sum1 -= Base;
+  if (Sum1 >= Base)
+    Sum1 -= Base;
+  if (Sum2 >= (Base << 1))
+    Sum2 -= (Base << 1);
+  if (Sum2 >= Base)
+    Sum2 -= Base;
+  return Sum1 | (Sum2 << 16);
+}
+
+struct DeflateBlock {
+  const Byte *pData = nullptr;
+  size_t DataSize = 0;
+  bool bLast = false;
+  std::vector<Byte> Compressed;
+  uint32_t Adler = 0;
+  hlsl::ZlibResult Result = hlsl::ZlibResult::Success;
+};
+
+// Deflates one block into a raw deflate fragment. Every block except the last
+// ends with a sync flush, which pads the output to a byte boundary with an
+// empty stored block, so the fragments can be concatenated as is.
+void DeflateOneBlock(IMalloc *pMalloc, DeflateBlock &Block) {
+  Zlib zlib(Zlib::DEFLATE_RAW, pMalloc);
+  z_stream *pStream = zlib.GetStream();
+  if (!pStream) {
+    Block.Result = zlib.GetInitializationResult();
+    return;
+  }
+
+  // Leave room for the empty stored block written by the sync flush.
+  const size_t UpperBound = deflateBound(pStream, Block.DataSize) + 16;
+  Block.Compressed.resize(UpperBound);
+
+  pStream->next_in = (ZlibInputBytesf *)Block.pData;
+  pStream->avail_in = Block.DataSize;
+  pStream->next_out = Block.Compressed.data();
+  pStream->avail_out = UpperBound;
+
+  int status = deflate(pStream, Block.bLast ? Z_FINISH : Z_SYNC_FLUSH);
+  const int expected = Block.bLast ? Z_STREAM_END : Z_OK;
+  if (status != expected || pStream->avail_in != 0) {
+    Block.Result = Zlib::TranslateZlibResult(status);
+    return;
+  }
+
+  Block.Compressed.resize(pStream->total_out);
+  Block.Adler = (uint32_t)pStream->adler;
+}
+} // namespace
+
+hlsl::ZlibResult hlsl::ZlibCompressParallel(IMalloc *pMalloc, const void *pData,
+                                            size_t pDataSize, void *pUserData,
+                                            ZlibCallbackFn *Callback,
+                                            size_t *pOutCompressedSize,
+                                            unsigned NumThreads) {
+  const size_t BlockSize = ZlibParallelBlockSize;
+  if (pDataSize < 2 * BlockSize)
+    return ZlibCompress(pMalloc, pData, pDataSize, pUserData, Callback,
+                        pOutCompressedSize);
+
+  // Block boundaries only depend on the input size, so the output is the same
+  // regardless of how many threads end up doing the work.
+  const size_t NumBlocks = (pDataSize + BlockSize - 1) / BlockSize;
+  std::vector<DeflateBlock> Blocks(NumBlocks);
+  for (size_t i = 0; i < NumBlocks; i++) {
+    Blocks[i].pData = (const Byte *)pData + i * BlockSize;
+    Blocks[i].DataSize = std::min(BlockSize, pDataSize - i * BlockSize);
+    Blocks[i].bLast = i + 1 == NumBlocks;
+  }
+
+  // Workers run under the caller's thread malloc, so the block buffers they
+  // grow are released with the right allocator.
+  ParallelFor(NumThreads, NumBlocks,
+              [&](size_t i) { DeflateOneBlock(pMalloc, Blocks[i]); });
+
+  // Zlib header for the default compression level and a 32K window, followed
+  // by the deflate fragments and the big-endian adler-32 of the whole input.
+  size_t TotalSize = 2 + 4;
+  uint32_t Adler = MZ_ADLER32_INIT;
+  for (const DeflateBlock &Block : Blocks) {
+    if (Block.Result != ZlibResult::Success)
+      return Block.Result;
+    TotalSize += Block.Compressed.size();
+    Adler = Adler32Combine(Adler, Block.Adler, Block.DataSize);
+  }
+
+  Byte *pDest = (Byte *)Callback(pUserData, TotalSize);
+  if (!pDest)
+    return ZlibResult::OutOfMemory;
+
+  *pDest++ = 0x78;
+  *pDest++ = 0x9C;
+  for (const DeflateBlock &Block : Blocks) {
+    memcpy(pDest, Block.Compressed.data(), Block.Compressed.size());
+    pDest += Block.Compressed.size();
+  }
+  *pDest++ = (Byte)(Adler >> 24);
+  *pDest++ = (Byte)(Adler >> 16);
+  *pDest++ = (Byte)(Adler >> 8);
+  *pDest++ = (Byte)Adler;
+
+  *pOutCompressedSize = TotalSize;
+  return ZlibResult::Success;
+}
@@ -37,13 +37,11 @@ HRESULT STDMETHODCALLTYPE DxcContainerBuilder::Load(IDxcBlob *pSource) {
     m_pContainer = pSource;
     const DxilContainerHeader *pHeader =
         (DxilContainerHeader *)pSource->GetBufferPointer();
+    // Parts are referenced in place; SerializeContainer copies them straight
+    // from the source blob.
     for (DxilPartIterator it = begin(pHeader), itEnd = end(pHeader);
          it != itEnd; ++it) {
-      const DxilPartHeader *pPartHeader = *it;
-      CComPtr<IDxcBlob> pBlob;
-      IFT(DxcCreateBlobFromPinned((const void *)(pPartHeader + 1),
-                                  pPartHeader->PartSize, &pBlob));
-      AddPart(DxilPart(pPartHeader->PartFourCC, pBlob));
+      AddPart(DxilPart(*it));
     }
     // Collect hash function.
     const DxilContainerHeader *Header =
@@ -89,9 +87,9 @@ HRESULT STDMETHODCALLTYPE DxcContainerBuilder::RemovePart(UINT32 fourCC) {
                 fourCC == DxilFourCC::DFCC_ShaderStatistics,
             E_INVALIDARG); // You can only remove debug info, debug info name,
                            // rootsignature, or private data blob
-    PartList::iterator it =
-        std::find_if(m_parts.begin(), m_parts.end(),
-                     [&](DxilPart part) { return part.m_fourCC == fourCC; });
+    PartList::iterator it = std::find_if(
+        m_parts.begin(), m_parts.end(),
+        [&](const DxilPart &part) { return part.m_fourCC == fourCC; });
     IFTBOOL(it != m_parts.end(), DXC_E_MISSING_PART);
     m_parts.erase(it);
     if (fourCC == DxilFourCC::DFCC_PrivateData) {
@@ -110,22 +108,16 @@ DxcContainerBuilder::SerializeContainer(IDxcOperationResult **ppResult) {
   DxcThreadMalloc TM(m_pMalloc);
 
   try {
-    // Allocate memory for new dxil container.
+    // Allocate memory for new dxil container and assemble it in place.
     uint32_t ContainerSize = ComputeContainerSize();
-    CComPtr<AbstractMemoryStream> pMemoryStream;
+    CDxcMallocHeapPtr<char> containerHeap(m_pMalloc);
+    containerHeap.AllocateBytes(ContainerSize);
+    IFTOOM(containerHeap.m_pData);
+    WriteContainer(containerHeap.m_pData, ContainerSize);
     CComPtr<IDxcBlob> pResult;
-    IFT(CreateMemoryStream(m_pMalloc, &pMemoryStream));
-    IFT(pMemoryStream->QueryInterface(&pResult));
-    IFT(pMemoryStream->Reserve(ContainerSize))
-
-    // Update Dxil Container
-    IFT(UpdateContainerHeader(pMemoryStream, ContainerSize));
-
-    // Update offset Table
-    IFT(UpdateOffsetTable(pMemoryStream));
-
-    // Update Parts
-    IFT(UpdateParts(pMemoryStream));
+    IFT(DxcCreateBlobOnMalloc(containerHeap.m_pData, m_pMalloc, ContainerSize,
+                              &pResult));
+    containerHeap.Detach();
 
     CComPtr<IDxcBlobUtf8> pValErrorUtf8;
     HRESULT valHR = S_OK;
@@ -133,7 +125,12 @@ DxcContainerBuilder::SerializeContainer(IDxcOperationResult **ppResult) {
       CComPtr<IDxcValidator> pValidator;
       IFT(CreateDxcValidator(IID_PPV_ARGS(&pValidator)));
       CComPtr<IDxcOperationResult> pValidationResult;
-      IFT(pValidator->Validate(pResult, DxcValidatorFlags_RootSignatureOnly,
+      // Root signature validation only reads the RTS0 and PSV0 parts, so the
+      // bitcode is never parsed. Validate in place to avoid another copy of
+      // the container; the hash is recomputed below either way.
+      IFT(pValidator->Validate(pResult,
+                               DxcValidatorFlags_RootSignatureOnly |
+                                   DxcValidatorFlags_InPlaceEdit,
                                &pValidationResult));
       IFT(pValidationResult->GetStatus(&valHR));
       if (FAILED(valHR)) {
@@ -162,9 +159,14 @@ DxcContainerBuilder::SerializeContainer(IDxcOperationResult **ppResult) {
     }
 
     // Add Hash.
-    if (SUCCEEDED(valHR))
-      HashAndUpdate(IsDxilContainerLike(pResult->GetBufferPointer(),
-                                        pResult->GetBufferSize()));
+    DxilContainerHeader *pResultHeader = IsDxilContainerLike(
+        pResult->GetBufferPointer(), pResult->GetBufferSize());
+    // In-place validation may already have hashed the container; clear the
+    // digest again when the builder would not produce a valid hash.
+    if (SUCCEEDED(valHR) && m_HashFunction != nullptr)
+      HashAndUpdate(pResultHeader);
+    else
+      memset(pResultHeader->Hash.Digest, 0, DxilContainerHashSize);
 
     IFT(DxcResult::Create(
         valHR, DXC_OUT_OBJECT,
@@ -218,65 +220,59 @@ void DxcContainerBuilder::HashAndUpdate(DxilContainerHeader *ContainerHeader) {
 
 UINT32 DxcContainerBuilder::ComputeContainerSize() {
   UINT32 partsSize = 0;
-  for (DxilPart part : m_parts) {
-    partsSize += part.m_Blob->GetBufferSize();
+  for (const DxilPart &part : m_parts) {
+    partsSize += part.GetSize();
   }
   return GetDxilContainerSizeFromParts(m_parts.size(), partsSize);
 }
 
-HRESULT
-DxcContainerBuilder::UpdateContainerHeader(AbstractMemoryStream *pStream,
-                                           uint32_t containerSize) {
-  DxilContainerHeader header;
-  InitDxilContainer(&header, m_parts.size(), containerSize);
-  ULONG cbWritten;
-  IFR(pStream->Write(&header, sizeof(DxilContainerHeader), &cbWritten));
-  if (cbWritten != sizeof(DxilContainerHeader)) {
-    return E_FAIL;
-  }
-  return S_OK;
-}
+// Writes the header, offset table and parts into pDest. Runs of parts that
+// are still laid out back to back in the loaded container are copied with a
+// single memcpy, part headers included.
+void DxcContainerBuilder::WriteContainer(char *pDest, uint32_t containerSize) {
+  char *pCur = pDest;
+  InitDxilContainer((DxilContainerHeader *)pCur, m_parts.size(),
+                    containerSize);
+  pCur += sizeof(DxilContainerHeader);
 
-HRESULT DxcContainerBuilder::UpdateOffsetTable(AbstractMemoryStream *pStream) {
   UINT32 offset =
       sizeof(DxilContainerHeader) + GetOffsetTableSize(m_parts.size());
-  for (size_t i = 0; i < m_parts.size(); ++i) {
-    ULONG cbWritten;
-    IFR(pStream->Write(&offset, sizeof(UINT32), &cbWritten));
-    if (cbWritten != sizeof(UINT32)) {
-      return E_FAIL;
-    }
-    offset += sizeof(DxilPartHeader) + m_parts[i].m_Blob->GetBufferSize();
+  for (const DxilPart &part : m_parts) {
+    memcpy(pCur, &offset, sizeof(UINT32));
+    pCur += sizeof(UINT32);
+    offset += sizeof(DxilPartHeader) + part.GetSize();
   }
-  return S_OK;
-}
 
-HRESULT DxcContainerBuilder::UpdateParts(AbstractMemoryStream *pStream) {
-  for (size_t i = 0; i < m_parts.size(); ++i) {
-    ULONG cbWritten;
-    CComPtr<IDxcBlob> pBlob = m_parts[i].m_Blob;
-    // Write part header
-    DxilPartHeader partHeader = {m_parts[i].m_fourCC,
-                                 (uint32_t)pBlob->GetBufferSize()};
-    IFR(pStream->Write(&partHeader, sizeof(DxilPartHeader), &cbWritten));
-    if (cbWritten != sizeof(DxilPartHeader)) {
-      return E_FAIL;
-    }
-    // Write part content
-    IFR(pStream->Write(pBlob->GetBufferPointer(), pBlob->GetBufferSize(),
-                       &cbWritten));
-    if (cbWritten != pBlob->GetBufferSize()) {
-      return E_FAIL;
+  for (size_t i = 0, e = m_parts.size(); i < e;) {
+    const DxilPart &part = m_parts[i];
+    if (part.m_pSourceHeader) {
+      const char *pRunBegin = (const char *)part.m_pSourceHeader;
+      const char *pRunEnd = pRunBegin;
+      for (; i < e && (const char *)m_parts[i].m_pSourceHeader == pRunEnd;
+           ++i) {
+        pRunEnd +=
+            sizeof(DxilPartHeader) + m_parts[i].m_pSourceHeader->PartSize;
+      }
+      memcpy(pCur, pRunBegin, pRunEnd - pRunBegin);
+      pCur += pRunEnd - pRunBegin;
+      continue;
     }
+    DxilPartHeader partHeader = {part.m_fourCC, part.GetSize()};
+    memcpy(pCur, &partHeader, sizeof(DxilPartHeader));
+    pCur += sizeof(DxilPartHeader);
+    memcpy(pCur, part.GetData(), part.GetSize());
+    pCur += part.GetSize();
+    ++i;
   }
-  return S_OK;
+  DXASSERT_NOMSG(pCur == pDest + containerSize);
 }
 
 void DxcContainerBuilder::AddPart(DxilPart &&part) {
   PartList::iterator it =
-      std::find_if(m_parts.begin(), m_parts.end(), [&](DxilPart checkPart) {
-        return checkPart.m_fourCC == part.m_fourCC;
-      });
+      std::find_if(m_parts.begin(), m_parts.end(),
+                   [&](const DxilPart &checkPart) {
+                     return checkPart.m_fourCC == part.m_fourCC;
+                   });
   IFTBOOL(it == m_parts.end(), DXC_E_DUPLICATE_PART);
   if (m_HasPrivateData) {
     // Keep PrivateData at end, since it may have unaligned size.
@@ -27,6 +27,7 @@
 #include "dxc/Support/Global.h"
 #include "dxc/Support/Unicode.h"
 #include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/WorkerThreads.h"
 #include "dxc/Support/dxcapi.impl.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
@@ -998,6 +999,7 @@ private:
   RDATTable *m_pResourceTable;
   RDATTable *m_pFunctionTable;
   RDATTable *m_pSubobjectTable;
+  NameIndexPart *m_pNameIndex = nullptr;
 
   typedef llvm::SmallSetVector<uint32_t, 8> Indices;
   typedef std::unordered_map<const llvm::Function *, Indices> FunctionIndexMap;
@@ -1569,7 +1571,14 @@ private:
         info.MinShaderTarget =
             EncodeVersion((DXIL::ShaderKind)shaderKind, compatInfo.minMajor,
                           compatInfo.minMinor);
-        m_pFunctionTable->Insert(info_latest);
+        uint32_t row = m_pFunctionTable->Insert(info_latest);
+        if (m_pNameIndex) {
+          m_pNameIndex->Insert(RuntimeDataPartType::FunctionTable, mangled,
+                               mangledIndex, row);
+          if (unmangledIndex != mangledIndex)
+            m_pNameIndex->Insert(RuntimeDataPartType::FunctionTable,
+                                 unmangled, unmangledIndex, row);
+        }
       }
     }
   }
@@ -1640,7 +1649,10 @@ private:
             info.RaytracingPipelineConfig1.Flags);
         break;
       }
-      m_pSubobjectTable->Insert(info);
+      uint32_t row = m_pSubobjectTable->Insert(info);
+      if (m_pNameIndex)
+        m_pNameIndex->Insert(RuntimeDataPartType::SubobjectTable,
+                             obj.GetName(), info.Name, row);
     }
   }
 
@@ -1684,6 +1696,13 @@ public:
 #define DEF_RDAT_TYPES DEF_RDAT_DEFAULTS
 #include "dxc/DxilContainer/RDAT_Macros.inl"
 
+    if (RuntimeDataPartType::NameIndex <= maxAllowedType) {
+      m_pNameIndex = &Builder.GetNameIndexPart();
+      m_pNameIndex->AddTable(RuntimeDataPartType::FunctionTable);
+      if (m_pSubobjectTable)
+        m_pNameIndex->AddTable(RuntimeDataPartType::SubobjectTable);
+    }
+
     UpdateResourceInfo(mod);
     UpdateFunctionInfo(mod);
     if (m_pSubobjectTable)
@@ -1795,6 +1814,20 @@ static void GetPaddedProgramPartSize(AbstractMemoryStream *pStream,
   bitcodeInUInt32 = (bitcodeInUInt32 / 4) + (bitcodePaddingBytes ? 1 : 0);
 }
 
+void hlsl::WriteBitcodeForContainer(const llvm::Module *M, raw_ostream &OS,
+                                    bool ShouldPreserveUseListOrder,
+                                    SerializeDxilFlags Flags,
+                                    unsigned NumThreads) {
+  BitcodeWriterThreads Threads;
+  if (Flags & SerializeDxilFlags::ParallelBitcodeWriter) {
+    Threads.NumThreads = GetWorkerThreadCount(NumThreads);
+    // Workers allocate with the caller's allocator, so the buffers they
+    // return can be released on this thread.
+    Threads.RunOnWorker = CreateWorkerRunner();
+  }
+  WriteBitcodeToFile(M, OS, ShouldPreserveUseListOrder, Threads);
+}
+
 void hlsl::WriteProgramPart(const ShaderModel *pModel,
                             AbstractMemoryStream *pModuleBitcode,
                             IStream *pStream) {
@@ -1902,7 +1935,7 @@ void hlsl::SerializeDxilContainerForModule(
     llvm::StringRef DebugName, SerializeDxilFlags Flags,
     DxilShaderHash *pShaderHashOut, AbstractMemoryStream *pReflectionStreamOut,
     AbstractMemoryStream *pRootSigStreamOut, void *pPrivateData,
-    size_t PrivateDataSize) {
+    size_t PrivateDataSize, unsigned BitcodeWriterThreads) {
   llvm::TimeTraceScope TimeScope("SerializeDxilContainer", StringRef(""));
   // TODO: add a flag to update the module and remove information that is not
   // part of DXIL proper and is used only to assemble the container.
@@ -2045,7 +2078,8 @@ void hlsl::SerializeDxilContainerForModule(
     pInputProgramStream.Release();
     IFT(CreateMemoryStream(DxcGetThreadMallocNoRef(), &pInputProgramStream));
     raw_stream_ostream outStream(pInputProgramStream.p);
-    WriteBitcodeToFile(pModule->GetModule(), outStream, true);
+    WriteBitcodeForContainer(pModule->GetModule(), outStream, true, Flags,
+                             BitcodeWriterThreads);
   }
 
   // If we have debug information present, serialize it to a debug part, then
@@ -2123,7 +2157,8 @@ void hlsl::SerializeDxilContainerForModule(
     pProgramStream.Release();
     IFT(CreateMemoryStream(DxcGetThreadMallocNoRef(), &pProgramStream));
     raw_stream_ostream outStream(pProgramStream.p);
-    WriteBitcodeToFile(pModule->GetModule(), outStream, false);
+    WriteBitcodeForContainer(pModule->GetModule(), outStream, false, Flags,
+                             BitcodeWriterThreads);
   }
 
   // Compute hash if needed.
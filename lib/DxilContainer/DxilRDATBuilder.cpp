@@ -2,11 +2,35 @@
 #include "dxc/DxilContainer/DxilPipelineStateValidation.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/Global.h"
+#include "llvm/ADT/Hashing.h"
 
 using namespace llvm;
 using namespace hlsl;
 using namespace RDAT;
 
+uint32_t DeduplicatingBuffer::Insert(StringRef bytes, bool bDeduplicate,
+                                     bool bNullTerminate) {
+  const size_t hash = llvm::hash_value(bytes);
+  const uint32_t size = bytes.size() + (bNullTerminate ? 1 : 0);
+  if (bDeduplicate) {
+    auto range = m_Index.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      const uint32_t offset = it->second.first;
+      if (it->second.second == size &&
+          memcmp(m_Data.data() + offset, bytes.data(), bytes.size()) == 0)
+        return offset;
+    }
+  }
+  IFTBOOL(m_Data.size() + size <= UINT32_MAX, DXC_E_GENERAL_INTERNAL_ERROR);
+  const uint32_t offset = m_Data.size();
+  m_Data.insert(m_Data.end(), bytes.begin(), bytes.end());
+  if (bNullTerminate)
+    m_Data.push_back('\0');
+  if (bDeduplicate)
+    m_Index.emplace(hash, std::make_pair(offset, size));
+  return offset;
+}
+
 void RDATTable::SetRecordStride(size_t RecordStride) {
   DXASSERT(m_rows.empty(), "record stride is fixed for the entire table");
   m_RecordStride = RecordStride;
@@ -14,17 +38,10 @@ void RDATTable::SetRecordStride(size_t RecordStride) {
 
 uint32_t RDATTable::InsertImpl(const void *ptr, size_t size) {
   IFTBOOL(m_RecordStride <= size, DXC_E_GENERAL_INTERNAL_ERROR);
-  size_t count = m_rows.size();
-  if (count < (UINT32_MAX - 1)) {
-    const char *pData = (const char *)ptr;
-    auto result = m_map.insert(
-        std::make_pair(std::string(pData, pData + m_RecordStride), count));
-    if (!m_bDeduplicationEnabled || result.second) {
-      m_rows.emplace_back(result.first->first);
-      return count;
-    } else {
-      return result.first->second;
-    }
+  if (Count() < (UINT32_MAX - 1)) {
+    uint32_t offset = m_rows.Insert(
+        StringRef((const char *)ptr, m_RecordStride), m_bDeduplicationEnabled);
+    return offset / m_RecordStride;
   }
   return RDAT_NULL_REF;
 }
@@ -33,40 +50,89 @@ void RDATTable::Write(void *ptr) {
   char *pCur = (char *)ptr;
   RuntimeDataTableHeader &header =
       *reinterpret_cast<RuntimeDataTableHeader *>(pCur);
-  header.RecordCount = m_rows.size();
+  header.RecordCount = Count();
   header.RecordStride = m_RecordStride;
   pCur += sizeof(RuntimeDataTableHeader);
-  for (auto &record : m_rows) {
-    DXASSERT_NOMSG(record.size() == m_RecordStride);
-    memcpy(pCur, record.data(), m_RecordStride);
-    pCur += m_RecordStride;
-  }
+  memcpy(pCur, m_rows.data(), m_rows.size());
 };
 
 uint32_t RDATTable::GetPartSize() const {
   if (m_rows.empty())
     return 0;
-  return sizeof(RuntimeDataTableHeader) + m_rows.size() * m_RecordStride;
+  return sizeof(RuntimeDataTableHeader) + m_rows.size();
 }
 
 uint32_t RawBytesPart::Insert(const void *pData, size_t dataSize) {
-  auto result = m_Map.insert(std::make_pair(
-      std::string((const char *)pData, (const char *)pData + dataSize),
-      m_Size));
-  auto iterator = result.first;
-  if (result.second) {
-    const std::string &key = iterator->first;
-    m_List.push_back(llvm::StringRef(key.data(), key.size()));
-    m_Size += key.size();
-  }
-  return iterator->second;
+  return m_Buffer.Insert(StringRef((const char *)pData, dataSize));
 }
 
 void RawBytesPart::Write(void *ptr) {
-  for (llvm::StringRef &entry : m_List) {
-    memcpy(ptr, entry.data(), entry.size());
-    ptr = (char *)ptr + entry.size();
+  memcpy(ptr, m_Buffer.data(), m_Buffer.size());
+}
+
+void NameIndexPart::AddTable(RuntimeDataPartType table) {
+  DXASSERT((uint32_t)table < 32, "otherwise, table does not fit the mask");
+  m_IndexedTables |= 1u << (uint32_t)table;
+}
+
+void NameIndexPart::Insert(RuntimeDataPartType table, StringRef name,
+                           uint32_t nameOffset, uint32_t row) {
+  // Deduplicated records come back with the row of the first insertion.
+  if (!m_EntrySet.insert(std::make_tuple((uint32_t)table, nameOffset, row))
+           .second)
+    return;
+  RuntimeDataNameIndexEntry entry = {};
+  entry.Table = table;
+  entry.Hash = RDATNameHash(name.data(), name.size());
+  entry.Name = nameOffset;
+  entry.Row = row;
+  m_Entries.push_back(entry);
+}
+
+// Keeps the load factor at or below one.
+uint32_t NameIndexPart::GetBucketCount() const {
+  uint32_t count = 1;
+  while (count < m_Entries.size())
+    count <<= 1;
+  return count;
+}
+
+uint32_t NameIndexPart::GetPartSize() const {
+  if (m_Entries.empty())
+    return 0;
+  return sizeof(RuntimeDataNameIndexHeader) +
+         (GetBucketCount() + 1) * sizeof(uint32_t) +
+         m_Entries.size() * sizeof(RuntimeDataNameIndexEntry);
+}
+
+void NameIndexPart::Write(void *ptr) {
+  const uint32_t bucketCount = GetBucketCount();
+  const uint32_t bucketMask = bucketCount - 1;
+
+  // Group entries by bucket, keeping insertion order within a bucket.
+  std::vector<RuntimeDataNameIndexEntry> entries(m_Entries);
+  std::stable_sort(entries.begin(), entries.end(),
+                   [bucketMask](const RuntimeDataNameIndexEntry &a,
+                                const RuntimeDataNameIndexEntry &b) {
+                     return (a.Hash & bucketMask) < (b.Hash & bucketMask);
+                   });
+
+  RuntimeDataNameIndexHeader &header =
+      *reinterpret_cast<RuntimeDataNameIndexHeader *>(ptr);
+  header.BucketCount = bucketCount;
+  header.EntryCount = entries.size();
+  header.IndexedTables = m_IndexedTables;
+
+  uint32_t *pBucketStart = reinterpret_cast<uint32_t *>(&header + 1);
+  uint32_t i = 0;
+  for (uint32_t b = 0; b <= bucketCount; b++) {
+    while (i < entries.size() && (entries[i].Hash & bucketMask) < b)
+      i++;
+    pBucketStart[b] = i;
   }
+
+  memcpy(pBucketStart + bucketCount + 1, entries.data(),
+         entries.size() * sizeof(RuntimeDataNameIndexEntry));
 }
 
 DxilRDATBuilder::DxilRDATBuilder(bool allowRecordDuplication)
@@ -176,23 +242,11 @@ public:
 
 // returns the offset of the name inserted
 uint32_t StringBufferPart::Insert(llvm::StringRef str) {
-  auto result = m_Map.insert(
-      std::make_pair(std::string(str.data(), str.data() + str.size()), m_Size));
-
-  auto iterator = result.first;
-  if (result.second) {
-    const std::string &key = iterator->first;
-    m_List.push_back(llvm::StringRef(key.data(), key.size()));
-    m_Size += key.size() + 1 /*null terminator*/;
-  }
-  return iterator->second;
+  return m_Buffer.Insert(str, /*bDeduplicate*/ true, /*bNullTerminate*/ true);
 }
 
 void StringBufferPart::Write(void *ptr) {
-  for (llvm::StringRef &entry : m_List) {
-    memcpy(ptr, entry.data(), entry.size() + 1 /*null terminator*/);
-    ptr = (char *)ptr + entry.size() + 1;
-  }
+  memcpy(ptr, m_Buffer.data(), m_Buffer.size());
 }
 
 StringRef DxilRDATBuilder::FinalizeAndGetData() {
@@ -33,6 +33,10 @@ void DumpRuntimeData(const RDAT::DxilRuntimeData &RDAT, DumpContext &d) {
 #define DEF_RDAT_TYPES DEF_RDAT_DEFAULTS
 #include "dxc/DxilContainer/RDAT_Macros.inl"
 
+  if (ctx.NameIndex)
+    d.WriteLn("NameIndex (entries = ", ctx.NameIndex.EntryCount(),
+              ", buckets = ", ctx.NameIndex.BucketCount(), ")");
+
   d.Dedent();
 }
 
@@ -19,6 +19,7 @@
 
 #include "dxc/DXIL/DxilUtil.h"
 #include "dxc/Support/Global.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DebugInfoMetadata.h"
@@ -28,6 +29,8 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/Module.h"
 
+#include <mutex>
+#include <set>
 #include <unordered_map>
 
 // If a function is inlined, then the scope of variables within that function
@@ -125,11 +128,46 @@ struct dxil_debug_info::LiveVariables::Impl {
       std::unordered_map<UniqueScopeForInlinedFunctions, VariableInfoMap,
                          UniqueScopeForInlinedFunctions>;
 
+  // The live set of an instruction only depends on its debug scope, the
+  // scope it was inlined at, its source line, and (for globals) the function
+  // containing it.
+  struct LiveSetKey {
+    const llvm::MDNode *Scope;
+    const llvm::MDNode *InlinedAt;
+    unsigned Line;
+    const llvm::Function *F;
+
+    bool operator==(const LiveSetKey &o) const {
+      return Scope == o.Scope && InlinedAt == o.InlinedAt && Line == o.Line &&
+             F == o.F;
+    }
+  };
+
+  struct LiveSetKeyHash {
+    std::size_t operator()(const LiveSetKey &k) const {
+      return llvm::hash_combine(k.Scope, k.InlinedAt, k.Line, k.F);
+    }
+  };
+
+  struct LiveSetLess {
+    bool operator()(const SharedLiveVariableList &a,
+                    const SharedLiveVariableList &b) const {
+      return *a < *b;
+    }
+  };
+
   IMalloc *m_pMalloc;
   DxcPixDxilDebugInfo *m_pDxilDebugInfo;
   llvm::Module *m_pModule;
   LiveVarsMap m_LiveVarsDbgDeclare;
   VariableInfoMap m_LiveGlobalVarsDbgDeclare;
+  // The live-set cache is filled on demand by queries through the const
+  // GetLiveVariablesAtInstruction, which PIX may issue from several threads.
+  std::mutex m_LiveSetCacheLock;
+  std::unordered_map<LiveSetKey, SharedLiveVariableList, LiveSetKeyHash>
+      m_LiveSetCache;
+  // Distinct live sets; equal lists computed for different keys are shared.
+  std::set<SharedLiveVariableList, LiveSetLess> m_InternedLiveSets;
 
   void Init(IMalloc *pMalloc, DxcPixDxilDebugInfo *pDxilDebugInfo,
             llvm::Module *pModule);
@@ -143,6 +181,14 @@ struct dxil_debug_info::LiveVariables::Impl {
 
   bool IsVariableLive(const VariableInfoMap::value_type &VarAndInfo,
                       const llvm::DIScope *S, const llvm::DebugLoc &DL);
+
+  SharedLiveVariableList GetLiveSet(llvm::Instruction *IP,
+                                    const llvm::DebugLoc &DL,
+                                    UniqueScopeForInlinedFunctions S);
+
+  SharedLiveVariableList ComputeLiveSet(llvm::Instruction *IP,
+                                        const llvm::DebugLoc &DL,
+                                        UniqueScopeForInlinedFunctions S);
 };
 
 void dxil_debug_info::LiveVariables::Impl::Init(
@@ -253,28 +299,34 @@ void dxil_debug_info::LiveVariables::Clear() {
   m_pImpl.reset(new dxil_debug_info::LiveVariables::Impl());
 }
 
-HRESULT dxil_debug_info::LiveVariables::GetLiveVariablesAtInstruction(
-    llvm::Instruction *IP, IDxcPixDxilLiveVariables **ppResult) const {
-  DXASSERT(IP != nullptr, "else IP should not be nullptr");
-  DXASSERT(ppResult != nullptr, "else Result should not be nullptr");
-
-  std::vector<const VariableInfo *> LiveVars;
-  std::set<std::string> LiveVarsName;
-
-  const llvm::DebugLoc &DL = IP->getDebugLoc();
-
-  if (!DL) {
-    return E_FAIL;
+dxil_debug_info::SharedLiveVariableList
+dxil_debug_info::LiveVariables::Impl::GetLiveSet(
+    llvm::Instruction *IP, const llvm::DebugLoc &DL,
+    UniqueScopeForInlinedFunctions S) {
+  LiveSetKey Key = {DL.getScope(), DL.getInlinedAtScope(), DL.getLine(),
+                    IP->getParent()->getParent()};
+  std::lock_guard<std::mutex> Lock(m_LiveSetCacheLock);
+  auto it = m_LiveSetCache.find(Key);
+  if (it != m_LiveSetCache.end()) {
+    return it->second;
   }
 
-  auto S = UniqueScopeForInlinedFunctions::Create(DL, DL->getScope());
-  if (!S.Valid()) {
-    return E_FAIL;
-  }
+  SharedLiveVariableList LiveSet =
+      *m_InternedLiveSets.insert(ComputeLiveSet(IP, DL, S)).first;
+  m_LiveSetCache.emplace(Key, LiveSet);
+  return LiveSet;
+}
+
+dxil_debug_info::SharedLiveVariableList
+dxil_debug_info::LiveVariables::Impl::ComputeLiveSet(
+    llvm::Instruction *IP, const llvm::DebugLoc &DL,
+    UniqueScopeForInlinedFunctions S) {
+  auto LiveVars = std::make_shared<LiveVariableList>();
+  std::set<std::string> LiveVarsName;
 
   while (S.Valid()) {
-    auto it = m_pImpl->m_LiveVarsDbgDeclare.find(S);
-    if (it != m_pImpl->m_LiveVarsDbgDeclare.end()) {
+    auto it = m_LiveVarsDbgDeclare.find(S);
+    if (it != m_LiveVarsDbgDeclare.end()) {
       for (const auto &VarAndInfo : it->second) {
         auto *Var = VarAndInfo.first;
         llvm::StringRef VarName = Var->getName();
@@ -289,14 +341,14 @@ HRESULT dxil_debug_info::LiveVariables::GetLiveVariablesAtInstruction(
         if (!LiveVarsName.insert(VarAndInfo.first->getName()).second) {
           // There's a variable with the same name; use the
           // previous one instead.
-          return false;
+          continue;
         }
-        LiveVars.emplace_back(VarAndInfo.second.get());
+        LiveVars->emplace_back(VarAndInfo.second.get());
       }
     }
     S.AscendScopeHierarchy();
   }
-  for (const auto &VarAndInfo : m_pImpl->m_LiveGlobalVarsDbgDeclare) {
+  for (const auto &VarAndInfo : m_LiveGlobalVarsDbgDeclare) {
     // Only consider references to the global variable that are in the same
     // function as the instruction.
     if (hlsl::dxilutil::DemangleFunctionName(
@@ -307,9 +359,28 @@ HRESULT dxil_debug_info::LiveVariables::GetLiveVariablesAtInstruction(
         // name, but it doesn't hurt to check
         continue;
       }
-      LiveVars.emplace_back(VarAndInfo.second.get());
+      LiveVars->emplace_back(VarAndInfo.second.get());
     }
   }
-  return CreateDxilLiveVariables(m_pImpl->m_pDxilDebugInfo, std::move(LiveVars),
-                                 ppResult);
+  return LiveVars;
+}
+
+HRESULT dxil_debug_info::LiveVariables::GetLiveVariablesAtInstruction(
+    llvm::Instruction *IP, IDxcPixDxilLiveVariables **ppResult) const {
+  DXASSERT(IP != nullptr, "else IP should not be nullptr");
+  DXASSERT(ppResult != nullptr, "else Result should not be nullptr");
+
+  const llvm::DebugLoc &DL = IP->getDebugLoc();
+
+  if (!DL) {
+    return E_FAIL;
+  }
+
+  auto S = UniqueScopeForInlinedFunctions::Create(DL, DL->getScope());
+  if (!S.Valid()) {
+    return E_FAIL;
+  }
+
+  return CreateDxilLiveVariables(m_pImpl->m_pDxilDebugInfo,
+                                 m_pImpl->GetLiveSet(IP, DL, S), ppResult);
 }
@@ -50,6 +50,11 @@ struct VariableInfo {
 #endif // !NDEBUG
 };
 
+// Immutable list of the variables live at an instruction. Instructions with
+// the same scope chain and source line share a single list.
+using LiveVariableList = std::vector<const VariableInfo *>;
+using SharedLiveVariableList = std::shared_ptr<const LiveVariableList>;
+
 class LiveVariables {
 public:
   LiveVariables();
@@ -69,7 +74,7 @@ private:
 
 HRESULT
 CreateDxilLiveVariables(DxcPixDxilDebugInfo *pDxilDebugInfo,
-                        std::vector<const VariableInfo *> &&LiveVariables,
+                        SharedLiveVariableList LiveVariables,
                         IDxcPixDxilLiveVariables **ppResult);
 
 } // namespace dxil_debug_info
@@ -86,14 +86,14 @@ class DxcPixDxilLiveVariables : public IDxcPixDxilLiveVariables {
 private:
   DXC_MICROCOM_TM_REF_FIELDS();
   CComPtr<DxcPixDxilDebugInfo> m_pDxilDebugInfo;
-  std::vector<const VariableInfo *> m_LiveVars;
+  SharedLiveVariableList m_LiveVars;
 
   DxcPixDxilLiveVariables(IMalloc *pMalloc, DxcPixDxilDebugInfo *pDxilDebugInfo,
-                          std::vector<const VariableInfo *> LiveVars)
+                          SharedLiveVariableList LiveVars)
       : m_pMalloc(pMalloc), m_pDxilDebugInfo(pDxilDebugInfo),
         m_LiveVars(std::move(LiveVars)) {
 #ifndef NDEBUG
-    for (auto VarAndInfo : m_LiveVars) {
+    for (auto VarAndInfo : *m_LiveVars) {
       assert(llvm::isa<llvm::DIGlobalVariable>(VarAndInfo->m_Variable) ||
              llvm::isa<llvm::DILocalVariable>(VarAndInfo->m_Variable));
     }
@@ -123,7 +123,7 @@ public:
 
 } // namespace dxil_debug_info
 STDMETHODIMP dxil_debug_info::DxcPixDxilLiveVariables::GetCount(DWORD *dwSize) {
-  *dwSize = m_LiveVars.size();
+  *dwSize = m_LiveVars->size();
   return S_OK;
 }
 
@@ -145,11 +145,11 @@ STDMETHODIMP dxil_debug_info::DxcPixDxilLiveVariables::CreateDxcPixVariable(
 
 STDMETHODIMP dxil_debug_info::DxcPixDxilLiveVariables::GetVariableByIndex(
     DWORD Index, IDxcPixVariable **ppVariable) {
-  if (Index >= m_LiveVars.size()) {
+  if (Index >= m_LiveVars->size()) {
     return E_BOUNDS;
   }
 
-  auto *VarInfo = m_LiveVars[Index];
+  auto *VarInfo = (*m_LiveVars)[Index];
   return CreateDxcPixVariable(ppVariable, VarInfo);
 }
 
@@ -157,7 +157,7 @@ STDMETHODIMP dxil_debug_info::DxcPixDxilLiveVariables::GetVariableByName(
     LPCWSTR Name, IDxcPixVariable **ppVariable) {
   std::string name = std::string(CW2A(Name));
 
-  for (auto *VarInfo : m_LiveVars) {
+  for (auto *VarInfo : *m_LiveVars) {
     auto *Var = VarInfo->m_Variable;
     if (Var->getName() == name) {
       return CreateDxcPixVariable(ppVariable, VarInfo);
@@ -169,7 +169,7 @@ STDMETHODIMP dxil_debug_info::DxcPixDxilLiveVariables::GetVariableByName(
 
 HRESULT dxil_debug_info::CreateDxilLiveVariables(
     DxcPixDxilDebugInfo *pDxilDebugInfo,
-    std::vector<const VariableInfo *> &&LiveVariables,
+    SharedLiveVariableList LiveVariables,
     IDxcPixDxilLiveVariables **ppResult) {
   return NewDxcPixDxilDebugInfoObjectOrThrow<DxcPixDxilLiveVariables>(
       ppResult, pDxilDebugInfo->GetMallocNoRef(), pDxilDebugInfo,
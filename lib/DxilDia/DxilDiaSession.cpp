@@ -12,7 +12,10 @@
 #include "DxilDiaSession.h"
 
 #include "dxc/DxilPIXPasses/DxilPIXVirtualRegisters.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instruction.h"
@@ -29,6 +32,9 @@
 #include "DxilDiaTableSourceFiles.h"
 #include "DxilDiaTableSymbols.h"
 
+#include <algorithm>
+#include <tuple>
+
 void dxil_dia::Session::Init(std::shared_ptr<llvm::LLVMContext> context,
                              std::shared_ptr<llvm::Module> mod,
                              std::shared_ptr<llvm::DebugInfoFinder> finder) {
@@ -96,6 +102,62 @@ void dxil_dia::Session::Init(std::shared_ptr<llvm::LLVMContext> context,
     DXASSERT(m_rvaMap[It->second] == It->first,
              "instruction mapped to wrong rva");
   }
+
+  // The map is already ordered by rva, so this yields a sorted flat array.
+  m_instructionsByRva.assign(m_instructions.begin(), m_instructions.end());
+}
+
+static bool GetScopeFileName(llvm::MDNode *pScope, llvm::StringRef *pName) {
+  if (auto *pBlock = llvm::dyn_cast_or_null<llvm::DILexicalBlock>(pScope)) {
+    *pName = pBlock->getFile()->getFilename();
+    return true;
+  }
+  if (auto *pSubProgram = llvm::dyn_cast_or_null<llvm::DISubprogram>(pScope)) {
+    *pName = pSubProgram->getFile()->getFilename();
+    return true;
+  }
+  return false;
+}
+
+const std::vector<dxil_dia::Session::FileLineEntry> &
+dxil_dia::Session::FileLineIndexRef() {
+  if (m_fileLineIndexBuilt)
+    return m_fileLineIndex;
+  m_fileLineIndexBuilt = true;
+
+  // Resolve each distinct file name once; this matches what
+  // LineNumber::get_sourceFileId reports for the instruction.
+  llvm::DenseMap<llvm::MDNode *, DWORD> scopeToFileId;
+  llvm::StringMap<DWORD> nameToFileId;
+  m_fileLineIndex.reserve(m_instructionLines.size());
+  for (const llvm::Instruction *I : m_instructionLines) {
+    const llvm::DebugLoc &DL = I->getDebugLoc();
+    llvm::MDNode *pScope = DL.getScope();
+    auto scopeIt = scopeToFileId.find(pScope);
+    if (scopeIt == scopeToFileId.end()) {
+      DWORD fileId = kNoSourceFileId;
+      llvm::StringRef fileName;
+      if (GetScopeFileName(pScope, &fileName)) {
+        auto nameIt = nameToFileId.find(fileName);
+        if (nameIt == nameToFileId.end()) {
+          DWORD id;
+          if (getSourceFileIdByName(fileName, &id) != S_OK)
+            id = kNoSourceFileId;
+          nameIt = nameToFileId.insert(std::make_pair(fileName, id)).first;
+        }
+        fileId = nameIt->second;
+      }
+      scopeIt = scopeToFileId.insert(std::make_pair(pScope, fileId)).first;
+    }
+    m_fileLineIndex.emplace_back(scopeIt->second, DL.getLine(), I);
+  }
+
+  std::stable_sort(m_fileLineIndex.begin(), m_fileLineIndex.end(),
+                   [](const FileLineEntry &a, const FileLineEntry &b) {
+                     return std::tie(a.FileId, a.Line) <
+                            std::tie(b.FileId, b.Line);
+                   });
+  return m_fileLineIndex;
 }
 
 const dxil_dia::SymbolManager &dxil_dia::Session::SymMgr() {
@@ -232,18 +294,31 @@ static HRESULT DxcDiaFindLineNumbersByRVA(Session *pSession, DWORD rva,
     return E_POINTER;
 
   std::vector<const llvm::Instruction *> instructions;
-  auto &allInstructions = pSession->InstructionsRef();
-
-  // Gather the list of insructions that map to the given rva range.
-  for (DWORD i = rva; i < rva + length; ++i) {
-    auto It = allInstructions.find(i);
-    if (It == allInstructions.end())
+  auto &allInstructions = pSession->InstructionsByRvaRef();
+
+  // Gather the list of insructions that map to the given rva range. Every
+  // rva in the range must map to an instruction; since rvas are unique and
+  // sorted, that holds iff the slice starting at rva has length entries and
+  // ends at the last rva of the range.
+  if (length != 0) {
+    auto Begin = std::lower_bound(
+        allInstructions.begin(), allInstructions.end(), rva,
+        [](const Session::RVAInstruction &Entry, DWORD Rva) {
+          return Entry.first < Rva;
+        });
+    if ((uint64_t)(allInstructions.end() - Begin) < length)
+      return E_INVALIDARG;
+    auto End = Begin + length;
+    if (Begin->first != rva ||
+        (uint64_t)(End - 1)->first != (uint64_t)rva + length - 1)
       return E_INVALIDARG;
 
-    // Only include the instruction if it has debug info for line mappings.
-    const llvm::Instruction *inst = It->second;
-    if (inst->getDebugLoc())
-      instructions.push_back(inst);
+    for (auto It = Begin; It != End; ++It) {
+      // Only include the instruction if it has debug info for line mappings.
+      const llvm::Instruction *inst = It->second;
+      if (inst->getDebugLoc())
+        instructions.push_back(inst);
+    }
   }
 
   // Create line number table from explicit instruction list.
@@ -296,17 +371,6 @@ STDMETHODIMP dxil_dia::Session::findLinesByLinenum(
   *ppResult = nullptr;
 
   DxcThreadMalloc TM(m_pMalloc);
-  CComPtr<IDiaTable> pTable;
-  VARIANT vtIndex;
-  vtIndex.vt = VT_UI4;
-  vtIndex.uintVal = (int)Table::Kind::LineNumbers;
-  IFR(m_pEnumTables->Item(vtIndex, &pTable));
-
-  CComPtr<IDiaEnumLineNumbers> pLineTable;
-  IFR(pTable->QueryInterface(&pLineTable));
-  HRESULT hr;
-  CComPtr<IDiaLineNumber> line;
-  ULONG cnt;
   std::vector<const llvm::Instruction *> lines;
 
   std::function<bool(DWORD, DWORD)> column_matches =
@@ -318,22 +382,28 @@ STDMETHODIMP dxil_dia::Session::findLinesByLinenum(
     };
   }
 
-  pLineTable->Reset();
-  while (SUCCEEDED(hr = pLineTable->Next(1, &line, &cnt)) && hr == S_OK &&
-         cnt == 1) {
-    CComPtr<IDiaSourceFile> f;
-    DWORD ln, lnEnd, cn, cnEnd;
-    IFR(line->get_lineNumber(&ln));
-    IFR(line->get_lineNumberEnd(&lnEnd));
-    IFR(line->get_columnNumber(&cn));
-    IFR(line->get_columnNumberEnd(&cnEnd));
-    IFR(line->get_sourceFile(&f));
-
-    if (file == f && (ln <= linenum && linenum <= lnEnd) &&
-        column_matches(cn, cnEnd)) {
-      lines.emplace_back(reinterpret_cast<LineNumber *>(line.p)->Inst());
+  // Only files handed out by this session's source file table can match.
+  DWORD fileId = kNoSourceFileId;
+  bool fileMatches = true;
+  if (file != nullptr) {
+    CComPtr<IDiaSourceFile> pSessionFile;
+    fileMatches = SUCCEEDED(file->get_uniqueId(&fileId)) &&
+                  SUCCEEDED(findFileById(fileId, &pSessionFile)) &&
+                  pSessionFile.p == file;
+  }
+
+  if (fileMatches) {
+    const std::vector<FileLineEntry> &index = FileLineIndexRef();
+    auto range = std::equal_range(
+        index.begin(), index.end(), FileLineEntry(fileId, linenum, nullptr),
+        [](const FileLineEntry &a, const FileLineEntry &b) {
+          return std::tie(a.FileId, a.Line) < std::tie(b.FileId, b.Line);
+        });
+    for (auto It = range.first; It != range.second; ++It) {
+      DWORD col = It->Inst->getDebugLoc().getCol();
+      if (column_matches(col, col))
+        lines.emplace_back(It->Inst);
     }
-    line.Release();
   }
 
   HRESULT result = lines.empty() ? S_FALSE : S_OK;
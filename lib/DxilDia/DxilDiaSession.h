@@ -45,6 +45,22 @@ public:
   };
   using LineToInfoMap = std::unordered_map<std::uint32_t, LineInfo>;
 
+  // Flat, RVA-sorted copy of the instruction map for range queries.
+  using RVAInstruction = std::pair<RVA, const llvm::Instruction *>;
+
+  // Entry of the (source file, line) -> instruction index.
+  struct FileLineEntry {
+    FileLineEntry(DWORD fileId, std::uint32_t line,
+                  const llvm::Instruction *inst)
+        : FileId(fileId), Line(line), Inst(inst) {}
+
+    DWORD FileId;
+    std::uint32_t Line;
+    const llvm::Instruction *Inst;
+  };
+  // File id used for instructions whose scope has no known source file.
+  static constexpr DWORD kNoSourceFileId = ~0u;
+
   DXC_MICROCOM_TM_ADDREF_RELEASE_IMPL()
   DXC_MICROCOM_TM_CTOR(Session)
 
@@ -63,6 +79,9 @@ public:
   llvm::DebugInfoFinder &InfoRef() { return *m_finder.get(); }
   const SymbolManager &SymMgr();
   const RVAMap &InstructionsRef() const { return m_instructions; }
+  const std::vector<RVAInstruction> &InstructionsByRvaRef() const {
+    return m_instructionsByRva;
+  }
   const std::vector<const llvm::Instruction *> &InstructionLinesRef() const {
     return m_instructionLines;
   }
@@ -75,6 +94,10 @@ public:
 
   HRESULT getSourceFileIdByName(llvm::StringRef fileName, DWORD *pRetVal);
 
+  // Instructions with line info, sorted by (file id, line) and then by their
+  // order in InstructionLinesRef(). Built on first use.
+  const std::vector<FileLineEntry> &FileLineIndexRef();
+
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
                                            void **ppvObject) override {
     return DoBasicQueryInterface<IDiaSession, IDxcPixDxilDebugInfoFactory>(
@@ -494,11 +517,14 @@ private:
   llvm::NamedMDNode *m_mainFileName;
   llvm::NamedMDNode *m_arguments;
   RVAMap m_instructions;
+  std::vector<RVAInstruction> m_instructionsByRva;
   std::vector<const llvm::Instruction *>
       m_instructionLines; // Instructions with line info.
   std::unordered_map<const llvm::Instruction *, RVA>
       m_rvaMap; // Map instruction to its RVA.
   LineToInfoMap m_lineToInfoMap;
+  std::vector<FileLineEntry> m_fileLineIndex;
+  bool m_fileLineIndexBuilt = false;
   std::unique_ptr<SymbolManager> m_symsMgr;
 
 private:
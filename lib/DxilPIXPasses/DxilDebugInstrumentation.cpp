@@ -26,6 +26,7 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/MathExtras.h"
 
 #include "PixPassHelpers.h"
 
@@ -133,6 +134,22 @@ using namespace hlsl;
 // condition to the caller.
 // In all overflow cases, the caller is expected to try to instrument again,
 // with a larger UAV.
+//
+// Compact encoding:
+// When the "compact" option is set, two changes are made to the trace in order
+// to fit more of it into a given UAV. First, the block header shrinks to two
+// DWORDs (header and instance identifier): the header's flags carry
+// CompactBlockFlag and its payload carries the index of the block's precis
+// line, from which the caller already knows the block's first instruction
+// ordinal and instruction count. Second, SSA values narrower than 32 bits are
+// bit-packed instead of each being widened to a DWORD: bools take one bit,
+// 8-bit ints one byte and 16-bit ints and halfs one 16-bit lane. Packed values
+// fill a DWORD from the least significant bit upwards, each aligned to its own
+// width. The DWORD is written out when the next value doesn't fit, when a
+// full-width value follows, or at the end of the block. The precis reports
+// packed values with their own type codes (see
+// FindInstrumentableInstructionsInBlock) and begins with an
+// "Encoding:Compact" line so the caller knows which layout to decode.
 
 // These definitions echo those in the debugger application's
 // debugshaderrecord.h file
@@ -205,6 +222,23 @@ struct DebugShaderModifierRecordDXILBlock {
   uint32_t FirstInstructionOrdinal;
 };
 
+// Not present in debugshaderrecord.h: the block header used by the compact
+// encoding. BlockIndex is the ordinal of the block's precis line.
+struct DebugShaderModifierRecordDXILCompactBlock {
+  union {
+    struct {
+      uint32_t NotUsed0 : 4;
+      uint32_t Flags : 4;
+      uint32_t Type : 8;
+      uint32_t BlockIndex : 16;
+    } Details;
+    uint32_t u32Header;
+  } Header;
+  uint32_t UID;
+};
+
+static constexpr uint32_t CompactBlockFlag = 1;
+
 template <typename ReturnType>
 struct DebugShaderModifierRecordDXILStep
     : public DebugShaderModifierRecordDXILStepBase {
@@ -284,6 +318,9 @@ private:
 
   uint64_t m_UAVSize = 1024 * 1024;
   unsigned m_upstreamSVPositionRow;
+  bool m_CompactEncoding = false;
+  // Count of precis "Block#" lines emitted so far for this module:
+  uint32_t m_BlockPrecisIndex = 0;
 
   struct PerFunctionValues {
     CallInst *UAVHandle = nullptr;
@@ -362,16 +399,30 @@ private:
     DebugShaderModifierRecordType ValueType;
     Instruction *InstructionAfterWhichToAddInstrumentation;
     Instruction *InstructionBeforeWhichToAddInstrumentation;
+    // Non-zero if the value is bit-packed by the compact encoding:
+    uint32_t PackedBits;
   };
   struct BlockInstrumentationData {
     uint32_t FirstInstructionOrdinalInBlock;
+    uint32_t PrecisIndex;
     std::vector<InstructionToInstrument> Instructions;
   };
+  // Accumulates bit-packed values until a full DWORD can be written:
+  struct PackedDebugEntry {
+    Value *Bits = nullptr;
+    uint32_t UsedBits = 0;
+  };
   BlockInstrumentationData FindInstrumentableInstructionsInBlock(
       BasicBlock &BB, OP *HlslOP,
       llvm::SmallPtrSetImpl<Value *> const &RayQueryHandles);
   uint32_t
   CountBlockPayloadBytes(std::vector<InstructionToInstrument> const &IsAndTs);
+  uint32_t CountCompactBlockPayloadBytes(
+      std::vector<InstructionToInstrument> const &IsAndTs);
+  void addPackedDebugEntryValue(BuilderContext &BC, PackedDebugEntry &Pending,
+                                Value *TheValue, uint32_t Bits);
+  void flushPackedDebugEntryValue(BuilderContext &BC,
+                                  PackedDebugEntry &Pending);
 };
 
 void DxilDebugInstrumentation::applyOptions(PassOptions O) {
@@ -384,6 +435,7 @@ void DxilDebugInstrumentation::applyOptions(PassOptions O) {
   GetPassOptionUInt64(O, "UAVSize", &m_UAVSize, 1024 * 1024);
   GetPassOptionUnsigned(O, "upstreamSVPositionRow", &m_upstreamSVPositionRow,
                         0);
+  GetPassOptionBool(O, "compact", &m_CompactEncoding, false);
 }
 
 uint32_t DxilDebugInstrumentation::UAVDumpingGroundOffset() {
@@ -945,6 +997,38 @@ uint32_t DxilDebugInstrumentation::addDebugEntryValue(BuilderContext &BC,
   return BytesToBeEmitted;
 }
 
+void DxilDebugInstrumentation::addPackedDebugEntryValue(
+    BuilderContext &BC, PackedDebugEntry &Pending, Value *TheValue,
+    uint32_t Bits) {
+  uint32_t Offset =
+      static_cast<uint32_t>(RoundUpToAlignment(Pending.UsedBits, Bits));
+  if (Offset + Bits > 32) {
+    flushPackedDebugEntryValue(BC, Pending);
+    Offset = 0;
+  }
+
+  Value *AsInt = TheValue;
+  if (TheValue->getType()->isHalfTy())
+    AsInt = BC.Builder.CreateBitCast(TheValue, Type::getInt16Ty(BC.Ctx),
+                                     "HalfBits");
+  Value *Lane =
+      BC.Builder.CreateZExt(AsInt, Type::getInt32Ty(BC.Ctx), "PackedLane");
+  if (Offset != 0)
+    Lane = BC.Builder.CreateShl(Lane, Offset, "PackedLaneShifted");
+  Pending.Bits = Pending.Bits == nullptr
+                     ? Lane
+                     : BC.Builder.CreateOr(Pending.Bits, Lane, "PackedDword");
+  Pending.UsedBits = Offset + Bits;
+}
+
+void DxilDebugInstrumentation::flushPackedDebugEntryValue(
+    BuilderContext &BC, PackedDebugEntry &Pending) {
+  if (Pending.Bits == nullptr)
+    return;
+  addDebugEntryValue(BC, Pending.Bits);
+  Pending = PackedDebugEntry();
+}
+
 void DxilDebugInstrumentation::addInvocationStartMarker(BuilderContext &BC) {
   DebugShaderModifierRecordHeader marker{{{0, 0, 0, 0}}, 0};
   reserveDebugEntrySpace(BC, sizeof(marker));
@@ -1215,6 +1299,9 @@ bool DxilDebugInstrumentation::runOnModule(Module &M) {
   if (OSOverride == nullptr)
     return false;
 
+  if (m_CompactEncoding)
+    *OSOverride << "Encoding:Compact\n";
+
   auto ShaderModel = DM.GetShaderModel();
   auto shaderKind = ShaderModel->GetKind();
   auto HLSLBindId = 0;
@@ -1270,6 +1357,59 @@ uint32_t DxilDebugInstrumentation::CountBlockPayloadBytes(
   return count;
 }
 
+// Mirrors the packing done by addPackedDebugEntryValue, so that exactly the
+// space that will be written is reserved.
+uint32_t DxilDebugInstrumentation::CountCompactBlockPayloadBytes(
+    std::vector<InstructionToInstrument> const &IsAndTs) {
+  uint32_t count = 0;
+  uint32_t UsedBits = 0;
+  for (auto const &IandT : IsAndTs) {
+    if (IandT.PackedBits == 0) {
+      if (UsedBits != 0) {
+        count += 4;
+        UsedBits = 0;
+      }
+      Type *Ty = IandT.ValueToWriteToDebugMemory->getType();
+      count += (Ty->isDoubleTy() || Ty->isIntegerTy(64)) ? 8 : 4;
+    } else {
+      uint32_t Offset = static_cast<uint32_t>(
+          RoundUpToAlignment(UsedBits, IandT.PackedBits));
+      if (Offset + IandT.PackedBits > 32) {
+        count += 4;
+        Offset = 0;
+      }
+      UsedBits = Offset + IandT.PackedBits;
+    }
+  }
+  if (UsedBits != 0)
+    count += 4;
+  return count;
+}
+
+// Width in bits of a value under the compact encoding, or zero if the value
+// is written as one or more full DWORDs.
+static uint32_t CompactPackedBits(Type *Ty) {
+  if (Ty->isHalfTy())
+    return 16;
+  if (Ty->isIntegerTy(1))
+    return 1;
+  if (Ty->isIntegerTy(8))
+    return 8;
+  if (Ty->isIntegerTy(16))
+    return 16;
+  return 0;
+}
+
+static const char *CompactPackedTypeString(Type *Ty) {
+  if (Ty->isHalfTy())
+    return "h";
+  if (Ty->isIntegerTy(1))
+    return "1";
+  if (Ty->isIntegerTy(8))
+    return "8";
+  return "w";
+}
+
 const char *TypeString(InstructionAndType const &IandT) {
   auto datum = FindDatum(IandT.Type);
   if (datum)
@@ -1295,6 +1435,8 @@ Instruction *FindFirstNonPhiInstruction(Instruction *I) {
 // (delimited by ,) are, in order:
 // -instruction ordinal
 // -data type (r=ret, v=void, f=float, 3=int32, 6=int64, d=double)
+//  With the compact encoding, bit-packed values instead report 1=bool,
+//  8=int8, w=int16 or h=half.
 // -scalar register number
 // -alloca/scalar indicator:
 // r == ret instruction
@@ -1317,6 +1459,7 @@ DxilDebugInstrumentation::FindInstrumentableInstructionsInBlock(
     BasicBlock &BB, OP *HlslOP,
     llvm::SmallPtrSetImpl<Value *> const &RayQueryHandles) {
   BlockInstrumentationData ret{};
+  ret.PrecisIndex = m_BlockPrecisIndex++;
   auto &Is = BB.getInstList();
   *OSOverride << "Block#";
   bool FoundFirstInstruction = false;
@@ -1376,10 +1519,17 @@ DxilDebugInstrumentation::FindInstrumentableInstructionsInBlock(
         IndexingToken = "a"; // meaning an SSA assignment
         // todo: Can SSA Values be assigned a literal constant?
         DebugOutputForThisInstruction.ValueToWriteToDebugMemory = IandT->Inst;
+        if (m_CompactEncoding)
+          DebugOutputForThisInstruction.PackedBits =
+              CompactPackedBits(IandT->Inst->getType());
       }
 
+      const char *DataType =
+          DebugOutputForThisInstruction.PackedBits != 0
+              ? CompactPackedTypeString(IandT->Inst->getType())
+              : TypeString(*IandT);
       *OSOverride << std::to_string(IandT->InstructionOrdinal) << ","
-                  << TypeString(*IandT) << ","
+                  << DataType << ","
                   << std::to_string(IandT->RegisterNumber) << ","
                   << IndexingToken;
       if (RegisterOrStaticIndex) {
@@ -1473,8 +1623,14 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
           BlockInstrumentation.FirstInstructionOrdinalInBlock >=
               m_LastInstruction)
         continue;
+      // The compact header's 16-bit block index can't describe blocks beyond
+      // the first 64K, so those fall back to the full header:
+      const bool CompactHeader =
+          m_CompactEncoding && BlockInstrumentation.PrecisIndex <= 0xFFFF;
       uint32_t BlockPayloadBytes =
-          CountBlockPayloadBytes(BlockInstrumentation.Instructions);
+          m_CompactEncoding
+              ? CountCompactBlockPayloadBytes(BlockInstrumentation.Instructions)
+              : CountBlockPayloadBytes(BlockInstrumentation.Instructions);
       // If the block has no instructions which require debug output,
       // we will still write an empty block header at the end of that
       // block (i.e. before the terminator) so that the instrumentation
@@ -1497,24 +1653,40 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
       BuilderContext BCForBlock{BC.M, BC.DM, BC.Ctx, BC.HlslOP, Builder};
 
       DebugShaderModifierRecordDXILBlock step = {};
-      auto FullRecordSize =
-          static_cast<uint32_t>(sizeof(step) + BlockPayloadBytes);
+      DebugShaderModifierRecordDXILCompactBlock compactStep = {};
+      auto FullRecordSize = static_cast<uint32_t>(
+          (CompactHeader ? sizeof(compactStep) : sizeof(step)) +
+          BlockPayloadBytes);
       if (FullRecordSize >= (m_UAVSize / 4) - 1) {
         *OSOverride << "StaticOverflow:" << std::to_string(FullRecordSize)
                     << "\n";
         break;
       }
       reserveDebugEntrySpace(BCForBlock, FullRecordSize);
-      step.Header.Details.CountOfInstructions =
-          static_cast<uint16_t>(BlockInstrumentation.Instructions.size());
-      step.Header.Details.Type =
-          static_cast<uint8_t>(DebugShaderModifierRecordTypeDXILStepBlock);
-      addDebugEntryValue(BCForBlock,
-                         BCForBlock.HlslOP->GetU32Const(step.Header.u32Header));
-      addDebugEntryValue(BCForBlock, values.InvocationId);
-      addDebugEntryValue(
-          BCForBlock, BCForBlock.HlslOP->GetU32Const(
-                          BlockInstrumentation.FirstInstructionOrdinalInBlock));
+      if (CompactHeader) {
+        compactStep.Header.Details.Flags = CompactBlockFlag;
+        compactStep.Header.Details.BlockIndex =
+            static_cast<uint16_t>(BlockInstrumentation.PrecisIndex);
+        compactStep.Header.Details.Type =
+            static_cast<uint8_t>(DebugShaderModifierRecordTypeDXILStepBlock);
+        addDebugEntryValue(BCForBlock, BCForBlock.HlslOP->GetU32Const(
+                                           compactStep.Header.u32Header));
+        addDebugEntryValue(BCForBlock, values.InvocationId);
+      } else {
+        step.Header.Details.CountOfInstructions =
+            static_cast<uint16_t>(BlockInstrumentation.Instructions.size());
+        step.Header.Details.Type =
+            static_cast<uint8_t>(DebugShaderModifierRecordTypeDXILStepBlock);
+        addDebugEntryValue(BCForBlock, BCForBlock.HlslOP->GetU32Const(
+                                           step.Header.u32Header));
+        addDebugEntryValue(BCForBlock, values.InvocationId);
+        addDebugEntryValue(
+            BCForBlock,
+            BCForBlock.HlslOP->GetU32Const(
+                BlockInstrumentation.FirstInstructionOrdinalInBlock));
+      }
+      PackedDebugEntry Pending;
+      Instruction *LastBuilderInstruction = nullptr;
       for (auto &Inst : BlockInstrumentation.Instructions) {
         Instruction *BuilderInstruction;
         if (Inst.InstructionAfterWhichToAddInstrumentation != nullptr)
@@ -1528,7 +1700,19 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
         }
         IRBuilder<> Builder(BuilderInstruction);
         BuilderContext BC2{BC.M, BC.DM, BC.Ctx, BC.HlslOP, Builder};
-        addDebugEntryValue(BC2, Inst.ValueToWriteToDebugMemory);
+        if (Inst.PackedBits != 0) {
+          addPackedDebugEntryValue(BC2, Pending, Inst.ValueToWriteToDebugMemory,
+                                   Inst.PackedBits);
+        } else {
+          flushPackedDebugEntryValue(BC2, Pending);
+          addDebugEntryValue(BC2, Inst.ValueToWriteToDebugMemory);
+        }
+        LastBuilderInstruction = BuilderInstruction;
+      }
+      if (Pending.Bits != nullptr) {
+        IRBuilder<> Builder(LastBuilderInstruction);
+        BuilderContext BC2{BC.M, BC.DM, BC.Ctx, BC.HlslOP, Builder};
+        flushPackedDebugEntryValue(BC2, Pending);
       }
     }
   }
@@ -11,7 +11,8 @@ using namespace hlsl;
 
 HRESULT hlsl::WritePdbInfoPart(IMalloc *pMalloc,
                                const void *pUncompressedPdbInfoData,
-                               size_t size, std::vector<char> *outBuffer) {
+                               size_t size, std::vector<char> *outBuffer,
+                               bool bParallelDeflate) {
   // Write to the output buffer.
   outBuffer->clear();
 
@@ -29,7 +30,7 @@ HRESULT hlsl::WritePdbInfoPart(IMalloc *pMalloc,
 
   // Then write the compressed RDAT data.
   hlsl::ZlibResult result = hlsl::ZlibCompressAppend(
-      pMalloc, pUncompressedPdbInfoData, size, *outBuffer);
+      pMalloc, pUncompressedPdbInfoData, size, *outBuffer, bParallelDeflate);
 
   if (result == hlsl::ZlibResult::OutOfMemory)
     IFTBOOL(false, E_OUTOFMEMORY);
@@ -1269,7 +1269,8 @@ static HRESULT ValidateLoadModuleFromContainer(
     const void *pContainer, uint32_t ContainerSize,
     std::unique_ptr<llvm::Module> &pModule,
     std::unique_ptr<llvm::Module> &pDebugModule, llvm::LLVMContext &Ctx,
-    LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream, unsigned bLazyLoad) {
+    LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream, unsigned bLazyLoad,
+    bool bSkipProgramIfDebug) {
   llvm::DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
   PrintDiagnosticContext DiagContext(DiagPrinter);
   DiagRestore DR(Ctx, &DiagContext);
@@ -1278,14 +1279,6 @@ static HRESULT ValidateLoadModuleFromContainer(
   const DxilPartHeader *pPart = nullptr;
   IFR(FindDxilPart(pContainer, ContainerSize, DFCC_DXIL, &pPart));
 
-  const char *pIL = nullptr;
-  uint32_t ILLength = 0;
-  GetDxilProgramBitcode(
-      reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pPart)), &pIL,
-      &ILLength);
-
-  IFR(ValidateLoadModule(pIL, ILLength, pModule, Ctx, DiagStream, bLazyLoad));
-
   HRESULT hr;
   const DxilPartHeader *pDbgPart = nullptr;
   if (FAILED(hr = FindDxilPart(pContainer, ContainerSize,
@@ -1294,6 +1287,17 @@ static HRESULT ValidateLoadModuleFromContainer(
     return hr;
   }
 
+  const char *pIL = nullptr;
+  uint32_t ILLength = 0;
+  if (!pDbgPart || !bSkipProgramIfDebug) {
+    GetDxilProgramBitcode(
+        reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pPart)),
+        &pIL, &ILLength);
+
+    IFR(ValidateLoadModule(pIL, ILLength, pModule, Ctx, DiagStream,
+                           bLazyLoad));
+  }
+
   if (pDbgPart) {
     GetDxilProgramBitcode(
         reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pDbgPart)),
@@ -1314,17 +1318,20 @@ HRESULT ValidateLoadModuleFromContainer(
     llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream) {
   return ValidateLoadModuleFromContainer(pContainer, ContainerSize, pModule,
                                          pDebugModule, Ctx, DbgCtx, DiagStream,
-                                         /*bLazyLoad*/ false);
+                                         /*bLazyLoad*/ false,
+                                         /*bSkipProgramIfDebug*/ false);
 }
 // Lazy loads module from container, validating load, but not module.
 HRESULT ValidateLoadModuleFromContainerLazy(
     const void *pContainer, uint32_t ContainerSize,
     std::unique_ptr<llvm::Module> &pModule,
     std::unique_ptr<llvm::Module> &pDebugModule, llvm::LLVMContext &Ctx,
-    llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream) {
+    llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream,
+    bool bSkipProgramIfDebug) {
   return ValidateLoadModuleFromContainer(pContainer, ContainerSize, pModule,
                                          pDebugModule, Ctx, DbgCtx, DiagStream,
-                                         /*bLazyLoad*/ true);
+                                         /*bLazyLoad*/ true,
+                                         bSkipProgramIfDebug);
 }
 
 HRESULT ValidateDxilContainer(const void *pContainer, uint32_t ContainerSize,
@@ -107,8 +107,8 @@ static std::string createDumpPath(const std::string &baseName, unsigned id,
   return insertBeforeExtension(baseName, s);
 }
 
-// Return byte offset aligned to the alignment required by inst.
-static uint64_t align(uint64_t offset, Instruction *inst, DataLayout &DL) {
+// Return the alignment in bytes required by inst.
+static unsigned getAlignment(Instruction *inst, DataLayout &DL) {
   unsigned alignment = 0;
   if (AllocaInst *ai = dyn_cast<AllocaInst>(inst))
     alignment = ai->getAlignment();
@@ -116,7 +116,12 @@ static uint64_t align(uint64_t offset, Instruction *inst, DataLayout &DL) {
   if (alignment == 0)
     alignment = DL.getPrefTypeAlignment(inst->getType());
 
-  return RoundUpToAlignment(offset, alignment);
+  return alignment;
+}
+
+// Return byte offset aligned to the alignment required by inst.
+static uint64_t align(uint64_t offset, Instruction *inst, DataLayout &DL) {
+  return RoundUpToAlignment(offset, getAlignment(inst, DL));
 }
 
 template <class T> // T can be Value* or Instruction*
@@ -470,7 +475,7 @@ public:
         m_resources(resources) {}
 
   // Returns true if inst can be rematerialized.
-  bool canRematerialize(Instruction *inst) {
+  bool canRematerialize(Instruction *inst, int depth = 0) {
     if (CallInst *call = dyn_cast<CallInst>(inst)) {
       StringRef funcName = call->getCalledFunction()->getName();
       if (funcName.startswith("dummyStackFrameSize"))
@@ -481,6 +486,10 @@ public:
         return true;
       if (funcName.startswith("dx.op.createHandle"))
         return true;
+      // Constant buffer contents are uniform for the whole dispatch, so a
+      // load can be repeated after the continuation instead of being saved.
+      if (funcName.startswith("dx.op.cbufferLoad"))
+        return canRematerializeOperands(inst, depth);
     } else if (LoadInst *load = dyn_cast<LoadInst>(inst)) {
       Value *op = load->getOperand(0);
       if (GetElementPtrInst *gep =
@@ -493,6 +502,11 @@ public:
              "Unhandled non-constant index"); // Should have been changed to
                                               // stack.ptr
       return true;
+    } else if (isa<CastInst>(inst) || isa<BinaryOperator>(inst) ||
+               isa<CmpInst>(inst) || isa<SelectInst>(inst) ||
+               isa<ExtractValueInst>(inst)) {
+      // Cheap arithmetic is recomputed if everything it depends on can be.
+      return canRematerializeOperands(inst, depth);
     }
 
     return false;
@@ -502,13 +516,15 @@ public:
   // any nonrematerializable values that are live in the function, but not
   // at this callsite to the work list to insure that their values are restored.
   Instruction *rematerialize(Instruction *inst,
-                             std::vector<Instruction *> workList,
+                             std::vector<Instruction *> &workList,
                              Instruction *insertBefore, int depth = 0) {
     // Signal if we hit a complex case. Deep rematerialization needs more
     // analysis. To make this robust we would need to make it possible to run
     // the current value through the live value handling pipeline: figure out
     // where it is live, reg2mem, save/restore at appropriate callsites, etc.
-    assert(depth < 8);
+    // Cheap values add up to two levels of operands (each a reload, its alloca
+    // and the value) on top of the base cases, hence the headroom.
+    assert(depth < 16);
 
     // Reuse an already rematerialized value?
     auto it = m_rematMap.find(inst);
@@ -560,6 +576,36 @@ public:
     return clone;
   }
 
+  // Returns true if every operand of inst is a constant or a value that can
+  // itself be rematerialized, looking through the reg2mem'd reloads of live
+  // values.
+  bool canRematerializeOperands(Instruction *inst, int depth) {
+    // Keep within the depth that rematerialize() supports. Each level of
+    // operands may add a reload and its alloca on top of the value itself.
+    if (depth >= 2)
+      return false;
+
+    for (Value *op : inst->operands()) {
+      if (isa<Constant>(op))
+        continue;
+      Instruction *opInst = dyn_cast<Instruction>(op);
+      if (!opInst)
+        return false;
+      if (LoadInst *reload = dyn_cast<LoadInst>(opInst)) {
+        if (AllocaInst *alloc =
+                dyn_cast<AllocaInst>(reload->getPointerOperand())) {
+          auto it = m_allocaToVal.find(alloc);
+          if (it == m_allocaToVal.end())
+            return false;
+          opInst = it->second;
+        }
+      }
+      if (!canRematerialize(opInst, depth + 1))
+        return false;
+    }
+    return true;
+  }
+
   Instruction *getRematerializedValueFor(Instruction *val) {
     auto it = m_rematMap.find(val);
     if (it != m_rematMap.end())
@@ -945,6 +991,8 @@ void StateFunctionTransform::preserveLiveValuesAcrossCallsites(
     Instruction *restoreStackFrameOffset =
         R.getRematerializedValueFor(m_stackFrameOffset);
 
+    std::vector<Instruction *> saved;
+    unsigned int rematCount = 0;
     while (!workList.empty()) {
       Instruction *inst = workList.back();
       workList.pop_back();
@@ -953,21 +1001,9 @@ void StateFunctionTransform::preserveLiveValuesAcrossCallsites(
 
       if (!R.canRematerialize(inst)) {
         assert(!inst->getType()->isPointerTy() && "Can not save pointers");
-
-        offsetInBytes = align(offsetInBytes, inst, DL);
-        AllocaInst *alloca = valToAlloca[inst];
-
-        Value *saveVal = new LoadInst(
-            alloca, addSuffix(inst->getName(), ".save"), saveInsertBefore);
-        createStackStore(saveStackFrameOffset, saveVal, offsetInBytes,
-                         saveInsertBefore);
-
-        Value *restoreVal = createStackLoad(restoreStackFrameOffset, inst,
-                                            offsetInBytes, restoreInsertBefore);
-        new StoreInst(restoreVal, alloca, restoreInsertBefore);
-
-        offsetInBytes += DL.getTypeAllocSize(inst->getType());
+        saved.push_back(inst);
       } else if (R.getRematerializedValueFor(inst) == nullptr) {
+        ++rematCount;
         if (!rematInsertBefore) {
           // Create a new block after restores for rematerialized values. This
           // ensures that we can use restored values (through their allocas)
@@ -983,6 +1019,35 @@ void StateFunctionTransform::preserveLiveValuesAcrossCallsites(
       }
     }
 
+    // Lay out the saved values largest alignment first so that no padding
+    // is needed between them.
+    std::stable_sort(saved.begin(), saved.end(),
+                     [&DL](Instruction *a, Instruction *b) {
+                       return getAlignment(a, DL) > getAlignment(b, DL);
+                     });
+    for (Instruction *inst : saved) {
+      offsetInBytes = align(offsetInBytes, inst, DL);
+      AllocaInst *alloca = valToAlloca[inst];
+
+      Value *saveVal = new LoadInst(
+          alloca, addSuffix(inst->getName(), ".save"), saveInsertBefore);
+      createStackStore(saveStackFrameOffset, saveVal, offsetInBytes,
+                       saveInsertBefore);
+
+      Value *restoreVal = createStackLoad(restoreStackFrameOffset, inst,
+                                          offsetInBytes, restoreInsertBefore);
+      new StoreInst(restoreVal, alloca, restoreInsertBefore);
+
+      offsetInBytes += DL.getTypeAllocSize(inst->getType());
+    }
+
+    m_continuationFrameSizes.push_back(
+        static_cast<unsigned int>(offsetInBytes - baseOffsetInBytes));
+    if (m_verbose)
+      DBGS() << "continuation " << i << ": saved " << saved.size()
+             << " values in " << m_continuationFrameSizes.back()
+             << " bytes, rematerialized " << rematCount << "\n";
+
     // Take the max offset over all call sites
     maxOffsetInBytes = std::max(maxOffsetInBytes, offsetInBytes);
   }
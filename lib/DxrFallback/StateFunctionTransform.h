@@ -62,8 +62,10 @@ typedef llvm::SetVector<llvm::Instruction *> InstructionSetVector;
 // stack. Any values that are live across continuations, like foo in this
 // example, must also be saved to the stack before the continuation and restored
 // before use. Some values, like DXIL buffer handles should not be saved and
-// must be rematerialized after a continuation. The stack frame in a state
-// function has the following layout:
+// must be rematerialized after a continuation. Values that are cheap to
+// recompute (constant buffer loads, and casts, arithmetic and compares whose
+// operands can all be rematerialized) are rematerialized as well rather than
+// being saved. The stack frame in a state function has the following layout:
 //
 //   |               |
 //   +---------------+
@@ -88,7 +90,9 @@ typedef llvm::SetVector<llvm::Instruction *> InstructionSetVector;
 // function arguments, if any. The saved values follow the argument frame.
 // Instead of adjusting the size of the stack frame for the saved values and
 // argument frames of each continuation a single allocation is made with enough
-// space to accommodate all continuations in the function.
+// space to accommodate all continuations in the function. The saved values of
+// each continuation all start at the same offset, ordered by decreasing
+// alignment, so the region is only as large as the largest continuation's set.
 //
 // Several placeholder functions are used during the process of the state
 // function transform to break dependency cycles. A placeholder for the runtime
@@ -205,6 +209,12 @@ public:
   // Outputs detailed diagnostic information if set to true.
   void setVerbose(bool val);
 
+  // Size in bytes of the values saved across each continuation, in call site
+  // order. Valid after run().
+  const std::vector<unsigned int> &getContinuationFrameSizes() const {
+    return m_continuationFrameSizes;
+  }
+
   void setDumpFilename(const std::string &dumpFilename);
 
 private:
@@ -259,6 +269,7 @@ private:
 
   int m_maxCallerArgFrameSizeInBytes = 0;
   int m_traceFrameSizeInBytes = 0;
+  std::vector<unsigned int> m_continuationFrameSizes;
 
   // Functions used to abstract stack operations. These make intermediate stages
   // in the transform a little bit cleaner.
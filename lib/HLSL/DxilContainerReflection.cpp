@@ -12,6 +12,7 @@
 #include "dxc/DXIL/DxilCounters.h"
 #include "dxc/DXIL/DxilFunctionProps.h"
 #include "dxc/DXIL/DxilInstructions.h"
+#include "dxc/DXIL/DxilMetadataHelper.h"
 #include "dxc/DXIL/DxilModule.h"
 #include "dxc/DXIL/DxilOperations.h"
 #include "dxc/DXIL/DxilPDB.h"
@@ -2326,24 +2327,28 @@ HRESULT DxilModuleReflection::LoadProgramHeader(
     auto errorHandler = [&bBitcodeLoadError](const DiagnosticInfo &diagInfo) {
       bBitcodeLoadError |= diagInfo.getSeverity() == DS_Error;
     };
-#if 0 // We materialize eagerly, because we'll need to walk instructions to look
-      // for usage information.
+    // Load the header and metadata only. Function bodies are needed just to
+    // walk instructions for usage information, which validator 1.5 and later
+    // already record in metadata.
     ErrorOr<std::unique_ptr<Module>> mod =
         getLazyBitcodeModule(std::move(pMemBuffer), Context, errorHandler);
-#else
-    ErrorOr<std::unique_ptr<Module>> mod =
-        parseBitcodeFile(pMemBuffer->getMemBufferRef(), Context, errorHandler);
-#endif
     if (!mod || bBitcodeLoadError) {
       return E_INVALIDARG;
     }
     std::swap(m_pModule, mod.get());
-    m_pDxilModule = &m_pModule->GetOrCreateDxilModule();
 
+    // Materialize before creating the DxilModule, so that the operation
+    // cache sees the calls in function bodies.
     unsigned ValMajor, ValMinor;
-    m_pDxilModule->GetValidatorVersion(ValMajor, ValMinor);
+    DxilMDHelper(m_pModule.get(), nullptr)
+        .LoadValidatorVersion(ValMajor, ValMinor);
     m_bUsageInMetadata =
         hlsl::DXIL::CompareVersions(ValMajor, ValMinor, 1, 5) >= 0;
+    if (!m_bUsageInMetadata &&
+        (m_pModule->materializeAllPermanently() || bBitcodeLoadError)) {
+      return E_INVALIDARG;
+    }
+    m_pDxilModule = &m_pModule->GetOrCreateDxilModule();
 
     CreateReflectionObjects();
     return S_OK;
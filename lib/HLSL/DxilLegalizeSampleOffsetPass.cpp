@@ -242,7 +242,7 @@ void DxilLegalizeSampleOffsetPass::TryUnrollLoop(
 
   if (UnrollLoop) {
     DxilValueCache *DVC = &getAnalysis<DxilValueCache>();
-    DVC->ResetUnknowns();
+    DVC->ResetUnknowns(F);
   }
 }
 
@@ -17,6 +17,7 @@
 #include "dxc/DXIL/DxilSampler.h"
 #include "dxc/DXIL/DxilUtil.h"
 #include "dxc/Support/Global.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
@@ -29,6 +30,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -61,6 +63,26 @@ void CollectUsedFunctions(Constant *C, llvm::SetVector<Function *> &funcSet) {
   }
 }
 
+// Collects the globals referenced by C. A global used by another global's
+// initializer counts as used along with it, matching CollectUsedFunctions.
+void CollectUsedGlobals(Constant *C, SmallPtrSetImpl<Constant *> &visited,
+                        SmallVectorImpl<GlobalVariable *> &usedGVs) {
+  if (!visited.insert(C).second)
+    return;
+  if (GlobalVariable *GV = dyn_cast<GlobalVariable>(C)) {
+    usedGVs.emplace_back(GV);
+    if (GV->hasInitializer())
+      CollectUsedGlobals(GV->getInitializer(), visited, usedGVs);
+    return;
+  }
+  if (isa<GlobalValue>(C))
+    return;
+  for (Value *V : C->operand_values()) {
+    if (Constant *CV = dyn_cast<Constant>(V))
+      CollectUsedGlobals(CV, visited, usedGVs);
+  }
+}
+
 template <class T>
 void AddResourceMap(
     const std::vector<std::unique_ptr<T>> &resTab, DXIL::ResourceClass resClass,
@@ -101,6 +123,9 @@ namespace {
 struct DxilFunctionLinkInfo {
   DxilFunctionLinkInfo(llvm::Function *F);
   llvm::Function *func;
+  // Set once the body is materialized and usedFunctions and usedGVs are
+  // collected, so relinking registered libraries does not walk the body again.
+  bool bLoaded;
   // SetVectors for deterministic iteration
   llvm::SetVector<llvm::Function *> usedFunctions;
   llvm::SetVector<llvm::GlobalVariable *> usedGVs;
@@ -114,6 +139,7 @@ public:
   virtual ~DxilLib() {}
   bool HasFunction(std::string &name);
   llvm::StringMap<std::unique_ptr<DxilFunctionLinkInfo>> &GetFunctionTable() {
+    BuildFunctionTable();
     return m_functionNameMap;
   }
   bool IsInitFunc(llvm::Function *F);
@@ -130,17 +156,27 @@ public:
   void FixIntrinsicOverloads();
 
 private:
+  void BuildFunctionTable();
+
   std::unique_ptr<llvm::Module> m_pModule;
   DxilModule &m_DM;
   // Map from name to Link info for extern functions.
   llvm::StringMap<std::unique_ptr<DxilFunctionLinkInfo>> m_functionNameMap;
   llvm::SmallPtrSet<llvm::Function *, 4> m_entrySet;
+  // Position of each global in the module, to keep usedGVs in module order.
+  llvm::DenseMap<const llvm::GlobalVariable *, unsigned> m_globalOrder;
+  // The function table is built when the library is first attached, so
+  // registering a library does not walk its functions.
+  bool m_bFunctionTableBuilt = false;
   // Map from resource link global to resource. MapVector for deterministic
   // iteration.
   llvm::MapVector<const llvm::Constant *, DxilResourceBase *> m_resourceMap;
   // Set of initialize functions for global variable. SetVector for
   // deterministic iteration.
   llvm::SetVector<llvm::Function *> m_initFuncSet;
+  // Init functions and resource map only depend on the module, so they are
+  // built on the first link and reused when the library is linked again.
+  bool m_bInitFuncsAndResourcesBuilt = false;
 };
 
 struct DxilLinkJob;
@@ -182,7 +218,8 @@ private:
 //
 // DxilFunctionLinkInfo methods.
 //
-DxilFunctionLinkInfo::DxilFunctionLinkInfo(Function *F) : func(F) {
+DxilFunctionLinkInfo::DxilFunctionLinkInfo(Function *F)
+    : func(F), bLoaded(false) {
   DXASSERT_NOMSG(F);
 }
 
@@ -193,6 +230,13 @@ DxilFunctionLinkInfo::DxilFunctionLinkInfo(Function *F) : func(F) {
 
 DxilLib::DxilLib(std::unique_ptr<llvm::Module> pModule)
     : m_pModule(std::move(pModule)), m_DM(m_pModule->GetOrCreateDxilModule()) {
+}
+
+void DxilLib::BuildFunctionTable() {
+  if (m_bFunctionTableBuilt)
+    return;
+  m_bFunctionTableBuilt = true;
+
   Module &M = *m_pModule;
   const std::string MID = (Twine(M.getModuleIdentifier()) + ".").str();
 
@@ -211,11 +255,13 @@ DxilLib::DxilLib(std::unique_ptr<llvm::Module> pModule)
   }
 
   // Update internal global name.
+  unsigned globalIndex = 0;
   for (GlobalVariable &GV : M.globals()) {
     if (GV.getLinkage() == GlobalValue::LinkageTypes::InternalLinkage) {
       // Add prefix to internal global.
       GV.setName(MID + GV.getName());
     }
+    m_globalOrder[&GV] = globalIndex++;
   }
 }
 
@@ -230,17 +276,32 @@ void DxilLib::FixIntrinsicOverloads() {
 void DxilLib::LazyLoadFunction(Function *F) {
   DXASSERT(m_functionNameMap.count(F->getName()), "else invalid Function");
   DxilFunctionLinkInfo *linkInfo = m_functionNameMap[F->getName()].get();
+  if (linkInfo->bLoaded)
+    return;
   std::error_code EC = F->materialize();
   DXASSERT_LOCALVAR(EC, !EC, "else fail to materialize");
 
-  // Build used functions for F.
+  // Build used functions and used globals for F.
+  SmallPtrSet<Constant *, 16> visited;
+  SmallVector<GlobalVariable *, 16> usedGVs;
   for (auto &BB : F->getBasicBlockList()) {
     for (auto &I : BB.getInstList()) {
       if (CallInst *CI = dyn_cast<CallInst>(&I)) {
         linkInfo->usedFunctions.insert(CI->getCalledFunction());
       }
+      for (Value *V : I.operand_values()) {
+        if (Constant *C = dyn_cast<Constant>(V))
+          CollectUsedGlobals(C, visited, usedGVs);
+      }
     }
   }
+  // Globals are added to the linked module in usedGVs order, so keep the
+  // module order.
+  std::sort(usedGVs.begin(), usedGVs.end(),
+            [this](GlobalVariable *A, GlobalVariable *B) {
+              return m_globalOrder.lookup(A) < m_globalOrder.lookup(B);
+            });
+  linkInfo->usedGVs.insert(usedGVs.begin(), usedGVs.end());
 
   if (m_DM.HasDxilFunctionProps(F)) {
     DxilFunctionProps &props = m_DM.GetDxilFunctionProps(F);
@@ -250,10 +311,14 @@ void DxilLib::LazyLoadFunction(Function *F) {
       linkInfo->usedFunctions.insert(patchConstantFunc);
     }
   }
-  // Used globals will be build before link.
+  linkInfo->bLoaded = true;
 }
 
 void DxilLib::BuildGlobalUsage() {
+  if (m_bInitFuncsAndResourcesBuilt)
+    return;
+  m_bInitFuncsAndResourcesBuilt = true;
+
   Module &M = *m_pModule;
 
   // Collect init functions for static globals.
@@ -280,17 +345,6 @@ void DxilLib::BuildGlobalUsage() {
     }
   }
 
-  // Build used globals.
-  for (GlobalVariable &GV : M.globals()) {
-    llvm::SetVector<Function *> funcSet;
-    CollectUsedFunctions(&GV, funcSet);
-    for (Function *F : funcSet) {
-      DXASSERT(m_functionNameMap.count(F->getName()), "must exist in table");
-      DxilFunctionLinkInfo *linkInfo = m_functionNameMap[F->getName()].get();
-      linkInfo->usedGVs.insert(&GV);
-    }
-  }
-
   // Build resource map.
   AddResourceMap(m_DM.GetUAVs(), DXIL::ResourceClass::UAV, m_resourceMap, m_DM);
   AddResourceMap(m_DM.GetSRVs(), DXIL::ResourceClass::SRV, m_resourceMap, m_DM);
@@ -330,10 +384,14 @@ void DxilLib::CollectUsedInitFunctions(SetVector<StringRef> &addedFunctionSet,
 }
 
 bool DxilLib::HasFunction(std::string &name) {
+  BuildFunctionTable();
   return m_functionNameMap.count(name);
 }
 
-bool DxilLib::IsEntry(llvm::Function *F) { return m_entrySet.count(F); }
+bool DxilLib::IsEntry(llvm::Function *F) {
+  BuildFunctionTable();
+  return m_entrySet.count(F);
+}
 bool DxilLib::IsInitFunc(llvm::Function *F) { return m_initFuncSet.count(F); }
 bool DxilLib::IsResourceGlobal(const llvm::Constant *GV) {
   return m_resourceMap.count(GV);
@@ -366,6 +424,7 @@ struct DxilLinkJob {
 private:
   void LinkNamedMDNodes(Module *pM, ValueToValueMapTy &vmap);
   void AddFunctionDecls(Module *pM);
+  void AddOpFunctionsToCache(OP *hlslOP);
   bool AddGlobals(DxilModule &DM, ValueToValueMapTy &vmap);
   void EmitCtorListForLib(Module *pM);
   void CloneFunctions(ValueToValueMapTy &vmap);
@@ -617,6 +676,22 @@ void DxilLinkJob::AddFunctionDecls(Module *pM) {
   }
 }
 
+void DxilLinkJob::AddOpFunctionsToCache(OP *hlslOP) {
+  // The dxil operation decls were created before the DxilModule, and have no
+  // calls yet, so take the opcode from the calls in the source module.
+  for (auto &it : m_functionDecls) {
+    for (auto F : it.second.second) {
+      if (!OP::IsDxilOpFunc(F) || F->user_empty())
+        continue;
+      Function *NewF = m_newFunctions[F->getName()];
+      if (F->getFunctionType() != NewF->getFunctionType())
+        continue;
+      CallInst *CI = cast<CallInst>(*F->user_begin());
+      hlslOP->AddToCache(OP::GetDxilOpFuncCallInst(CI), NewF);
+    }
+  }
+}
+
 bool DxilLinkJob::AddGlobals(DxilModule &DM, ValueToValueMapTy &vmap) {
   DxilTypeSystem &typeSys = DM.GetTypeSystem();
   Module *pM = DM.GetModule();
@@ -761,6 +836,7 @@ DxilLinkJob::Link(std::pair<DxilFunctionLinkInfo *, DxilLib *> &entryLinkPair,
   const bool bSkipInit = true;
   DxilModule &DM = pM->GetOrCreateDxilModule(bSkipInit);
   DM.SetShaderModel(pSM, entryDM.GetUseMinPrecision());
+  AddOpFunctionsToCache(DM.GetOP());
 
   // Set Validator version.
   DM.SetValidatorVersion(m_valMajor, m_valMinor);
@@ -825,9 +901,6 @@ DxilLinkJob::Link(std::pair<DxilFunctionLinkInfo *, DxilLib *> &entryLinkPair,
     }
   }
 
-  // Refresh intrinsic cache.
-  DM.GetOP()->RefreshCache();
-
   // Add resource to DM.
   // This should be after functions cloned.
   AddResourceToDM(DM);
@@ -901,6 +974,7 @@ std::unique_ptr<Module> DxilLinkJob::LinkToLib(const ShaderModel *pSM) {
   const bool bSkipInit = true;
   DxilModule &DM = pM->GetOrCreateDxilModule(bSkipInit);
   DM.SetShaderModel(pSM, tmpDM.GetUseMinPrecision());
+  AddOpFunctionsToCache(DM.GetOP());
 
   // Set Validator version.
   DM.SetValidatorVersion(m_valMajor, m_valMinor);
@@ -936,9 +1010,6 @@ std::unique_ptr<Module> DxilLinkJob::LinkToLib(const ShaderModel *pSM) {
   // Clone functions.
   CloneFunctions(vmap);
 
-  // Refresh intrinsic cache.
-  DM.GetOP()->RefreshCache();
-
   // Add resource to DM.
   // This should be after functions cloned.
   AddResourceToDM(DM);
@@ -1575,7 +1646,7 @@ DxilLinkerImpl::Link(StringRef entry, StringRef profile,
     }
   }
 
-  // Save global users.
+  // Collect init functions and resources.
   for (auto &pLib : libSet) {
     pLib->BuildGlobalUsage();
   }
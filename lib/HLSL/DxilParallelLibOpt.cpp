@@ -0,0 +1,708 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilParallelLibOpt.cpp                                                    //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Runs the function-level scalar optimizations of a library module on      //
+// independent partitions of the module in parallel.                         //
+//                                                                           //
+// After inlining, most exported functions of a lib_6_x module no longer     //
+// reference each other. Defined functions are grouped into call-graph       //
+// components, components are spread over partitions, and every partition    //
+// is optimized as a copy of the module in its own LLVMContext where bodies  //
+// outside the partition are dropped. The copy carries the DXIL metadata, so //
+// it has the same DxilModule state. The optimized bodies are then cloned    //
+// back into the original functions.                                         //
+//                                                                           //
+// Partitioning only depends on the module, not on the number of threads,    //
+// and each partition is merged back in a fixed order, so the result does    //
+// not depend on the machine or on thread timing.                            //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/DXIL/DxilModule.h"
+#include "dxc/DXIL/DxilOperations.h"
+#include "dxc/DXIL/DxilUtil.h"
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/Support/Global.h"
+#include "dxc/Support/WorkerThreads.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+
+// The PassManagerBuilder settings that affect the scalar pipeline. Every
+// partition builds its own pipeline from these.
+struct ScalarOptConfig {
+  unsigned OptLevel = 3;
+  unsigned SizeLevel = 0;
+  bool DisableUnrollLoops = false;
+  bool RerollLoops = false;
+  bool LoadCombine = false;
+  bool DisableGVNLoadPRE = false;
+  bool ResMayAlias = false;
+  unsigned ScanLimit = 0;
+  bool EnableGVN = true;
+  bool AggressiveReassociation = true;
+  bool NoSink = false;
+
+  void configure(PassManagerBuilder &Builder) const {
+    Builder.OptLevel = OptLevel;
+    Builder.SizeLevel = SizeLevel;
+    Builder.DisableUnrollLoops = DisableUnrollLoops;
+    Builder.RerollLoops = RerollLoops;
+    Builder.LoadCombine = LoadCombine;
+    Builder.DisableGVNLoadPRE = DisableGVNLoadPRE;
+    Builder.HLSLResMayAlias = ResMayAlias;
+    Builder.ScanLimit = ScanLimit;
+    Builder.EnableGVN = EnableGVN;
+    Builder.HLSLEnableAggressiveReassociation = AggressiveReassociation;
+    Builder.HLSLNoSink = NoSink;
+  }
+};
+
+// A set of call-graph components optimized together, and its result.
+struct Partition {
+  std::vector<unsigned> Functions; // Indices into the module function list.
+  unsigned Size = 0;               // Instruction count, for balancing.
+  std::string Bitcode;             // The optimized partition module.
+  bool Failed = false;
+};
+
+// Partitions a module is split into at most, unless set with the
+// MaxPartitions pass option.
+static const unsigned kDefaultMaxPartitions = 8;
+
+static void PartitionDiagnosticHandler(const DiagnosticInfo *DI,
+                                       void *Context) {
+  if (DI->getSeverity() == DS_Error)
+    *static_cast<bool *>(Context) = true;
+}
+
+static unsigned GetFunctionSize(const Function &F) {
+  unsigned Size = 0;
+  for (const BasicBlock &BB : F)
+    Size += BB.size();
+  return Size;
+}
+
+static unsigned FindComponent(std::vector<unsigned> &Parents, unsigned I) {
+  while (Parents[I] != I) {
+    Parents[I] = Parents[Parents[I]];
+    I = Parents[I];
+  }
+  return I;
+}
+
+// Adds to Users the functions whose bodies reference V, looking through
+// constant expressions.
+static void CollectUserFunctions(Value *V,
+                                 SmallVectorImpl<Function *> &Users) {
+  SmallVector<User *, 16> Worklist(V->user_begin(), V->user_end());
+  SmallPtrSet<User *, 16> Visited;
+  while (!Worklist.empty()) {
+    User *U = Worklist.pop_back_val();
+    if (!Visited.insert(U).second)
+      continue;
+    if (Instruction *I = dyn_cast<Instruction>(U))
+      Users.push_back(I->getParent()->getParent());
+    else if (isa<Constant>(U) && !isa<GlobalValue>(U))
+      Worklist.append(U->user_begin(), U->user_end());
+  }
+}
+
+// Groups the defined functions into call-graph components and spreads
+// the components over at most MaxPartitions partitions. Largest components
+// are placed first, each into the currently smallest partition; ties are
+// broken by module order.
+static void BuildPartitions(ArrayRef<Function *> Functions,
+                            unsigned MaxPartitions,
+                            std::vector<Partition> &Partitions) {
+  DenseMap<Function *, unsigned> Index;
+  for (unsigned I = 0, E = Functions.size(); I != E; ++I)
+    Index[Functions[I]] = I;
+
+  std::vector<unsigned> Parents(Functions.size());
+  for (unsigned I = 0, E = Functions.size(); I != E; ++I)
+    Parents[I] = I;
+
+  SmallVector<Function *, 16> Users;
+  for (unsigned I = 0, E = Functions.size(); I != E; ++I) {
+    Function *F = Functions[I];
+    if (F->isDeclaration())
+      continue;
+    Users.clear();
+    CollectUserFunctions(F, Users);
+    for (Function *User : Users) {
+      auto It = Index.find(User);
+      if (It == Index.end())
+        continue;
+      unsigned A = FindComponent(Parents, I);
+      unsigned B = FindComponent(Parents, It->second);
+      if (A != B)
+        Parents[std::max(A, B)] = std::min(A, B);
+    }
+  }
+
+  // Components are identified by their first function in module order.
+  struct Component {
+    unsigned First;
+    unsigned Size;
+    std::vector<unsigned> Functions;
+  };
+  std::vector<Component> Components;
+  DenseMap<unsigned, unsigned> ComponentOfRoot;
+  for (unsigned I = 0, E = Functions.size(); I != E; ++I) {
+    if (Functions[I]->isDeclaration())
+      continue;
+    unsigned Root = FindComponent(Parents, I);
+    auto Inserted = ComponentOfRoot.insert({Root, Components.size()});
+    if (Inserted.second)
+      Components.push_back({I, 0, {}});
+    Component &C = Components[Inserted.first->second];
+    C.Functions.push_back(I);
+    C.Size += GetFunctionSize(*Functions[I]);
+  }
+
+  std::stable_sort(Components.begin(), Components.end(),
+                   [](const Component &A, const Component &B) {
+                     if (A.Size != B.Size)
+                       return A.Size > B.Size;
+                     return A.First < B.First;
+                   });
+
+  Partitions.clear();
+  Partitions.resize(std::min<size_t>(MaxPartitions, Components.size()));
+  for (Component &C : Components) {
+    Partition *Smallest = &Partitions.front();
+    for (Partition &P : Partitions) {
+      if (P.Size < Smallest->Size)
+        Smallest = &P;
+    }
+    Smallest->Functions.insert(Smallest->Functions.end(), C.Functions.begin(),
+                               C.Functions.end());
+    Smallest->Size += C.Size;
+  }
+  for (Partition &P : Partitions)
+    std::sort(P.Functions.begin(), P.Functions.end());
+}
+
+// Optimizes one partition. The module is loaded from ModuleBitcode into a
+// private context, bodies of functions outside the partition are dropped and
+// the scalar pipeline is run on what remains.
+static void OptimizePartition(StringRef ModuleBitcode, Partition &P,
+                              const ScalarOptConfig &Config) {
+  try {
+    LLVMContext Context;
+    bool HasErrors = false;
+    Context.setDiagnosticHandler(PartitionDiagnosticHandler, &HasErrors);
+
+    std::string DiagStr;
+    std::unique_ptr<Module> PM =
+        dxilutil::LoadModuleFromBitcode(ModuleBitcode, Context, DiagStr);
+    if (!PM) {
+      P.Failed = true;
+      return;
+    }
+
+    unsigned Index = 0;
+    auto Next = P.Functions.begin();
+    for (Function &F : *PM) {
+      if (Next != P.Functions.end() && *Next == Index)
+        ++Next;
+      else if (!F.isDeclaration())
+        F.deleteBody();
+      ++Index;
+    }
+
+    // Load the whole DxilModule state from the metadata.
+    PM->GetOrCreateDxilModule();
+
+    PassManagerBuilder Builder;
+    Config.configure(Builder);
+    legacy::PassManager Passes;
+    Builder.populateHLSLScalarOptPassManager(Passes);
+    Passes.run(*PM);
+
+    if (HasErrors) {
+      P.Failed = true;
+      return;
+    }
+
+    raw_string_ostream OS(P.Bitcode);
+    WriteBitcodeToFile(PM.get(), OS);
+    OS.flush();
+  } catch (...) {
+    P.Failed = true;
+  }
+}
+
+// Maps types of a partition module loaded into the context of the original
+// module onto the original types. Loading gives every named struct of the
+// partition a numeric suffix since the name is already taken; the original is
+// the structurally equivalent struct that owns the unsuffixed name.
+class PartitionTypeRemapper : public ValueMapTypeRemapper {
+public:
+  explicit PartitionTypeRemapper(Module &M) : M(M) {}
+  Type *remapType(Type *SrcTy) override;
+
+private:
+  typedef SmallVector<std::pair<StructType *, StructType *>, 8> AssumedPairs;
+
+  Module &M;
+  DenseMap<Type *, Type *> MappedTypes;
+
+  Type *remapNamedStruct(StructType *SrcTy);
+  bool areEquivalent(Type *SrcTy, Type *DstTy, AssumedPairs &Assumed);
+};
+
+Type *PartitionTypeRemapper::remapType(Type *SrcTy) {
+  auto It = MappedTypes.find(SrcTy);
+  if (It != MappedTypes.end())
+    return It->second;
+
+  Type *DstTy = SrcTy;
+  if (StructType *ST = dyn_cast<StructType>(SrcTy)) {
+    if (ST->hasName()) {
+      DstTy = remapNamedStruct(ST);
+    } else if (ST->isLiteral()) {
+      SmallVector<Type *, 8> Elements;
+      for (Type *ElTy : ST->elements())
+        Elements.push_back(remapType(ElTy));
+      DstTy = StructType::get(M.getContext(), Elements, ST->isPacked());
+    }
+  } else if (SrcTy->getNumContainedTypes()) {
+    SmallVector<Type *, 8> Contained;
+    bool Changed = false;
+    for (Type *Ty : SrcTy->subtypes()) {
+      Contained.push_back(remapType(Ty));
+      Changed |= Contained.back() != Ty;
+    }
+    if (Changed) {
+      switch (SrcTy->getTypeID()) {
+      case Type::PointerTyID:
+        DstTy = PointerType::get(Contained[0],
+                                 SrcTy->getPointerAddressSpace());
+        break;
+      case Type::ArrayTyID:
+        DstTy = ArrayType::get(Contained[0], SrcTy->getArrayNumElements());
+        break;
+      case Type::VectorTyID:
+        DstTy = VectorType::get(Contained[0], SrcTy->getVectorNumElements());
+        break;
+      case Type::FunctionTyID:
+        DstTy = FunctionType::get(Contained[0],
+                                  makeArrayRef(Contained).slice(1),
+                                  cast<FunctionType>(SrcTy)->isVarArg());
+        break;
+      default:
+        llvm_unreachable("unexpected derived type");
+      }
+    }
+  }
+  MappedTypes[SrcTy] = DstTy;
+  return DstTy;
+}
+
+Type *PartitionTypeRemapper::remapNamedStruct(StructType *SrcTy) {
+  StringRef Name = SrcTy->getName();
+  size_t Dot = Name.rfind('.');
+  if (Dot == StringRef::npos || Dot + 1 == Name.size() ||
+      Name.find_first_not_of("0123456789", Dot + 1) != StringRef::npos)
+    return SrcTy;
+
+  StructType *DstTy = M.getTypeByName(Name.substr(0, Dot));
+  if (!DstTy)
+    return SrcTy;
+
+  AssumedPairs Assumed;
+  if (!areEquivalent(SrcTy, DstTy, Assumed))
+    return SrcTy;
+  // Structs reached while proving equivalence map the same way.
+  for (auto &Pair : Assumed)
+    MappedTypes[Pair.first] = Pair.second;
+  return DstTy;
+}
+
+bool PartitionTypeRemapper::areEquivalent(Type *SrcTy, Type *DstTy,
+                                          AssumedPairs &Assumed) {
+  if (SrcTy == DstTy)
+    return true;
+  if (SrcTy->getTypeID() != DstTy->getTypeID() ||
+      SrcTy->getNumContainedTypes() != DstTy->getNumContainedTypes())
+    return false;
+
+  switch (SrcTy->getTypeID()) {
+  case Type::StructTyID: {
+    StructType *SrcST = cast<StructType>(SrcTy);
+    StructType *DstST = cast<StructType>(DstTy);
+    if (SrcST->isPacked() != DstST->isPacked() ||
+        SrcST->isOpaque() != DstST->isOpaque() ||
+        SrcST->isLiteral() != DstST->isLiteral())
+      return false;
+    auto Mapped = MappedTypes.find(SrcTy);
+    if (Mapped != MappedTypes.end())
+      return Mapped->second == DstTy;
+    for (auto &Pair : Assumed) {
+      if (Pair.first == SrcST)
+        return Pair.second == DstST;
+    }
+    Assumed.push_back({SrcST, DstST});
+    if (SrcST->isOpaque())
+      return true;
+    break;
+  }
+  case Type::PointerTyID:
+    if (SrcTy->getPointerAddressSpace() != DstTy->getPointerAddressSpace())
+      return false;
+    break;
+  case Type::ArrayTyID:
+    if (SrcTy->getArrayNumElements() != DstTy->getArrayNumElements())
+      return false;
+    break;
+  case Type::VectorTyID:
+    if (SrcTy->getVectorNumElements() != DstTy->getVectorNumElements())
+      return false;
+    break;
+  case Type::FunctionTyID:
+    if (cast<FunctionType>(SrcTy)->isVarArg() !=
+        cast<FunctionType>(DstTy)->isVarArg())
+      return false;
+    break;
+  default:
+    // Distinct primitive types.
+    return false;
+  }
+
+  for (unsigned I = 0, E = SrcTy->getNumContainedTypes(); I != E; ++I) {
+    if (!areEquivalent(SrcTy->getContainedType(I), DstTy->getContainedType(I),
+                       Assumed))
+      return false;
+  }
+  return true;
+}
+
+// The named metadata and llvm.used of a module, saved so the module can be
+// given them back after DXIL metadata was emitted into it for serialization.
+class SavedModuleMetadata {
+public:
+  explicit SavedModuleMetadata(Module &M);
+  void restore();
+
+private:
+  Module &M;
+  std::vector<std::pair<std::string, std::vector<MDNode *>>> Nodes;
+  // The original llvm.used, taken out of the module until restore().
+  GlobalVariable *Used = nullptr;
+  GlobalVariable *UsedNext = nullptr;
+};
+
+SavedModuleMetadata::SavedModuleMetadata(Module &M) : M(M) {
+  for (NamedMDNode &Node : M.named_metadata()) {
+    Nodes.emplace_back(Node.getName().str(), std::vector<MDNode *>());
+    for (MDNode *Op : Node.operands())
+      Nodes.back().second.push_back(Op);
+  }
+  Used = M.getGlobalVariable("llvm.used");
+  if (Used) {
+    UsedNext = Used->getNextNode();
+    Used->removeFromParent();
+  }
+}
+
+void SavedModuleMetadata::restore() {
+  while (!M.named_metadata_empty())
+    M.eraseNamedMetadata(&*M.named_metadata_begin());
+  for (auto &Node : Nodes) {
+    NamedMDNode *NewNode = M.getOrInsertNamedMetadata(Node.first);
+    for (MDNode *Op : Node.second)
+      NewNode->addOperand(Op);
+  }
+
+  if (GlobalVariable *EmittedUsed = M.getGlobalVariable("llvm.used"))
+    EmittedUsed->eraseFromParent();
+  if (Used)
+    M.getGlobalList().insert(
+        UsedNext ? Module::global_iterator(UsedNext) : M.global_end(), Used);
+}
+
+class DxilParallelLibOpt : public ModulePass {
+  ScalarOptConfig Config;
+  unsigned MaxPartitions = kDefaultMaxPartitions;
+  unsigned MaxThreads = 0;
+
+public:
+  static char ID;
+  DxilParallelLibOpt() : ModulePass(ID) {
+    initializeDxilParallelLibOptPass(*PassRegistry::getPassRegistry());
+  }
+  explicit DxilParallelLibOpt(const ScalarOptConfig &Config)
+      : ModulePass(ID), Config(Config) {
+    initializeDxilParallelLibOptPass(*PassRegistry::getPassRegistry());
+  }
+
+  StringRef getPassName() const override {
+    return "DXIL parallel library optimization";
+  }
+
+  void applyOptions(PassOptions O) override {
+    GetPassOptionUnsigned(O, "OptLevel", &Config.OptLevel, 3);
+    GetPassOptionUnsigned(O, "SizeLevel", &Config.SizeLevel, 0);
+    GetPassOptionBool(O, "DisableUnrollLoops", &Config.DisableUnrollLoops,
+                      false);
+    GetPassOptionBool(O, "ResMayAlias", &Config.ResMayAlias, false);
+    GetPassOptionUnsigned(O, "ScanLimit", &Config.ScanLimit, 0);
+    GetPassOptionBool(O, "EnableGVN", &Config.EnableGVN, true);
+    GetPassOptionBool(O, "AggressiveReassociation",
+                      &Config.AggressiveReassociation, true);
+    GetPassOptionBool(O, "NoSink", &Config.NoSink, false);
+    GetPassOptionUnsigned(O, "MaxPartitions", &MaxPartitions,
+                          kDefaultMaxPartitions);
+    GetPassOptionUnsigned(O, "MaxThreads", &MaxThreads, 0);
+  }
+  void dumpConfig(raw_ostream &OS) override {
+    ModulePass::dumpConfig(OS);
+    OS << ",OptLevel=" << Config.OptLevel;
+    OS << ",SizeLevel=" << Config.SizeLevel;
+    OS << ",DisableUnrollLoops=" << Config.DisableUnrollLoops;
+    OS << ",ResMayAlias=" << Config.ResMayAlias;
+    OS << ",ScanLimit=" << Config.ScanLimit;
+    OS << ",EnableGVN=" << Config.EnableGVN;
+    OS << ",AggressiveReassociation=" << Config.AggressiveReassociation;
+    OS << ",NoSink=" << Config.NoSink;
+    OS << ",MaxPartitions=" << MaxPartitions;
+    OS << ",MaxThreads=" << MaxThreads;
+  }
+
+  bool runOnModule(Module &M) override;
+
+private:
+  bool runInProcess(Module &M);
+  bool mergePartitions(Module &M, ArrayRef<Function *> Functions,
+                       std::vector<Partition> &Partitions);
+};
+
+char DxilParallelLibOpt::ID = 0;
+
+bool DxilParallelLibOpt::runInProcess(Module &M) {
+  PassManagerBuilder Builder;
+  Config.configure(Builder);
+  legacy::PassManager Passes;
+  Builder.populateHLSLScalarOptPassManager(Passes);
+  return Passes.run(M);
+}
+
+bool DxilParallelLibOpt::runOnModule(Module &M) {
+  if (!M.HasDxilModule())
+    return runInProcess(M);
+  DxilModule &DM = M.GetDxilModule();
+  const ShaderModel *SM = DM.GetShaderModel();
+  // Debug info ties functions together through shared metadata, which does
+  // not survive a round trip through separate contexts.
+  if (!SM || !SM->IsLib() || hasDebugInfo(M))
+    return runInProcess(M);
+  // The pass managers open time trace sections on the one global profiler and
+  // start the global pass timers, neither of which may be used from worker
+  // threads.
+  if (timeTraceProfilerEnabled() || TimePassesIsEnabled)
+    return runInProcess(M);
+
+  // The partitions only depend on the module, so the output is the same
+  // whatever the number of threads.
+  std::vector<Function *> Functions;
+  for (Function &F : M)
+    Functions.push_back(&F);
+  std::vector<Partition> Partitions;
+  BuildPartitions(Functions, std::max(1u, MaxPartitions), Partitions);
+  if (Partitions.size() < 2)
+    return runInProcess(M);
+
+  // Partitions rebuild their DxilModule from the metadata, so the copy they
+  // load needs it up to date, the same way DxilEmitMetadata does at the end of
+  // the pipeline. The module itself gets its own metadata back once the
+  // partitions are merged, or abandoned: the passes after this one do not
+  // expect emitted DXIL metadata.
+  SavedModuleMetadata SavedMetadata(M);
+  DxilModule::ClearDxilMetadata(M);
+  DM.EmitDxilMetadata();
+  std::string ModuleBitcode;
+  {
+    raw_string_ostream OS(ModuleBitcode);
+    WriteBitcodeToFile(&M, OS);
+  }
+
+  ParallelFor(MaxThreads, Partitions.size(), [&](size_t I) {
+    OptimizePartition(ModuleBitcode, Partitions[I], Config);
+  });
+
+  // The merge maps globals by module order, so it runs before the original
+  // llvm.used is put back.
+  bool Merged = std::none_of(Partitions.begin(), Partitions.end(),
+                             [](const Partition &P) { return P.Failed; }) &&
+                mergePartitions(M, Functions, Partitions);
+  SavedMetadata.restore();
+  if (!Merged)
+    return runInProcess(M);
+  return true;
+}
+
+// Replaces the bodies of the partition functions with their optimized
+// versions. Returns false, without changing M, if a partition cannot be
+// mapped back onto M.
+bool DxilParallelLibOpt::mergePartitions(Module &M,
+                                         ArrayRef<Function *> Functions,
+                                         std::vector<Partition> &Partitions) {
+  PartitionTypeRemapper TypeMapper(M);
+  std::vector<std::unique_ptr<Module>> Results;
+  std::vector<std::unique_ptr<ValueToValueMapTy>> VMaps;
+  // Declarations the passes added to a partition that M does not have yet.
+  std::vector<std::pair<Function *, ValueToValueMapTy *>> NewDecls;
+
+  for (Partition &P : Partitions) {
+    std::string DiagStr;
+    std::unique_ptr<Module> Result =
+        dxilutil::LoadModuleFromBitcode(P.Bitcode, M.getContext(), DiagStr);
+    std::string().swap(P.Bitcode);
+    if (!Result || !Result->alias_empty() ||
+        Result->getGlobalList().size() != M.getGlobalList().size() ||
+        Result->size() < Functions.size())
+      return false;
+
+    // Globals and the original functions keep their module order.
+    std::unique_ptr<ValueToValueMapTy> VMap(new ValueToValueMapTy());
+    auto DstGV = M.global_begin();
+    for (GlobalVariable &GV : Result->globals()) {
+      if (GV.getName() != DstGV->getName() ||
+          TypeMapper.remapType(GV.getType()) != DstGV->getType())
+        return false;
+      (*VMap)[&GV] = &*DstGV++;
+    }
+    unsigned Index = 0;
+    for (Function &F : *Result) {
+      Function *DstF = nullptr;
+      if (Index < Functions.size()) {
+        DstF = Functions[Index];
+        if (F.getName() != DstF->getName())
+          return false;
+      } else if (F.isDeclaration()) {
+        DstF = M.getFunction(F.getName());
+        if (!DstF) {
+          NewDecls.push_back({&F, VMap.get()});
+          ++Index;
+          continue;
+        }
+      } else {
+        return false;
+      }
+      if (TypeMapper.remapType(F.getType()) != DstF->getType())
+        return false;
+      (*VMap)[&F] = DstF;
+      ++Index;
+    }
+
+    Results.push_back(std::move(Result));
+    VMaps.push_back(std::move(VMap));
+  }
+
+  // Nothing below can fail. Declarations are added in name order, so the
+  // module does not depend on which partition needed them first.
+  std::stable_sort(NewDecls.begin(), NewDecls.end(),
+                   [](const std::pair<Function *, ValueToValueMapTy *> &A,
+                      const std::pair<Function *, ValueToValueMapTy *> &B) {
+                     return A.first->getName() < B.first->getName();
+                   });
+  for (auto &NewDecl : NewDecls) {
+    Function *F = NewDecl.first;
+    Function *DstF = M.getFunction(F->getName());
+    if (!DstF) {
+      DstF = Function::Create(
+          cast<FunctionType>(TypeMapper.remapType(F->getFunctionType())),
+          F->getLinkage(), F->getName(), &M);
+      DstF->copyAttributesFrom(F);
+    }
+    // DstF has no calls until the bodies are merged below, so register it
+    // with the opcode from the partition's calls.
+    if (OP::IsDxilOpFunc(F) && !F->user_empty())
+      M.GetDxilModule().GetOP()->AddToCache(
+          OP::GetDxilOpFuncCallInst(cast<CallInst>(*F->user_begin())), DstF);
+    (*NewDecl.second)[F] = DstF;
+  }
+
+  for (unsigned I = 0, E = Partitions.size(); I != E; ++I) {
+    Module &Result = *Results[I];
+    ValueToValueMapTy &VMap = *VMaps[I];
+    std::vector<Function *> ResultFunctions;
+    for (Function &F : Result)
+      ResultFunctions.push_back(&F);
+
+    for (unsigned Index : Partitions[I].Functions) {
+      Function *Src = ResultFunctions[Index];
+      Function *Dst = Functions[Index];
+
+      for (BasicBlock &BB : *Dst)
+        BB.dropAllReferences();
+      while (!Dst->empty())
+        Dst->begin()->eraseFromParent();
+
+      auto DstArg = Dst->arg_begin();
+      for (Argument &Arg : Src->args())
+        VMap[&Arg] = &*DstArg++;
+      SmallVector<ReturnInst *, 4> Returns;
+      CloneFunctionInto(Dst, Src, VMap, /*ModuleLevelChanges*/ true, Returns,
+                        "", nullptr, &TypeMapper);
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+ModulePass *llvm::createDxilParallelLibOptPass() {
+  return new DxilParallelLibOpt();
+}
+
+ModulePass *llvm::createDxilParallelLibOptPass(const PassManagerBuilder &B) {
+  ScalarOptConfig Config;
+  Config.OptLevel = B.OptLevel;
+  Config.SizeLevel = B.SizeLevel;
+  Config.DisableUnrollLoops = B.DisableUnrollLoops;
+  Config.RerollLoops = B.RerollLoops;
+  Config.LoadCombine = B.LoadCombine;
+  Config.DisableGVNLoadPRE = B.DisableGVNLoadPRE;
+  Config.ResMayAlias = B.HLSLResMayAlias;
+  Config.ScanLimit = B.ScanLimit;
+  Config.EnableGVN = B.EnableGVN;
+  Config.AggressiveReassociation = B.HLSLEnableAggressiveReassociation;
+  Config.NoSink = B.HLSLNoSink;
+  return new DxilParallelLibOpt(Config);
+}
+
+INITIALIZE_PASS(DxilParallelLibOpt, "dxil-parallel-lib-opt",
+                "DXIL parallel library optimization", false, false)
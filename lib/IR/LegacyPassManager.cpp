@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/StringMap.h" // HLSL Change
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/LegacyPassManagers.h"
@@ -1551,6 +1552,67 @@ void FPPassManager::dumpPassStructure(unsigned Offset) {
 }
 
 
+// HLSL Change Begin - Per-function pass costs in the time trace.
+static unsigned countInstructions(const Function &F) {
+  unsigned Count = 0;
+  for (const BasicBlock &BB : F)
+    Count += BB.size();
+  return Count;
+}
+
+/// Instruction counts of the defined functions of a module, in module order.
+struct FunctionSizes {
+  std::vector<std::pair<std::string, unsigned>> Sizes;
+  StringMap<unsigned> Index;
+};
+
+static void collectFunctionSizes(const Module &M, FunctionSizes &Before) {
+  for (const Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    Before.Index[F.getName()] = Before.Sizes.size();
+    Before.Sizes.emplace_back(F.getName(), countInstructions(F));
+  }
+}
+
+/// Add the module instruction counts before and after a module pass, and the
+/// counts of each function whose size it changed, including functions it
+/// created or removed, to the open module pass section.
+static void recordModulePassCosts(const Module &M,
+                                  const FunctionSizes &Before) {
+  std::vector<TimeTraceFunctionCost> Costs;
+  std::vector<bool> Seen(Before.Sizes.size());
+  unsigned InstsBefore = 0;
+  for (const auto &It : Before.Sizes)
+    InstsBefore += It.second;
+
+  unsigned InstsAfter = 0;
+  for (const Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    unsigned Insts = countInstructions(F);
+    InstsAfter += Insts;
+    auto It = Before.Index.find(F.getName());
+    if (It == Before.Index.end()) {
+      Costs.push_back({F.getName(), 0, Insts});
+      continue;
+    }
+    Seen[It->second] = true;
+    if (Before.Sizes[It->second].second != Insts)
+      Costs.push_back({F.getName(), Before.Sizes[It->second].second, Insts});
+  }
+  // Whatever was not seen was removed by the pass.
+  for (unsigned I = 0, E = Before.Sizes.size(); I != E; ++I) {
+    if (!Seen[I])
+      Costs.push_back({Before.Sizes[I].first, Before.Sizes[I].second, 0});
+  }
+
+  timeTraceProfilerAddArg("instsBefore", InstsBefore);
+  timeTraceProfilerAddArg("instsAfter", InstsAfter);
+  timeTraceProfilerAddFunctionCosts("functions", Costs);
+}
+// HLSL Change End
+
 /// Execute all of the passes scheduled for execution by invoking
 /// runOnFunction method.  Keep track of whether any of the passes modifies
 /// the function, and if so, return true.
@@ -1574,6 +1636,10 @@ bool FPPassManager::runOnFunction(Function &F) {
     // HLSL Change Begin - Support hierarchial time tracing.
     llvm::TimeTraceScope PassScope("RunFunctionPass", FP->getPassName());
     // HLSL Change End - Support hierarchial time tracing.
+    // HLSL Change Begin - Per-function pass costs in the time trace.
+    const bool RecordCost = timeTraceProfilerPassCostsEnabled();
+    const unsigned InstsBefore = RecordCost ? countInstructions(F) : 0;
+    // HLSL Change End
 
     dumpPassInfo(FP, EXECUTION_MSG, ON_FUNCTION_MSG, F.getName());
     dumpRequiredSet(FP);
@@ -1587,6 +1653,14 @@ bool FPPassManager::runOnFunction(Function &F) {
       LocalChanged |= FP->runOnFunction(F);
     }
 
+    // HLSL Change Begin - Per-function pass costs in the time trace.
+    if (RecordCost) {
+      timeTraceProfilerAddArg("function", F.getName());
+      timeTraceProfilerAddArg("instsBefore", InstsBefore);
+      timeTraceProfilerAddArg("instsAfter", countInstructions(F));
+    }
+    // HLSL Change End
+
     Changed |= LocalChanged;
     if (LocalChanged)
       dumpPassInfo(FP, MODIFICATION_MSG, ON_FUNCTION_MSG, F.getName());
@@ -1656,6 +1730,12 @@ MPPassManager::runOnModule(Module &M) {
     bool LocalChanged = false;
 
     llvm::TimeTraceScope PassScope("RunModulePass", MP->getPassName());
+    // HLSL Change Begin - Per-function pass costs in the time trace.
+    const bool RecordCost = timeTraceProfilerPassCostsEnabled();
+    FunctionSizes SizesBefore;
+    if (RecordCost)
+      collectFunctionSizes(M, SizesBefore);
+    // HLSL Change End
 
     dumpPassInfo(MP, EXECUTION_MSG, ON_MODULE_MSG, M.getModuleIdentifier());
     dumpRequiredSet(MP);
@@ -1669,6 +1749,9 @@ MPPassManager::runOnModule(Module &M) {
       LocalChanged |= MP->runOnModule(M);
     }
 
+    if (RecordCost) // HLSL Change
+      recordModulePassCosts(M, SizesBefore);
+
     Changed |= LocalChanged;
     if (LocalChanged)
       dumpPassInfo(MP, MODIFICATION_MSG, ON_MODULE_MSG,
@@ -58,6 +58,10 @@ struct Entry {
   DurationType Duration;
   std::string Name;
   std::string Detail;
+  // HLSL Change - Extra args, as pairs of name and JSON value.
+  std::vector<std::pair<std::string, std::string>> Args;
+  // HLSL Change - Set when a nested section was kept, so this one is too.
+  bool HasKeptChild;
 };
 
 struct TimeTraceProfiler {
@@ -68,7 +72,7 @@ struct TimeTraceProfiler {
   }
 
   void begin(std::string Name, llvm::function_ref<std::string()> Detail) {
-    Entry E = {steady_clock::now(), {}, Name, Detail()};
+    Entry E = {steady_clock::now(), {}, Name, Detail(), {}, false};
     Stack.push_back(std::move(E));
   }
 
@@ -78,8 +82,16 @@ struct TimeTraceProfiler {
     E.Duration = steady_clock::now() - E.Start;
 
     // Only include sections longer than TimeTraceGranularity msec.
-    if (duration_cast<microseconds>(E.Duration).count() > TimeTraceGranularity)
+    // HLSL Change Begin - Sections with args were explicitly asked for; keep
+    // them, along with the sections they are nested in.
+    if (duration_cast<microseconds>(E.Duration).count() >
+            TimeTraceGranularity ||
+        !E.Args.empty() || E.HasKeptChild) {
       Entries.emplace_back(E);
+      if (Stack.size() > 1)
+        Stack[Stack.size() - 2].HasKeptChild = true;
+    }
+    // HLSL Change End
 
     // Track total time taken by each "name", but only the topmost levels of
     // them; e.g. if there's a template instantiation that instantiates other
@@ -108,8 +120,10 @@ struct TimeTraceProfiler {
       auto DurUs = duration_cast<microseconds>(E.Duration).count();
       OS << "{ \"pid\":1, \"tid\":0, \"ph\":\"X\", \"ts\":" << StartUs
          << ", \"dur\":" << DurUs << ", \"name\":\"" << escapeString(E.Name)
-         << "\", \"args\":{ \"detail\":\"" << escapeString(E.Detail)
-         << "\"} },\n";
+         << "\", \"args\":{ \"detail\":\"" << escapeString(E.Detail) << "\"";
+      for (const auto &Arg : E.Args) // HLSL Change
+        OS << ", \"" << escapeString(Arg.first) << "\":" << Arg.second;
+      OS << "} },\n";
     }
 
     // Emit totals by section name as additional "thread" events, sorted from
@@ -149,14 +163,26 @@ struct TimeTraceProfiler {
 
   // Minimum time granularity (in microseconds)
   unsigned TimeTraceGranularity;
+
+  // HLSL Change - Record instruction counts around each pass.
+  bool RecordPassCosts = false;
 };
 
-void timeTraceProfilerInitialize(unsigned TimeTraceGranularity) {
+void timeTraceProfilerInitialize(unsigned TimeTraceGranularity,
+                                 bool RecordPassCosts) {
   assert(TimeTraceProfilerInstance == nullptr &&
          "Profiler should not be initialized");
   TimeTraceProfilerInstance = new TimeTraceProfiler();
   TimeTraceProfilerInstance->TimeTraceGranularity = TimeTraceGranularity;
+  TimeTraceProfilerInstance->RecordPassCosts = RecordPassCosts; // HLSL Change
+}
+
+// HLSL Change Begin - Per-function pass costs.
+bool timeTraceProfilerPassCostsEnabled() {
+  return TimeTraceProfilerInstance != nullptr &&
+         TimeTraceProfilerInstance->RecordPassCosts;
 }
+// HLSL Change End
 
 void timeTraceProfilerCleanup() {
   delete TimeTraceProfilerInstance;
@@ -185,4 +211,37 @@ void timeTraceProfilerEnd() {
     TimeTraceProfilerInstance->end();
 }
 
+// HLSL Change Begin - Per-function pass costs.
+void timeTraceProfilerAddArg(StringRef Name, StringRef Value) {
+  if (TimeTraceProfilerInstance != nullptr &&
+      !TimeTraceProfilerInstance->Stack.empty())
+    TimeTraceProfilerInstance->Stack.back().Args.emplace_back(
+        Name, "\"" + escapeString(Value) + "\"");
+}
+
+void timeTraceProfilerAddArg(StringRef Name, int64_t Value) {
+  if (TimeTraceProfilerInstance != nullptr &&
+      !TimeTraceProfilerInstance->Stack.empty())
+    TimeTraceProfilerInstance->Stack.back().Args.emplace_back(Name,
+                                                              itostr(Value));
+}
+
+void timeTraceProfilerAddFunctionCosts(StringRef Name,
+                                       ArrayRef<TimeTraceFunctionCost> Costs) {
+  if (TimeTraceProfilerInstance == nullptr ||
+      TimeTraceProfilerInstance->Stack.empty())
+    return;
+  std::string Value = "[";
+  for (const TimeTraceFunctionCost &Cost : Costs) {
+    if (Value.size() > 1)
+      Value += ", ";
+    Value += "{ \"function\":\"" + escapeString(Cost.Function) +
+             "\", \"instsBefore\":" + itostr(Cost.InstsBefore) +
+             ", \"instsAfter\":" + itostr(Cost.InstsAfter) + "}";
+  }
+  Value += "]";
+  TimeTraceProfilerInstance->Stack.back().Args.emplace_back(Name, Value);
+}
+// HLSL Change End
+
 } // namespace llvm
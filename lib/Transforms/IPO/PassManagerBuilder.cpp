@@ -231,7 +231,8 @@ void PassManagerBuilder::addHLSLPasses(legacy::PassManagerBase &MPM) {
   MPM.add(createHLExpandStoreIntrinsicsPass());
 
   // Split struct and array of parameter.
-  MPM.add(createSROA_Parameter_HLSL());
+  MPM.add(createSROA_Parameter_HLSL(HLSLSROAMaxAggregateLeaves,
+                                    HLSLSROAMemoryBudgetKB));
 
   MPM.add(createHLMatrixLowerPass());
   // DCE should after SROA to remove unused element.
@@ -330,6 +331,133 @@ void PassManagerBuilder::addHLSLPasses(legacy::PassManagerBase &MPM) {
 }
 // HLSL Change Ends
 
+// HLSL Change Begins
+void PassManagerBuilder::addHLSLScalarOptPasses(
+    legacy::PassManagerBase &MPM) {
+  // Start of function pass.
+  // Break up aggregate allocas, using SSAUpdater.
+  if (UseNewSROA)
+    MPM.add(createSROAPass(/*RequiresDomTree*/ false));
+  else
+    MPM.add(createScalarReplAggregatesPass(-1, false));
+
+  // HLSL Change. MPM.add(createEarlyCSEPass());              // Catch trivial redundancies
+  // HLSL Change. MPM.add(createJumpThreadingPass());         // Thread jumps.
+  MPM.add(createCorrelatedValuePropagationPass()); // Propagate conditionals
+  MPM.add(createCFGSimplificationPass());     // Merge & remove BBs
+  MPM.add(createInstructionCombiningPass(HLSLNoSink));  // Combine silly seq's
+  addExtensionsToPM(EP_Peephole, MPM);
+  // HLSL Change Begins.
+  // HLSL does not allow recursize functions.
+  //MPM.add(createTailCallEliminationPass()); // Eliminate tail calls
+  // HLSL Change Ends.
+  MPM.add(createCFGSimplificationPass());     // Merge & remove BBs
+  MPM.add(createReassociatePass(
+      HLSLEnableAggressiveReassociation)); // Reassociate expressions
+  // Rotate Loop - disable header duplication at -Oz
+  MPM.add(createLoopRotatePass(SizeLevel == 2 ? 0 : -1));
+  // HLSL Change - disable LICM in frontend for not consider register pressure.
+  //MPM.add(createLICMPass());                  // Hoist loop invariants
+  //MPM.add(createLoopUnswitchPass(SizeLevel || OptLevel < 3)); // HLSL Change - may move barrier inside divergent if.
+  MPM.add(createInstructionCombiningPass(HLSLNoSink));
+  MPM.add(createIndVarSimplifyPass());        // Canonicalize indvars
+  // HLSL Change Begins
+  // Don't allow loop idiom pass which may insert memset/memcpy thereby breaking the dxil
+  //MPM.add(createLoopIdiomPass());             // Recognize idioms like memset.
+  // HLSL Change Ends
+  MPM.add(createLoopDeletionPass());          // Delete dead loops
+  if (EnableLoopInterchange) {
+    MPM.add(createLoopInterchangePass()); // Interchange loops
+    MPM.add(createCFGSimplificationPass());
+  }
+  if (!DisableUnrollLoops)
+    MPM.add(createSimpleLoopUnrollPass());    // Unroll small loops
+  addExtensionsToPM(EP_LoopOptimizerEnd, MPM);
+
+  if (OptLevel > 1) {
+    if (EnableMLSM)
+      MPM.add(createMergedLoadStoreMotionPass()); // Merge ld/st in diamonds
+    // HLSL Change Begins
+    if (EnableGVN) {
+      MPM.add(createGVNPass(DisableGVNLoadPRE));  // Remove redundancies
+      if (!HLSLResMayAlias)
+        MPM.add(createDxilSimpleGVNHoistPass());
+    }
+    // HLSL Change Ends
+  }
+
+  // HLSL Change Begins.
+  {
+    // Run reassociate pass again after GVN since GVN will expose more
+    // opportunities for reassociation.
+    if (HLSLEnableAggressiveReassociation) {
+      MPM.add(createReassociatePass(true)); // Reassociate expressions
+      if (EnableGVN)
+        MPM.add(createGVNPass(DisableGVNLoadPRE)); // Remove redundancies
+    }
+  }
+
+  // Use value numbering to figure out if regions are equivalent, and branch to only one.
+  MPM.add(createDxilSimpleGVNEliminateRegionPass());
+  // HLSL don't allow memcpy and memset.
+  //MPM.add(createMemCpyOptPass());             // Remove memcpy / form memset
+  // HLSL Change Ends.
+  MPM.add(createSCCPPass());                  // Constant prop with SCCP
+
+  // Delete dead bit computations (instcombine runs after to fold away the dead
+  // computations, and then ADCE will run later to exploit any new DCE
+  // opportunities that creates).
+  MPM.add(createBitTrackingDCEPass());        // Delete dead bit computations
+
+  // Run instcombine after redundancy elimination to exploit opportunities
+  // opened up by them.
+  MPM.add(createInstructionCombiningPass(HLSLNoSink));
+  addExtensionsToPM(EP_Peephole, MPM);
+  // HLSL Change. MPM.add(createJumpThreadingPass());         // Thread jumps
+  MPM.add(createCorrelatedValuePropagationPass());
+  MPM.add(createDeadStoreEliminationPass(ScanLimit));  // Delete dead stores
+  // HLSL Change - disable LICM in frontend for not consider register pressure.
+  // MPM.add(createLICMPass());
+
+  addExtensionsToPM(EP_ScalarOptimizerLate, MPM);
+
+  if (RerollLoops)
+    MPM.add(createLoopRerollPass());
+#if HLSL_VECTORIZATION_ENABLED // HLSL Change - don't build vectorization passes
+  if (!RunSLPAfterLoopVectorization) {
+    if (SLPVectorize)
+      MPM.add(createSLPVectorizerPass());   // Vectorize parallel scalar chains.
+
+    if (BBVectorize) {
+      MPM.add(createBBVectorizePass());
+      MPM.add(createInstructionCombiningPass());
+      addExtensionsToPM(EP_Peephole, MPM);
+      if (OptLevel > 1 && UseGVNAfterVectorization)
+        MPM.add(createGVNPass(DisableGVNLoadPRE)); // Remove redundancies
+      else
+        MPM.add(createEarlyCSEPass());      // Catch trivial redundancies
+
+      // BBVectorize may have significantly shortened a loop body; unroll again.
+      if (!DisableUnrollLoops)
+        MPM.add(createLoopUnrollPass());
+    }
+  }
+#endif
+
+  if (LoadCombine)
+    MPM.add(createLoadCombinePass());
+}
+
+void PassManagerBuilder::populateHLSLScalarOptPassManager(
+    legacy::PassManagerBase &PM) {
+  if (LibraryInfo)
+    PM.add(new TargetLibraryInfoWrapperPass(*LibraryInfo));
+
+  addInitialAliasAnalysisPasses(PM);
+  addHLSLScalarOptPasses(PM);
+}
+// HLSL Change Ends
+
 void PassManagerBuilder::populateModulePassManager(
     legacy::PassManagerBase &MPM) {
   // If all optimizations are disabled, just run the always-inline pass and,
@@ -448,118 +576,14 @@ void PassManagerBuilder::populateModulePassManager(
     MPM.add(createArgumentPromotionPass());   // Scalarize uninlined fn args
 #endif // HLSL Change Ends
 
-  // Start of function pass.
-  // Break up aggregate allocas, using SSAUpdater.
-  if (UseNewSROA)
-    MPM.add(createSROAPass(/*RequiresDomTree*/ false));
-  else
-    MPM.add(createScalarReplAggregatesPass(-1, false));
-
-  // HLSL Change. MPM.add(createEarlyCSEPass());              // Catch trivial redundancies
-  // HLSL Change. MPM.add(createJumpThreadingPass());         // Thread jumps.
-  MPM.add(createCorrelatedValuePropagationPass()); // Propagate conditionals
-  MPM.add(createCFGSimplificationPass());     // Merge & remove BBs
-  MPM.add(createInstructionCombiningPass(HLSLNoSink));  // Combine silly seq's
-  addExtensionsToPM(EP_Peephole, MPM);
   // HLSL Change Begins.
-  // HLSL does not allow recursize functions.
-  //MPM.add(createTailCallEliminationPass()); // Eliminate tail calls
-  // HLSL Change Ends.
-  MPM.add(createCFGSimplificationPass());     // Merge & remove BBs
-  MPM.add(createReassociatePass(
-      HLSLEnableAggressiveReassociation)); // Reassociate expressions
-  // Rotate Loop - disable header duplication at -Oz
-  MPM.add(createLoopRotatePass(SizeLevel == 2 ? 0 : -1));
-  // HLSL Change - disable LICM in frontend for not consider register pressure.
-  //MPM.add(createLICMPass());                  // Hoist loop invariants
-  //MPM.add(createLoopUnswitchPass(SizeLevel || OptLevel < 3)); // HLSL Change - may move barrier inside divergent if.
-  MPM.add(createInstructionCombiningPass(HLSLNoSink));
-  MPM.add(createIndVarSimplifyPass());        // Canonicalize indvars
-  // HLSL Change Begins
-  // Don't allow loop idiom pass which may insert memset/memcpy thereby breaking the dxil
-  //MPM.add(createLoopIdiomPass());             // Recognize idioms like memset.
-  // HLSL Change Ends
-  MPM.add(createLoopDeletionPass());          // Delete dead loops
-  if (EnableLoopInterchange) {
-    MPM.add(createLoopInterchangePass()); // Interchange loops
-    MPM.add(createCFGSimplificationPass());
-  }
-  if (!DisableUnrollLoops)
-    MPM.add(createSimpleLoopUnrollPass());    // Unroll small loops
-  addExtensionsToPM(EP_LoopOptimizerEnd, MPM);
-
-  if (OptLevel > 1) {
-    if (EnableMLSM)
-      MPM.add(createMergedLoadStoreMotionPass()); // Merge ld/st in diamonds
-    // HLSL Change Begins
-    if (EnableGVN) {
-      MPM.add(createGVNPass(DisableGVNLoadPRE));  // Remove redundancies
-      if (!HLSLResMayAlias)
-        MPM.add(createDxilSimpleGVNHoistPass());
-    }
-    // HLSL Change Ends
-  }
-
-  // HLSL Change Begins.
-  {
-    // Run reassociate pass again after GVN since GVN will expose more
-    // opportunities for reassociation.
-    if (HLSLEnableAggressiveReassociation) {
-      MPM.add(createReassociatePass(true)); // Reassociate expressions
-      if (EnableGVN)
-        MPM.add(createGVNPass(DisableGVNLoadPRE)); // Remove redundancies
-    }
-  }
-
-  // Use value numbering to figure out if regions are equivalent, and branch to only one.
-  MPM.add(createDxilSimpleGVNEliminateRegionPass());
-  // HLSL don't allow memcpy and memset.
-  //MPM.add(createMemCpyOptPass());             // Remove memcpy / form memset
+  // Function-level scalar optimizations. Libraries can have them run on
+  // independent partitions of the module in parallel.
+  if (HLSLParallelLibOpt)
+    MPM.add(createDxilParallelLibOptPass(*this));
+  else
+    addHLSLScalarOptPasses(MPM);
   // HLSL Change Ends.
-  MPM.add(createSCCPPass());                  // Constant prop with SCCP
-
-  // Delete dead bit computations (instcombine runs after to fold away the dead
-  // computations, and then ADCE will run later to exploit any new DCE
-  // opportunities that creates).
-  MPM.add(createBitTrackingDCEPass());        // Delete dead bit computations
-
-  // Run instcombine after redundancy elimination to exploit opportunities
-  // opened up by them.
-  MPM.add(createInstructionCombiningPass(HLSLNoSink));
-  addExtensionsToPM(EP_Peephole, MPM);
-  // HLSL Change. MPM.add(createJumpThreadingPass());         // Thread jumps
-  MPM.add(createCorrelatedValuePropagationPass());
-  MPM.add(createDeadStoreEliminationPass(ScanLimit));  // Delete dead stores
-  // HLSL Change - disable LICM in frontend for not consider register pressure.
-  // MPM.add(createLICMPass());
-
-  addExtensionsToPM(EP_ScalarOptimizerLate, MPM);
-
-  if (RerollLoops)
-    MPM.add(createLoopRerollPass());
-#if HLSL_VECTORIZATION_ENABLED // HLSL Change - don't build vectorization passes
-  if (!RunSLPAfterLoopVectorization) {
-    if (SLPVectorize)
-      MPM.add(createSLPVectorizerPass());   // Vectorize parallel scalar chains.
-
-    if (BBVectorize) {
-      MPM.add(createBBVectorizePass());
-      MPM.add(createInstructionCombiningPass());
-      addExtensionsToPM(EP_Peephole, MPM);
-      if (OptLevel > 1 && UseGVNAfterVectorization)
-        MPM.add(createGVNPass(DisableGVNLoadPRE)); // Remove redundancies
-      else
-        MPM.add(createEarlyCSEPass());      // Catch trivial redundancies
-
-      // BBVectorize may have significantly shortened a loop body; unroll again.
-      if (!DisableUnrollLoops)
-        MPM.add(createLoopUnrollPass());
-    }
-  }
-#endif
-
-  if (LoadCombine)
-    MPM.add(createLoadCombinePass());
 
   MPM.add(createHoistConstantArrayPass()); // HLSL change
 
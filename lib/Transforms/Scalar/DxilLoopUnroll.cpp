@@ -46,10 +46,15 @@
 //
 // 3. Unroll the loop until we succeed.
 //
-//    Unlike LLVM, we do not try to find a loop count before unrolling.
+//    Unlike LLVM, we do not require a loop count before unrolling.
 //    Instead, we unroll to find a constant terminal condition. Give up when we
 //    fail to do so.
 //
+//    When SCEV can prove the trip count of the latch, we take a fast path:
+//    the body is cloned exactly that many times and remapped, without
+//    querying DxilValueCache for the exit condition of every iteration. The
+//    unrolled region is simplified once afterwards instead.
+//
 //
 //===----------------------------------------------------------------------===//
 
@@ -764,6 +769,35 @@ static void RemapDebugInsts(BasicBlock *ClonedBB, ValueToValueMapTy &VarMap,
   }
 }
 
+// Simplify the blocks of every cloned iteration in a single forward sweep.
+// Iterations were cloned in order, so the values an iteration depends on
+// have already been folded by the time it is visited.
+static void
+SimplifyUnrolledIterations(ArrayRef<std::unique_ptr<ClonedIteration>> Iterations,
+                           Function &F, const DataLayout &DL, DominatorTree *DT,
+                           AssumptionCache *AC, DxilValueCache *DVC) {
+  bool Changed = false;
+  for (const std::unique_ptr<ClonedIteration> &IterPtr : Iterations) {
+    for (BasicBlock *BB : IterPtr->Body) {
+      for (BasicBlock::iterator It = BB->begin(), E = BB->end(); It != E;) {
+        Instruction *I = It++;
+        Value *V = llvm::SimplifyInstruction(I, DL, nullptr, DT, AC);
+        if (V && V != I) {
+          I->replaceAllUsesWith(V);
+          if (isInstructionTriviallyDead(I))
+            I->eraseFromParent();
+          Changed = true;
+        }
+      }
+    }
+  }
+
+  // Erased instructions drop out of the value cache through its handles, but
+  // values it could not resolve before may fold now.
+  if (Changed)
+    DVC->ResetUnknowns(F);
+}
+
 bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
 
   DebugLoc LoopLoc =
@@ -805,6 +839,12 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
     TripCount = SE->getSmallConstantTripCount(L, ExitingBlock);
   }
 
+  // If the trip count was computed for the latch itself, the latch condition
+  // of every iteration but the last is known to branch back to the header.
+  // There is no need to look for a constant exit condition as we go.
+  const bool HasProvenTripCount =
+      TripCount != 0 && ExitingBlock == L->getLoopLatch();
+
   // Analysis passes
   DominatorTree *DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
   AssumptionCache *AC =
@@ -942,6 +982,29 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
   // Re-establish LCSSA form to get ready for unrolling.
   CreateLCSSA(ToBeCloned, NewExits, L, *DT, LI);
 
+  // Record every edge leaving the cloned region along with the value its
+  // destination PHIs receive from it. Each iteration adds an incoming value
+  // to these PHIs, so looking the original value up again for every clone
+  // would be quadratic in the number of iterations.
+  struct ExitPHIEdge {
+    BasicBlock *From;
+    PHINode *PN;
+    Value *Incoming;
+  };
+  SmallVector<ExitPHIEdge, 16> ExitPHIEdges;
+  for (BasicBlock *BB : ToBeCloned) {
+    for (BasicBlock *Succ : successors(BB)) {
+      if (ToBeCloned.count(Succ))
+        continue;
+      for (Instruction &I : *Succ) {
+        PHINode *PN = dyn_cast<PHINode>(&I);
+        if (!PN)
+          break;
+        ExitPHIEdges.push_back({BB, PN, PN->getIncomingValueForBlock(BB)});
+      }
+    }
+  }
+
   SmallVector<std::unique_ptr<ClonedIteration>, 16>
       Iterations; // List of cloned iterations
   bool Succeeded = false;
@@ -991,30 +1054,19 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
       }
     }
 
-    for (BasicBlock *BB : ToBeCloned) {
-      BasicBlock *ClonedBB = cast<BasicBlock>(CurIteration.VarMap[BB]);
-      // If branching to outside of the loop, need to update the
-      // phi nodes there to include new values.
-      for (BasicBlock *Succ : successors(ClonedBB)) {
-        if (ToBeCloned.count(Succ))
-          continue;
-        for (Instruction &I : *Succ) {
-          PHINode *PN = dyn_cast<PHINode>(&I);
-          if (!PN)
-            break;
-
-          // Find the incoming value for this new block. If there is an entry
-          // for this block in the map, then it was defined in the loop, use it.
-          // Otherwise it came from outside the loop.
-          Value *OldIncoming = PN->getIncomingValueForBlock(BB);
-          Value *NewIncoming = OldIncoming;
-          ValueToValueMapTy::iterator Itor =
-              CurIteration.VarMap.find(OldIncoming);
-          if (Itor != CurIteration.VarMap.end())
-            NewIncoming = Itor->second;
-          PN->addIncoming(NewIncoming, ClonedBB);
-        }
-      }
+    // If branching to outside of the loop, need to update the
+    // phi nodes there to include new values.
+    for (const ExitPHIEdge &Edge : ExitPHIEdges) {
+      BasicBlock *ClonedBB = cast<BasicBlock>(CurIteration.VarMap[Edge.From]);
+
+      // Find the incoming value for this new block. If there is an entry
+      // for this block in the map, then it was defined in the loop, use it.
+      // Otherwise it came from outside the loop.
+      Value *NewIncoming = Edge.Incoming;
+      ValueToValueMapTy::iterator Itor = CurIteration.VarMap.find(NewIncoming);
+      if (Itor != CurIteration.VarMap.end())
+        NewIncoming = Itor->second;
+      Edge.PN->addIncoming(NewIncoming, ClonedBB);
     }
 
     // Remap the instructions inside of cloned blocks.
@@ -1062,9 +1114,14 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
       }
     }
 
-    // Check exit condition to see if we fully unrolled the loop
-    if (BranchInst *BI =
-            dyn_cast<BranchInst>(CurIteration.Latch->getTerminator())) {
+    // Check exit condition to see if we fully unrolled the loop. With a
+    // proven trip count this can only happen on the last iteration, which is
+    // handled below.
+    BranchInst *BI =
+        HasProvenTripCount
+            ? nullptr
+            : dyn_cast<BranchInst>(CurIteration.Latch->getTerminator());
+    if (BI) {
       bool Cond = false;
 
       Value *ConstantCond = BI->getCondition();
@@ -1179,6 +1236,11 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
     // recalculate.
     DT->recalculate(*F);
 
+    // The fast path never asked DxilValueCache about the cloned iterations.
+    // Simplify the whole unrolled region once now instead.
+    if (HasProvenTripCount)
+      SimplifyUnrolledIterations(Iterations, *F, DL, DT, AC, DVC);
+
     if (OuterL) {
       // This process may have created multiple back edges for the
       // parent loop. Simplify to keep it well-formed.
@@ -1194,7 +1256,7 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
                      "Could not unroll loop due to out of bound array access.");
     }
 
-    DVC->ResetUnknowns();
+    DVC->ResetUnknowns(*F);
 
     return true;
   }
@@ -207,7 +207,7 @@ bool DeadBlockDeleter::Run(Function &F, DxilValueCache *DVC) {
     BB->eraseFromParent();
   }
 
-  DVC->ResetUnknowns();
+  DVC->ResetUnknowns(F);
 
   return true;
 }
@@ -353,8 +353,10 @@ static bool DeleteNonContributingValues(Function &F, DxilValueCache *DVC) {
 
   ValueDeleter Deleter;
 
-  DVC->ResetAll();
+  // The skip callback gives the cache a separate set of values, so values
+  // cached for other passes don't need to be thrown away.
   DVC->SetShouldSkipCallback(ShouldNotReplaceValue);
+  DVC->ResetUnknowns(F);
   bool Changed = Deleter.Run(F, DVC);
   DVC->SetShouldSkipCallback(nullptr);
   return Changed;
@@ -384,6 +386,8 @@ struct DxilRemoveDeadBlocks : public FunctionPass {
   bool runOnFunction(Function &F) override {
     DxilValueCache *DVC = &getAnalysis<DxilValueCache>();
     EnsureDxilModule(F.getParent()); // Ensure dxil module is available for DVC
+    // Other passes may have changed F since its values were last looked at.
+    DVC->ResetUnknowns(F);
     bool Changed = false;
     Changed |= hlsl::dxilutil::DeleteDeadAllocas(F);
     Changed |= DeleteDeadBlocks(F, DVC);
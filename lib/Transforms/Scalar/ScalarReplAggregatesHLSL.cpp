@@ -74,6 +74,8 @@ STATISTIC(NumReplaced, "Number of allocas broken up");
 
 namespace {
 
+struct SROASizeLimits;
+
 class SROA_Helper {
 public:
   // Split V into AllocaInsts with Builder and save the new AllocaInsts into
@@ -95,10 +97,12 @@ public:
                                   DominatorTree *DT);
   static unsigned GetEltAlign(unsigned ValueAlign, const DataLayout &DL,
                               Type *EltTy, unsigned Offset);
-  // Lower memcpy related to V.
+  // Lower memcpy related to V. With Limits, oversized array copies are done
+  // in a loop when DT is available.
   static bool LowerMemcpy(Value *V, DxilFieldAnnotation *annotation,
                           DxilTypeSystem &typeSys, const DataLayout &DL,
-                          DominatorTree *DT, bool bAllowReplace);
+                          DominatorTree *DT, bool bAllowReplace,
+                          SROASizeLimits *Limits = nullptr);
   static void MarkEmptyStructUsers(Value *V,
                                    SmallVector<Value *, 32> &DeadInsts);
   static bool IsEmptyStructType(Type *Ty, DxilTypeSystem &typeSys);
@@ -133,6 +137,78 @@ private:
 
 } // namespace
 
+/// getAggregateLeafCount - Estimate the number of scalar leaves Ty would be
+/// split into if it were flattened all the way down.
+static uint64_t getAggregateLeafCount(Type *Ty) {
+  if (ArrayType *AT = dyn_cast<ArrayType>(Ty))
+    return AT->getNumElements() * getAggregateLeafCount(AT->getElementType());
+  if (StructType *ST = dyn_cast<StructType>(Ty)) {
+    uint64_t Count = 0;
+    for (Type *EltTy : ST->elements())
+      Count += getAggregateLeafCount(EltTy);
+    return Count;
+  }
+  if (VectorType *VT = dyn_cast<VectorType>(Ty))
+    return VT->getNumElements();
+  return 1;
+}
+
+namespace {
+
+/// Rough size of the IR an unrolled copy adds for each scalar leaf: a GEP on
+/// each side, a load and a store.
+const uint64_t kBytesPerCopiedLeaf =
+    2 * sizeof(GetElementPtrInst) + sizeof(LoadInst) + sizeof(StoreInst);
+
+/// SROASizeLimits - Limits for the size-aware mode of SROAGlobalAndAllocas.
+/// Oversized arrays of vectors that are only accessed element by element are
+/// kept whole, and copies of oversized arrays are done in a loop instead of
+/// one copy per element.
+struct SROASizeLimits {
+  // Arrays with more scalar leaves than this are oversized. 0 is no limit.
+  uint64_t MaxAggregateLeaves = 0;
+  // Estimated bytes of IR unrolled copies may add to the module. Once an
+  // aggregate would go over it, it is oversized. 0 is no limit.
+  uint64_t MemoryBudget = 0;
+  // Estimated bytes of IR added by unrolled copies so far.
+  uint64_t MemoryUsed = 0;
+
+  bool isEnabled() const { return MaxAggregateLeaves || MemoryBudget; }
+  bool isOversized(Type *Ty) const {
+    uint64_t Leaves = getAggregateLeafCount(Ty);
+    if (MaxAggregateLeaves && Leaves > MaxAggregateLeaves)
+      return true;
+    return MemoryBudget &&
+           MemoryUsed + Leaves * kBytesPerCopiedLeaf > MemoryBudget;
+  }
+  void chargeCopy(Type *Ty) {
+    MemoryUsed += getAggregateLeafCount(Ty) * kBytesPerCopiedLeaf;
+  }
+};
+
+} // namespace
+
+/// onlyHasElementAccesses - Return true if V is only loaded and stored one
+/// scalar or vector at a time, through GEPs.
+static bool onlyHasElementAccesses(Value *V) {
+  for (User *U : V->users()) {
+    if (GEPOperator *GEP = dyn_cast<GEPOperator>(U)) {
+      if (!onlyHasElementAccesses(GEP))
+        return false;
+    } else if (LoadInst *LI = dyn_cast<LoadInst>(U)) {
+      if (LI->getType()->isAggregateType())
+        return false;
+    } else if (StoreInst *SI = dyn_cast<StoreInst>(U)) {
+      if (SI->getPointerOperand() != V ||
+          SI->getValueOperand()->getType()->isAggregateType())
+        return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
 static unsigned getNestedLevelInStruct(const Type *ty) {
   unsigned lvl = 0;
   while (ty->isStructTy()) {
@@ -1153,6 +1229,77 @@ void MemcpySplitter::SplitMemCpy(MemCpyInst *MI, const DataLayout &DL,
   DeleteMemcpy(MI);
 }
 
+// Emit a loop before InsertPt that copies every element of AT, nesting one
+// loop per array dimension. DT is kept up to date.
+void EmitArrayCpyLoop(ArrayType *AT, Value *Dest, Value *Src,
+                      SmallVector<Value *, 16> &idxList, Instruction *InsertPt,
+                      const DataLayout &DL, DxilTypeSystem &typeSys,
+                      DominatorTree *DT) {
+  BasicBlock *Preheader = InsertPt->getParent();
+  BasicBlock *Exit = SplitBlock(Preheader, InsertPt, DT);
+  BasicBlock *Body = SplitBlock(Preheader, Preheader->getTerminator(), DT);
+  Body->setName("array.cpy");
+  Exit->setName("array.cpy.end");
+
+  // Nested loops split Body, so the branch to Exit ends up in the latch.
+  BranchInst *ExitBr = cast<BranchInst>(Body->getTerminator());
+  IRBuilder<> Builder(ExitBr);
+  Type *i32Ty = Type::getInt32Ty(AT->getContext());
+  PHINode *Idx = Builder.CreatePHI(i32Ty, 2, "array.cpy.idx");
+  Idx->addIncoming(ConstantInt::get(i32Ty, 0), Preheader);
+
+  idxList.emplace_back(Idx);
+  Type *EltTy = AT->getElementType();
+  if (ArrayType *EltAT = dyn_cast<ArrayType>(EltTy))
+    EmitArrayCpyLoop(EltAT, Dest, Src, idxList, ExitBr, DL, typeSys, DT);
+  else
+    SplitCpy(EltTy, Dest, Src, idxList, Builder, DL, typeSys,
+             /*fieldAnnotation*/ nullptr, /*bEltMemCpy*/ false);
+  idxList.pop_back();
+
+  BasicBlock *Latch = ExitBr->getParent();
+  Builder.SetInsertPoint(ExitBr);
+  Value *Next = Builder.CreateAdd(Idx, ConstantInt::get(i32Ty, 1));
+  Idx->addIncoming(Next, Latch);
+  Value *Done =
+      Builder.CreateICmpEQ(Next, ConstantInt::get(i32Ty, AT->getNumElements()));
+  // The back edge goes to a block that dominates the latch, so DT is still
+  // right.
+  Builder.CreateCondBr(Done, Exit, Body);
+  ExitBr->eraseFromParent();
+}
+
+// Copy an oversized array in a loop instead of one element at a time, so the
+// IR stays linear in the element size rather than the array size. Return
+// false if MI is left for SplitMemCpy.
+bool SplitArrayCpyWithLoop(MemCpyInst *MI, const SROASizeLimits &Limits,
+                           const DataLayout &DL, DxilTypeSystem &typeSys,
+                           DominatorTree *DT) {
+  Value *Dest = MI->getRawDest();
+  Value *Src = MI->getRawSource();
+  // Only remove one level bitcast generated from inline.
+  if (BitCastOperator *BC = dyn_cast<BitCastOperator>(Dest))
+    Dest = BC->getOperand(0);
+  if (BitCastOperator *BC = dyn_cast<BitCastOperator>(Src))
+    Src = BC->getOperand(0);
+
+  ArrayType *AT = dyn_cast<ArrayType>(Dest->getType()->getPointerElementType());
+  if (!AT || Dest == Src || AT != Src->getType()->getPointerElementType() ||
+      !Limits.isOversized(AT))
+    return false;
+  // Matrix arrays need the orientation SplitMemCpy finds from their users,
+  // and objects cannot be dynamically indexed.
+  if (HLMatrixType::isa(dxilutil::GetArrayEltTy(AT)) ||
+      dxilutil::ContainsHLSLObjectType(AT))
+    return false;
+
+  SmallVector<Value *, 16> idxList;
+  idxList.emplace_back(ConstantInt::get(Type::getInt32Ty(AT->getContext()), 0));
+  EmitArrayCpyLoop(AT, Dest, Src, idxList, MI, DL, typeSys, DT);
+  DeleteMemcpy(MI);
+  return true;
+}
+
 void MemcpySplitter::Split(llvm::Function &F) {
   const DataLayout &DL = F.getParent()->getDataLayout();
   SmallVector<Function *, 2> memcpys;
@@ -1762,7 +1909,8 @@ bool isGroupShareOrConstStaticArray(GlobalVariable *GV) {
   return Ty->isArrayTy();
 }
 
-bool SROAGlobalAndAllocas(HLModule &HLM, bool bHasDbgInfo) {
+bool SROAGlobalAndAllocas(HLModule &HLM, bool bHasDbgInfo,
+                          SROASizeLimits &Limits) {
   Module &M = *HLM.GetModule();
   bool SupportsVectors = HLM.GetShaderModel()->IsSM69Plus();
   DxilTypeSystem &typeSys = HLM.GetTypeSystem();
@@ -1869,7 +2017,7 @@ bool SROAGlobalAndAllocas(HLModule &HLM, bool bHasDbgInfo) {
       const bool bAllowReplace = true;
       DominatorTree &DT = domTreeMap[F];
       if (SROA_Helper::LowerMemcpy(AI, /*annotation*/ nullptr, typeSys, DL, &DT,
-                                   bAllowReplace)) {
+                                   bAllowReplace, &Limits)) {
         if (AI->use_empty())
           AI->eraseFromParent();
         Changed = true;
@@ -1916,6 +2064,17 @@ bool SROAGlobalAndAllocas(HLModule &HLM, bool bHasDbgInfo) {
         continue;
       }
 
+      // In size-aware mode, keep oversized arrays of vectors that are only
+      // accessed element by element as arrays. DynamicIndexingVectorToArray
+      // and MultiDimArrayToOneDimArray lower them to a single dynamically
+      // indexed array later. Arrays of structs are still split into one array
+      // per field, which is linear in the field count; their copies were
+      // turned into loops by LowerMemcpy above.
+      if (Limits.isEnabled() && Ty->isArrayTy() &&
+          dxilutil::GetArrayEltTy(Ty)->isVectorTy() &&
+          Limits.isOversized(Ty) && onlyHasElementAccesses(AI))
+        continue;
+
       // If the alloca looks like a good candidate for scalar replacement, and
       // if
       // all its users can be transformed, then split up the aggregate into its
@@ -1993,7 +2152,7 @@ bool SROAGlobalAndAllocas(HLModule &HLM, bool bHasDbgInfo) {
       // SROA_Parameter_HLSL has no access to a domtree, if one is needed, it'll
       // be generated
       if (SROA_Helper::LowerMemcpy(GV, /*annotation*/ nullptr, typeSys, DL,
-                                   nullptr /*DT */, bAllowReplace)) {
+                                   nullptr /*DT */, bAllowReplace, &Limits)) {
         continue;
       }
 
@@ -4111,7 +4270,8 @@ static bool allStoresDominateInst(Value *V, Instruction *I, DominatorTree *DT) {
 
 bool SROA_Helper::LowerMemcpy(Value *V, DxilFieldAnnotation *annotation,
                               DxilTypeSystem &typeSys, const DataLayout &DL,
-                              DominatorTree *DT, bool bAllowReplace) {
+                              DominatorTree *DT, bool bAllowReplace,
+                              SROASizeLimits *Limits) {
   Type *Ty = V->getType();
   if (!Ty->isPointerTy()) {
     return false;
@@ -4177,7 +4337,7 @@ bool SROA_Helper::LowerMemcpy(Value *V, DxilFieldAnnotation *annotation,
                 if (V->user_empty())
                   return true;
                 return LowerMemcpy(V, annotation, typeSys, DL, DT,
-                                   bAllowReplace);
+                                   bAllowReplace, Limits);
               }
             }
           }
@@ -4196,7 +4356,8 @@ bool SROA_Helper::LowerMemcpy(Value *V, DxilFieldAnnotation *annotation,
             if (ReplaceMemcpy(V, Src, MC, annotation, typeSys, DL, DT)) {
               if (V->user_empty())
                 return true;
-              return LowerMemcpy(V, annotation, typeSys, DL, DT, bAllowReplace);
+              return LowerMemcpy(V, annotation, typeSys, DL, DT, bAllowReplace,
+                                 Limits);
             }
           }
         }
@@ -4224,7 +4385,8 @@ bool SROA_Helper::LowerMemcpy(Value *V, DxilFieldAnnotation *annotation,
             if (ReplaceMemcpy(Dest, V, MC, annotation, typeSys, DL, DT)) {
               // V still needs to be flattened.
               // Lower memcpy come from Dest.
-              return LowerMemcpy(V, annotation, typeSys, DL, DT, bAllowReplace);
+              return LowerMemcpy(V, annotation, typeSys, DL, DT, bAllowReplace,
+                                 Limits);
             }
           }
         }
@@ -4233,6 +4395,14 @@ bool SROA_Helper::LowerMemcpy(Value *V, DxilFieldAnnotation *annotation,
   }
 
   for (MemCpyInst *MC : PS.memcpySet) {
+    if (Limits && Limits->isEnabled()) {
+      if (DT && SplitArrayCpyWithLoop(MC, *Limits, DL, typeSys, DT))
+        continue;
+      Value *Dest = MC->getRawDest();
+      if (BitCastOperator *BC = dyn_cast<BitCastOperator>(Dest))
+        Dest = BC->getOperand(0);
+      Limits->chargeCopy(Dest->getType()->getPointerElementType());
+    }
     MemcpySplitter::SplitMemCpy(MC, DL, annotation, typeSys);
   }
   return false;
@@ -4393,8 +4563,23 @@ class SROA_Parameter_HLSL : public ModulePass {
 
 public:
   static char ID; // Pass identification, replacement for typeid
-  explicit SROA_Parameter_HLSL() : ModulePass(ID) {}
+  explicit SROA_Parameter_HLSL(unsigned MaxAggregateLeaves = 0,
+                               unsigned MemoryBudgetKB = 0)
+      : ModulePass(ID), MaxAggregateLeaves(MaxAggregateLeaves),
+        MemoryBudgetKB(MemoryBudgetKB) {}
   StringRef getPassName() const override { return "SROA Parameter HLSL"; }
+
+  // Function overrides that resolve options when used for DxOpt
+  void applyOptions(PassOptions O) override {
+    GetPassOptionUnsigned(O, "MaxAggregateLeaves", &MaxAggregateLeaves,
+                          false);
+    GetPassOptionUnsigned(O, "MemoryBudgetKB", &MemoryBudgetKB, false);
+  }
+  void dumpConfig(raw_ostream &OS) override {
+    ModulePass::dumpConfig(OS);
+    OS << ",MaxAggregateLeaves=" << MaxAggregateLeaves;
+    OS << ",MemoryBudgetKB=" << MemoryBudgetKB;
+  }
   static void RewriteBitcastWithIdenticalStructs(Function *F);
   static void RewriteBitcastWithIdenticalStructs(BitCastInst *BCI);
   static bool DeleteSimpleStoreOnlyAlloca(AllocaInst *AI);
@@ -4500,7 +4685,10 @@ public:
     copyIntrinsicAggArgs(*m_pHLModule);
 
     // SROA globals and allocas.
-    SROAGlobalAndAllocas(*m_pHLModule, m_HasDbgInfo);
+    SROASizeLimits Limits;
+    Limits.MaxAggregateLeaves = MaxAggregateLeaves;
+    Limits.MemoryBudget = (uint64_t)MemoryBudgetKB * 1024;
+    SROAGlobalAndAllocas(*m_pHLModule, m_HasDbgInfo, Limits);
 
     // Move up allocas that might have been pushed down by instruction inserts
     SmallVector<AllocaInst *, 16> simpleStoreOnlyAllocas;
@@ -4581,6 +4769,13 @@ private:
   // Set for row major matrix parameter.
   std::unordered_set<Value *> castRowMajorParamMap;
   bool m_HasDbgInfo;
+  // Arrays with more leaves than this are copied in a loop, and kept as
+  // arrays when they are arrays of vectors only accessed element by element.
+  // 0 means no limit.
+  unsigned MaxAggregateLeaves;
+  // Estimated KB of IR unrolled aggregate copies may add before every array
+  // is treated as over MaxAggregateLeaves. 0 means no limit.
+  unsigned MemoryBudgetKB;
 };
 
 // When replacing aggregates by its scalar elements,
@@ -6494,8 +6689,9 @@ void SROA_Parameter_HLSL::replaceCall(Function *F, Function *flatF) {
 }
 
 // Public interface to the SROA_Parameter_HLSL pass
-ModulePass *llvm::createSROA_Parameter_HLSL() {
-  return new SROA_Parameter_HLSL();
+ModulePass *llvm::createSROA_Parameter_HLSL(unsigned MaxAggregateLeaves,
+                                            unsigned MemoryBudgetKB) {
+  return new SROA_Parameter_HLSL(MaxAggregateLeaves, MemoryBudgetKB);
 }
 
 //===----------------------------------------------------------------------===//
@@ -1209,6 +1209,7 @@ enum CXTranslationUnit_Flags {
    */
   CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80,
   CXTranslationUnit_UseCallerThread = 0x800, // HLSL Change - add a flag
+  CXTranslationUnit_SkipPreambleFunctionBodies = 0x1000, // HLSL Change
 };
 
 /**
@@ -192,6 +192,19 @@ private:
   /// some number of calls.
   unsigned PreambleRebuildCounter;
 
+  // HLSL Change Starts
+  /// \brief Whether function bodies declared in files included from the main
+  /// file's preamble are skipped while parsing.
+  ///
+  /// The declarations in the preamble headers are still parsed on each
+  /// reparse, but their bodies are not.
+  bool SkipPreambleFunctionBodies;
+
+  /// \brief Size in bytes of the main file preamble for the current parse,
+  /// when SkipPreambleFunctionBodies is set.
+  unsigned SkippedPreambleSize;
+  // HLSL Change Ends
+
 public:
   hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions; // HLSL Change
 
@@ -611,6 +624,13 @@ public:
   /// Note: This is used internally by the top-level tracking action
   unsigned &getCurrentTopLevelHashValue() { return CurrentTopLevelHashValue; }
 
+  // HLSL Change Starts
+  /// \brief Whether the body of the given function should be skipped.
+  ///
+  /// Note: This is used internally by the top-level tracking action
+  bool shouldSkipFunctionBody(Decl *D);
+  // HLSL Change Ends
+
   /// \brief Get the source location for the given file:line:col triplet.
   ///
   /// The difference with SourceManager::getLocation is that this method checks
@@ -863,7 +883,8 @@ public:
       bool AllowPCHWithCompilerErrors = false, bool SkipFunctionBodies = false,
       bool UserFilesAreVolatile = false, bool ForSerialization = false,
       std::unique_ptr<ASTUnit> *ErrAST = nullptr,
-      hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions = nullptr); // HLSL Change
+      hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions = nullptr, // HLSL Change
+      bool SkipPreambleFunctionBodies = false); // HLSL Change
 
   /// \brief Reparse the source files using the same command-line options that
   /// were originally used to produce this translation unit.
@@ -139,6 +139,10 @@ GetBestViableFunction(clang::Sema &S, clang::SourceLocation Loc,
 bool ShouldSkipNRVO(clang::Sema &sema, clang::QualType returnType,
                     clang::VarDecl *VD, clang::FunctionDecl *FD);
 
+/// <summary>Whether the function has a body, or had one that was skipped
+/// while parsing (as IntelliSense does for preamble headers).</summary>
+bool HasBodyOrSkippedBody(const clang::FunctionDecl *FD);
+
 /// <summary>Processes an attribute for a declaration.</summary>
 /// <param name="S">Sema with context.</param>
 /// <param name="D">Annotated declaration.</param>
@@ -11,6 +11,7 @@
 #include "dxc/HLSL/DxilGenerationPass.h" // HLSL Change
 #include "dxc/HLSL/HLMatrixLowerPass.h"  // HLSL Change
 #include "dxc/Support/Global.h"          // HLSL Change
+#include "dxc/Support/WorkerThreads.h"   // HLSL Change
 #include "dxc/config.h"                  // HLSL Change
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
@@ -361,6 +362,13 @@ void EmitAssemblyHelper::CreatePasses() {
       OptToggles.IsEnabled(hlsl::options::TOGGLE_PARTIAL_LIFETIME_MARKERS);
   PMBuilder.HLSLEnableAggressiveReassociation = OptToggles.IsEnabled(
       hlsl::options::TOGGLE_ENABLE_AGGRESSIVE_REASSOCIATION);
+  PMBuilder.HLSLParallelLibOpt =
+      StringRef(CodeGenOpts.HLSLProfile).startswith("lib_") &&
+      OptToggles.IsEnabled(hlsl::options::TOGGLE_PARALLEL_LIB_OPT);
+  PMBuilder.HLSLSROAMaxAggregateLeaves = OptToggles.GetSelectUnsigned(
+      hlsl::options::SELECT_SROA_MAX_AGGREGATE_LEAVES, 0);
+  PMBuilder.HLSLSROAMemoryBudgetKB = OptToggles.GetSelectUnsigned(
+      hlsl::options::SELECT_SROA_MEMORY_BUDGET_KB, 0);
   // HLSL Change - end
 
   PMBuilder.DisableUnitAtATime = !CodeGenOpts.UnitAtATime;
@@ -703,10 +711,22 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
   case Backend_EmitPasses: // HLSL Change
     break;
 
-  case Backend_EmitBC:
+  case Backend_EmitBC: {
+    // HLSL Change Begin - Optionally encode function blocks on worker threads.
+    BitcodeWriterThreads Threads;
+    const hlsl::options::OptimizationToggles &OptToggles =
+        CodeGenOpts.HLSLOptimizationToggles;
+    if (OptToggles.IsEnabled(hlsl::options::TOGGLE_PARALLEL_BITCODE_WRITER)) {
+      Threads.NumThreads =
+          hlsl::GetWorkerThreadCount(OptToggles.GetSelectUnsigned(
+              hlsl::options::SELECT_PARALLEL_BITCODE_WRITER_THREADS, 0));
+      Threads.RunOnWorker = hlsl::CreateWorkerRunner();
+    }
     getPerModulePasses()->add(
-        createBitcodeWriterPass(*OS, CodeGenOpts.EmitLLVMUseLists));
+        createBitcodeWriterPass(*OS, CodeGenOpts.EmitLLVMUseLists, Threads));
+    // HLSL Change End
     break;
+  }
 
   case Backend_EmitLL:
     getPerModulePasses()->add(
@@ -211,6 +211,7 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
     OwnsRemappedFileBuffers(true),
     NumStoredDiagnosticsFromDriver(0),
     PreambleRebuildCounter(0),
+    SkipPreambleFunctionBodies(false), SkippedPreambleSize(0), // HLSL Change
     HlslLangExtensions(nullptr),    // HLSL Change
     NumWarningsInPreamble(0),
     ShouldCacheCodeCompletionResults(false),
@@ -888,6 +889,12 @@ public:
   ASTDeserializationListener *GetASTDeserializationListener() override {
     return nullptr; // return Unit.getDeserializationListener(); // HLSL Change - no support for serialization
   }
+
+  // HLSL Change Starts
+  bool shouldSkipFunctionBody(Decl *D) override {
+    return Unit.shouldSkipFunctionBody(D);
+  }
+  // HLSL Change Ends
 };
 
 class TopLevelDeclTrackerAction : public ASTFrontendAction {
@@ -1163,6 +1170,21 @@ bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
   if (!Act->BeginSourceFile(*Clang.get(), Clang->getFrontendOpts().Inputs[0]))
     goto error;
 
+  // HLSL Change Starts - skip preamble function bodies
+  // The main buffer is taken from the source manager, as it may be an unsaved
+  // file that does not exist on disk.
+  SkippedPreambleSize = 0;
+  if (SkipPreambleFunctionBodies) {
+    SourceManager &SM = getSourceManager();
+    SkippedPreambleSize =
+        Lexer::ComputePreamble(SM.getBufferData(SM.getMainFileID()),
+                               Clang->getLangOpts(), /*MaxLines*/ 0)
+            .first;
+    if (SkippedPreambleSize)
+      Clang->getFrontendOpts().SkipFunctionBodies = true;
+  }
+  // HLSL Change Ends
+
   if (SavedMainFileBuffer) {
     std::string ModName = getPreambleFile(this);
     TranslateStoredDiagnostics(getFileManager(), getSourceManager(),
@@ -1975,7 +1997,8 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
     bool AllowPCHWithCompilerErrors, bool SkipFunctionBodies,
     bool UserFilesAreVolatile, bool ForSerialization,
     std::unique_ptr<ASTUnit> *ErrAST,
-    hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions) { // HLSL Change
+    hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions, // HLSL Change
+    bool SkipPreambleFunctionBodies) { // HLSL Change
   assert(Diags.get() && "no DiagnosticsEngine was provided");
 
   SmallVector<StoredDiagnostic, 4> StoredDiagnostics;
@@ -2044,6 +2067,7 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
   AST.reset(new ASTUnit(false));
   // HLSL Change Starts
   AST->HlslLangExtensions = HlslLangExtensions;
+  AST->SkipPreambleFunctionBodies = SkipPreambleFunctionBodies;
   // Enable -verify and -verify-ignore-unexpected on the libclang initialization path.
   bool VerifyDiagnostics = CI->getDiagnosticOpts().VerifyDiagnostics;
   Diags->getDiagnosticOptions().setVerifyIgnoreUnexpected(
@@ -2645,6 +2669,38 @@ void ASTUnit::TranslateStoredDiagnostics(
   Result.swap(Out);
 }
 
+// HLSL Change Starts
+bool ASTUnit::shouldSkipFunctionBody(Decl *D) {
+  // Honor an explicit request to skip every function body.
+  if (Invocation->getFrontendOpts().SkipFunctionBodies)
+    return true;
+  if (!SkipPreambleFunctionBodies || !SkippedPreambleSize)
+    return false;
+
+  // Templates may be instantiated from the main file, which needs their
+  // bodies.
+  if (const FunctionDecl *FD = D->getAsFunction())
+    if (FD->isDependentContext())
+      return false;
+
+  // Only skip bodies that come from a file included, directly or not, by an
+  // #include in the main file preamble.
+  SourceManager &SM = getSourceManager();
+  FileID MainFID = SM.getMainFileID();
+  FileID FID = SM.getFileID(SM.getFileLoc(D->getLocation()));
+  while (!FID.isInvalid() && FID != MainFID) {
+    SourceLocation IncludeLoc = SM.getIncludeLoc(FID);
+    if (IncludeLoc.isInvalid())
+      return false;
+    FileID IncluderFID = SM.getFileID(IncludeLoc);
+    if (IncluderFID == MainFID)
+      return SM.getFileOffset(IncludeLoc) < SkippedPreambleSize;
+    FID = IncluderFID;
+  }
+  return false;
+}
+// HLSL Change Ends
+
 void ASTUnit::addFileLevelDecl(Decl *D) {
   assert(D);
   
@@ -686,6 +686,10 @@ DiagnosePayloadAsFunctionArg(
 
       // Handle external function calls
       if (!CalledFunction->hasBody()) {
+        // A body skipped while parsing is not external, but cannot be
+        // checked either.
+        if (HasBodyOrSkippedBody(CalledFunction))
+          continue;
         assert(isa<ParmVarDecl>(Info.Payload));
         DiagnoseCallExprForExternal(S, CalledFunction, Call,
                                     cast<ParmVarDecl>(Info.Payload));
@@ -45,6 +45,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
@@ -1903,6 +1904,39 @@ static bool IsVariadicArgument(const HLSL_INTRINSIC_ARGUMENT &arg) {
   return arg.uTemplateId == INTRIN_TEMPLATE_VARARGS;
 }
 
+// Returns the generated name index for one of the builtin intrinsic tables, or
+// nullptr if table isn't one of them.
+static const HLSL_INTRINSIC_NAME_INDEX *
+FindIntrinsicNameIndex(const HLSL_INTRINSIC *table) {
+  // The registry is constant, so it is mapped by table once per process.
+  using IndexByTableMap = llvm::DenseMap<const HLSL_INTRINSIC *,
+                                         const HLSL_INTRINSIC_NAME_INDEX *>;
+  static const IndexByTableMap indexByTable = [] {
+    IndexByTableMap map;
+    for (const HLSL_INTRINSIC_NAME_INDEX &index : g_IntrinsicNameIndices)
+      map[index.pTable] = &index;
+    return map;
+  }();
+  auto it = indexByTable.find(table);
+  return it == indexByTable.end() ? nullptr : it->second;
+}
+
+// Returns the range of entries in index's table with the given name, or
+// nullptr if there are none.
+static const HLSL_INTRINSIC_NAME_RANGE *
+LookupIntrinsicNameRange(const HLSL_INTRINSIC_NAME_INDEX &index,
+                         StringRef name) {
+  UINT bucket =
+      HashIntrinsicName(name.data(), name.size(), 0) % index.uSlotCount;
+  UINT slot =
+      HashIntrinsicName(name.data(), name.size(), index.pSeeds[bucket]) %
+      index.uSlotCount;
+  const HLSL_INTRINSIC_NAME_RANGE &range = index.pSlots[slot];
+  if (!name.equals(index.pTable[range.uFirst].pArgs[0].pName))
+    return nullptr;
+  return &range;
+}
+
 static hlsl::ParameterModifier
 ParamModsFromIntrinsicArg(const HLSL_INTRINSIC_ARGUMENT *pArg) {
   UINT64 qwUsage = pArg->qwUsage & AR_QUAL_IN_OUT;
@@ -2568,74 +2602,61 @@ static bool TemplateHasDefaultType(ArBasicKind kind) {
   }
 }
 
+/// <summary>
+/// An intrinsic returned by IDxcIntrinsicTable::LookupIntrinsic, along with
+/// the index of the table that returned it.
+/// </summary>
+struct ExtensionIntrinsic {
+  unsigned TableIndex;
+  const HLSL_INTRINSIC *Intrinsic;
+};
+
 /// <summary>
 /// Use this class to iterate over intrinsic definitions that come from an
 /// external source.
 /// </summary>
 class IntrinsicTableDefIter {
 private:
-  StringRef _typeName;
-  StringRef _functionName;
   llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2> &_tables;
-  const HLSL_INTRINSIC *_tableIntrinsic;
-  UINT64 _tableLookupCookie;
-  unsigned _tableIndex;
+  llvm::ArrayRef<ExtensionIntrinsic> _intrinsics;
+  size_t _index;
   unsigned _argCount;
   bool _firstChecked;
 
   IntrinsicTableDefIter(
       llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2> &tables,
-      StringRef typeName, StringRef functionName, unsigned argCount)
-      : _typeName(typeName), _functionName(functionName), _tables(tables),
-        _tableIntrinsic(nullptr), _tableLookupCookie(0), _tableIndex(0),
+      llvm::ArrayRef<ExtensionIntrinsic> intrinsics, unsigned argCount)
+      : _tables(tables), _intrinsics(intrinsics), _index(0),
         _argCount(argCount), _firstChecked(false) {}
 
-  void CheckForIntrinsic() {
-    if (_tableIndex >= _tables.size()) {
-      return;
-    }
-
+  void MoveToNext() {
+    if (_firstChecked)
+      _index++;
     _firstChecked = true;
-
-    // TODO: review this - this will allocate at least once per string
-    CA2WEX<> typeName(_typeName.str().c_str());
-    CA2WEX<> functionName(_functionName.str().c_str());
-
-    if (FAILED(_tables[_tableIndex]->LookupIntrinsic(
-            typeName, functionName, &_tableIntrinsic, &_tableLookupCookie))) {
-      _tableLookupCookie = 0;
-      _tableIntrinsic = nullptr;
-    }
+    while (_index < _intrinsics.size() &&
+           _intrinsics[_index].Intrinsic->uNumArgs !=
+               (_argCount + 1)) // uNumArgs includes return
+      _index++;
   }
 
-  void MoveToNext() {
-    for (;;) {
-      // If we don't have an intrinsic, try the following table.
-      if (_firstChecked && _tableIntrinsic == nullptr) {
-        _tableIndex++;
-      }
-
-      CheckForIntrinsic();
-      if (_tableIndex == _tables.size() ||
-          (_tableIntrinsic != nullptr &&
-           _tableIntrinsic->uNumArgs ==
-               (_argCount + 1))) // uNumArgs includes return
-        break;
-    }
-  }
+  bool IsAtEnd() const { return _index >= _intrinsics.size(); }
 
 public:
+  // intrinsics are all the matches for the name across the tables, in table
+  // order; see HLSLExternalSource::LookupExtensionIntrinsics.
   static IntrinsicTableDefIter
   CreateStart(llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2> &tables,
-              StringRef typeName, StringRef functionName, unsigned argCount) {
-    IntrinsicTableDefIter result(tables, typeName, functionName, argCount);
+              llvm::ArrayRef<ExtensionIntrinsic> intrinsics,
+              unsigned argCount) {
+    IntrinsicTableDefIter result(tables, intrinsics, argCount);
     return result;
   }
 
   static IntrinsicTableDefIter
   CreateEnd(llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2> &tables) {
-    IntrinsicTableDefIter result(tables, StringRef(), StringRef(), 0);
-    result._tableIndex = tables.size();
+    IntrinsicTableDefIter result(tables, llvm::ArrayRef<ExtensionIntrinsic>(),
+                                 0);
+    result._firstChecked = true;
     return result;
   }
 
@@ -2643,18 +2664,19 @@ public:
     if (!_firstChecked) {
       MoveToNext();
     }
-    return _tableIndex != other._tableIndex; // More things could be compared
-                                             // but we only match end.
+    return IsAtEnd() != other.IsAtEnd(); // More things could be compared
+                                         // but we only match end.
   }
 
   const HLSL_INTRINSIC *operator*() const {
     DXASSERT(_firstChecked, "otherwise deref without comparing to end");
-    return _tableIntrinsic;
+    return IsAtEnd() ? nullptr : _intrinsics[_index].Intrinsic;
   }
 
   LPCSTR GetTableName() const {
     LPCSTR tableName = nullptr;
-    if (FAILED(_tables[_tableIndex]->GetTableName(&tableName))) {
+    if (FAILED(_tables[_intrinsics[_index].TableIndex]->GetTableName(
+            &tableName))) {
       return nullptr;
     }
     return tableName;
@@ -2662,8 +2684,8 @@ public:
 
   LPCSTR GetLoweringStrategy() const {
     LPCSTR lowering = nullptr;
-    if (FAILED(_tables[_tableIndex]->GetLoweringStrategy(_tableIntrinsic->Op,
-                                                         &lowering))) {
+    if (FAILED(_tables[_intrinsics[_index].TableIndex]->GetLoweringStrategy(
+            _intrinsics[_index].Intrinsic->Op, &lowering))) {
       return nullptr;
     }
     return lowering;
@@ -3071,6 +3093,10 @@ private:
   // Intrinsic tables available externally.
   llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2> m_intrinsicTables;
 
+  // Intrinsics found in m_intrinsicTables, keyed by type and function name;
+  // see LookupExtensionIntrinsics.
+  llvm::StringMap<std::vector<ExtensionIntrinsic>> m_extensionIntrinsics;
+
   // Scalar types indexed by HLSLScalarType.
   QualType m_scalarTypes[HLSLScalarTypeCount];
 
@@ -3097,7 +3123,17 @@ private:
   TypedefDecl *m_hlslStringTypedef;
 
   // Built-in object types declarations, indexed by basic kind constant.
+  // Entries of types not declared yet are null; use GetObjectTypeDecl.
   CXXRecordDecl *m_objectTypeDecls[_countof(g_ArBasicKindsAsTypes)];
+  // Object types declared on first lookup of their name in the translation
+  // unit, or first use by index, mapped to their index.
+  llvm::DenseMap<const IdentifierInfo *, unsigned> m_lazyObjectTypes;
+  // Count of m_intrinsicTables whose methods have been added to each object
+  // type, indexed like m_objectTypeDecls.
+  unsigned m_objectIntrinsicTableCount[_countof(g_ArBasicKindsAsTypes)];
+  // Set once Sema is initialized far enough for CompleteType to add
+  // intrinsic table methods.
+  bool m_deferIntrinsicTableMethods;
   // Map from object decl to the object index.
   using ObjectTypeDeclMapType =
       std::array<std::pair<CXXRecordDecl *, unsigned>,
@@ -3658,7 +3694,7 @@ private:
                  "otherwise can't find constant in basic kinds");
         size_t index = match - g_ArBasicKindsAsTypes;
         paramTypes.push_back(
-            m_sema->getASTContext().getTypeDeclType(m_objectTypeDecls[index]));
+            m_sema->getASTContext().getTypeDeclType(GetObjectTypeDecl(index)));
         break;
       }
 #endif
@@ -3816,14 +3852,84 @@ private:
   }
 #endif // ENABLE_SPIRV_CODEGEN
 
+  // Creates the attribute that marks records of the given kind as a stream,
+  // a tessellation patch or a resource, or returns null.
+  InheritableAttr *CreateObjectTypeAttr(ArBasicKind kind) {
+    if (IS_BASIC_STREAM(kind))
+      return HLSLStreamOutputAttr::CreateImplicit(
+          *m_context, kind - AR_OBJECT_POINTSTREAM + 1);
+    if (IS_BASIC_PATCH(kind))
+      return HLSLTessPatchAttr::CreateImplicit(*m_context,
+                                               kind == AR_OBJECT_INPUTPATCH);
+    DXIL::ResourceKind ResKind = DXIL::ResourceKind::NumEntries;
+    DXIL::ResourceClass ResClass = DXIL::ResourceClass::Invalid;
+    if (GetBasicKindResourceKindAndClass(kind, ResKind, ResClass))
+      return HLSLResourceAttr::CreateImplicit(*m_context, (unsigned)ResKind,
+                                              (unsigned)ResClass);
+    return nullptr;
+  }
+
+  // Declares the lazy object type at index i of g_ArBasicKindsAsTypes, if it
+  // has not been declared yet.
+  void DeclareLazyObjectType(unsigned i) {
+    ArBasicKind kind = g_ArBasicKindsAsTypes[i];
+    const char *typeName = g_ArBasicTypeNames[kind];
+    auto it = m_lazyObjectTypes.find(&m_context->Idents.get(
+        StringRef(typeName), tok::TokenKind::identifier));
+    if (it == m_lazyObjectTypes.end())
+      return;
+    DXASSERT(it->second == i, "otherwise two object types share a name");
+    // Adding the declaration looks the name up again.
+    m_lazyObjectTypes.erase(it);
+
+    InheritableAttr *Attr = CreateObjectTypeAttr(kind);
+    uint8_t templateArgCount = g_ArBasicKindsTemplateCount[i];
+    CXXRecordDecl *recordDecl = nullptr;
+    if (templateArgCount == 0) {
+      recordDecl = DeclareRecordTypeWithHandle(*m_context, typeName,
+                                               /*isCompleteType*/ false, Attr);
+    } else {
+      DXASSERT(templateArgCount == 1 || templateArgCount == 2,
+               "otherwise a new case has been added");
+      TypeSourceInfo *typeDefault = nullptr;
+      if (TemplateHasDefaultType(kind))
+        typeDefault = m_context->getTrivialTypeSourceInfo(
+            LookupVectorType(HLSLScalarType_float, 4), NoLoc);
+      recordDecl = DeclareTemplateTypeWithHandle(
+          *m_context, typeName, templateArgCount, typeDefault, Attr);
+    }
+    m_objectTypeDecls[i] = recordDecl;
+
+    auto entry = std::find(m_objectTypeDeclsMap.begin(),
+                           m_objectTypeDeclsMap.end(),
+                           std::make_pair((CXXRecordDecl *)nullptr, i));
+    DXASSERT(entry != m_objectTypeDeclsMap.end(),
+             "otherwise AddObjectTypes did not reserve an entry");
+    entry->first = recordDecl;
+    std::sort(m_objectTypeDeclsMap.begin(), m_objectTypeDeclsMap.end(),
+              ObjectTypeDeclMapTypeCmp);
+  }
+
+  // Returns the declaration of the object type at index i of
+  // g_ArBasicKindsAsTypes, declaring it first if needed.
+  CXXRecordDecl *GetObjectTypeDecl(unsigned i) {
+    if (m_objectTypeDecls[i] == nullptr)
+      DeclareLazyObjectType(i);
+    return m_objectTypeDecls[i];
+  }
+
   // Adds all built-in HLSL object types.
+  // Types that are just a record or template with a handle field are only
+  // declared when their name is first looked up in the translation unit,
+  // through FindExternalVisibleDeclsByName, or first used by index through
+  // GetObjectTypeDecl. The other types are declared here. Either way the
+  // records start out incomplete: their subscripts and methods are only
+  // added by CompleteType on first use.
   void AddObjectTypes() {
     DXASSERT(m_context != nullptr,
              "otherwise caller hasn't initialized context yet");
 
-    QualType float4Type = LookupVectorType(HLSLScalarType_float, 4);
-    TypeSourceInfo *float4TypeSourceInfo =
-        m_context->getTrivialTypeSourceInfo(float4Type, NoLoc);
+    m_context->getTranslationUnitDecl()->setHasExternalVisibleStorage(true);
     unsigned effectKindIndex = 0;
     const auto *SM =
         hlsl::ShaderModel::GetByName(m_sema->getLangOpts().HLSLProfile.c_str());
@@ -3837,25 +3943,10 @@ private:
       if (kind == AR_OBJECT_LEGACY_EFFECT)
         effectKindIndex = i;
 
-      InheritableAttr *Attr = nullptr;
-      if (IS_BASIC_STREAM(kind))
-        Attr = HLSLStreamOutputAttr::CreateImplicit(
-            *m_context, kind - AR_OBJECT_POINTSTREAM + 1);
-      else if (IS_BASIC_PATCH(kind))
-        Attr = HLSLTessPatchAttr::CreateImplicit(*m_context,
-                                                 kind == AR_OBJECT_INPUTPATCH);
-      else {
-        DXIL::ResourceKind ResKind = DXIL::ResourceKind::NumEntries;
-        DXIL::ResourceClass ResClass = DXIL::ResourceClass::Invalid;
-        if (GetBasicKindResourceKindAndClass(kind, ResKind, ResClass))
-          Attr = HLSLResourceAttr::CreateImplicit(*m_context, (unsigned)ResKind,
-                                                  (unsigned)ResClass);
-      }
       DXASSERT(kind < _countof(g_ArBasicTypeNames),
                "g_ArBasicTypeNames has the wrong number of entries");
       assert(kind < _countof(g_ArBasicTypeNames));
       const char *typeName = g_ArBasicTypeNames[kind];
-      uint8_t templateArgCount = g_ArBasicKindsTemplateCount[i];
       CXXRecordDecl *recordDecl = nullptr;
       if (kind == AR_OBJECT_RAY_DESC) {
         QualType float3Ty =
@@ -3901,9 +3992,11 @@ private:
           break;
         }
       } else if (kind == AR_OBJECT_CONSTANT_BUFFER) {
-        recordDecl = DeclareConstantBufferViewType(*m_context, Attr);
+        recordDecl = DeclareConstantBufferViewType(*m_context,
+                                                   CreateObjectTypeAttr(kind));
       } else if (kind == AR_OBJECT_TEXTURE_BUFFER) {
-        recordDecl = DeclareConstantBufferViewType(*m_context, Attr);
+        recordDecl = DeclareConstantBufferViewType(*m_context,
+                                                   CreateObjectTypeAttr(kind));
       } else if (kind == AR_OBJECT_RAY_QUERY) {
         recordDecl = DeclareRayQueryType(*m_context);
       } else if (kind == AR_OBJECT_HIT_OBJECT) {
@@ -3928,10 +4021,12 @@ private:
         }
       } else if (kind == AR_OBJECT_FEEDBACKTEXTURE2D) {
         recordDecl = DeclareUIntTemplatedTypeWithHandle(
-            *m_context, "FeedbackTexture2D", "kind", Attr);
+            *m_context, "FeedbackTexture2D", "kind",
+            CreateObjectTypeAttr(kind));
       } else if (kind == AR_OBJECT_FEEDBACKTEXTURE2D_ARRAY) {
         recordDecl = DeclareUIntTemplatedTypeWithHandle(
-            *m_context, "FeedbackTexture2DArray", "kind", Attr);
+            *m_context, "FeedbackTexture2DArray", "kind",
+            CreateObjectTypeAttr(kind));
       } else if (kind == AR_OBJECT_EMPTY_NODE_INPUT) {
         recordDecl = DeclareNodeOrRecordType(
             *m_context, DXIL::NodeIOKind::EmptyInput,
@@ -4052,17 +4147,11 @@ private:
         m_vkBufferPointerTemplateDecl = recordDecl->getDescribedClassTemplate();
       }
 #endif
-      else if (templateArgCount == 0) {
-        recordDecl =
-            DeclareRecordTypeWithHandle(*m_context, typeName,
-                                        /*isCompleteType*/ false, Attr);
-      } else {
-        DXASSERT(templateArgCount == 1 || templateArgCount == 2,
-                 "otherwise a new case has been added");
-        TypeSourceInfo *typeDefault =
-            TemplateHasDefaultType(kind) ? float4TypeSourceInfo : nullptr;
-        recordDecl = DeclareTemplateTypeWithHandle(
-            *m_context, typeName, templateArgCount, typeDefault, Attr);
+      else {
+        m_lazyObjectTypes[&m_context->Idents.get(
+            StringRef(typeName), tok::TokenKind::identifier)] = i;
+        m_objectTypeDeclsMap[i] = std::make_pair(nullptr, i);
+        continue;
       }
       m_objectTypeDecls[i] = recordDecl;
       m_objectTypeDeclsMap[i] = std::make_pair(recordDecl, i);
@@ -4165,7 +4254,8 @@ public:
         m_vkLiteralTemplateDecl(nullptr),
         m_vkBufferPointerTemplateDecl(nullptr), m_hlslNSDecl(nullptr),
         m_vkNSDecl(nullptr), m_dxNSDecl(nullptr), m_context(nullptr),
-        m_sema(nullptr), m_hlslStringTypedef(nullptr) {
+        m_sema(nullptr), m_hlslStringTypedef(nullptr),
+        m_deferIntrinsicTableMethods(false) {
     memset(m_matrixTypes, 0, sizeof(m_matrixTypes));
     memset(m_matrixShorthandTypes, 0, sizeof(m_matrixShorthandTypes));
     memset(m_vectorTypes, 0, sizeof(m_vectorTypes));
@@ -4173,6 +4263,9 @@ public:
     memset(m_scalarTypes, 0, sizeof(m_scalarTypes));
     memset(m_scalarTypeDefs, 0, sizeof(m_scalarTypeDefs));
     memset(m_baseTypes, 0, sizeof(m_baseTypes));
+    memset(m_objectTypeDecls, 0, sizeof(m_objectTypeDecls));
+    memset(m_objectIntrinsicTableCount, 0,
+           sizeof(m_objectIntrinsicTableCount));
   }
 
   ~HLSLExternalSource() {}
@@ -4217,9 +4310,7 @@ public:
 
     AddObjectTypes();
     AddStdIsEqualImplementation(context, S);
-    for (auto &&intrinsic : m_intrinsicTables) {
-      AddIntrinsicTableMethods(intrinsic);
-    }
+    AddIntrinsicTableMethods();
 
     AddDxIntrinsicFunctions();
 
@@ -4365,6 +4456,37 @@ public:
     return true;
   }
 
+  // Declares a lazy object type the first time its name is looked up in the
+  // translation unit. Adding the declaration makes it visible in the lookup
+  // table that DeclContext::lookup reads back.
+  bool FindExternalVisibleDeclsByName(const DeclContext *DC,
+                                      DeclarationName Name) override {
+    if (!DC->isTranslationUnit())
+      return false;
+    IdentifierInfo *idInfo = Name.getAsIdentifierInfo();
+    if (idInfo == nullptr)
+      return false;
+    auto it = m_lazyObjectTypes.find(idInfo);
+    if (it == m_lazyObjectTypes.end())
+      return false;
+    DeclareLazyObjectType(it->second);
+    return true;
+  }
+
+  // Declares every remaining lazy object type, for callers that enumerate the
+  // names visible in the translation unit.
+  void completeVisibleDeclsMap(const DeclContext *DC) override {
+    if (!DC->isTranslationUnit())
+      return;
+    SmallVector<unsigned, 64> pending;
+    for (auto &entry : m_lazyObjectTypes)
+      pending.push_back(entry.second);
+    // Declare them in a stable order rather than in hash order.
+    std::sort(pending.begin(), pending.end());
+    for (unsigned i : pending)
+      DeclareLazyObjectType(i);
+  }
+
   bool LookupUnqualified(LookupResult &R, Scope *S) override {
     const DeclarationNameInfo declName = R.getLookupNameInfo();
     IdentifierInfo *idInfo = declName.getName().getAsIdentifierInfo();
@@ -4699,48 +4821,71 @@ public:
     return AR_BASIC_UNKNOWN;
   }
 
-  void AddIntrinsicTableMethods(IDxcIntrinsicTable *table) {
+  // Adds the template methods the table defines for the object type at index
+  // i of g_ArBasicKindsAsTypes.
+  void AddIntrinsicTableMethods(IDxcIntrinsicTable *table, unsigned i) {
     DXASSERT_NOMSG(table != nullptr);
 
-    // Function intrinsics are added on-demand, objects get template methods.
+    // Grab information already processed by AddObjectTypes.
+    ArBasicKind kind = g_ArBasicKindsAsTypes[i];
+    const char *typeName = g_ArBasicTypeNames[kind];
+    uint8_t templateArgCount = g_ArBasicKindsTemplateCount[i];
+    DXASSERT(templateArgCount <= 3, "otherwise a new case has been added");
+    int startDepth = (templateArgCount == 0) ? 0 : 1;
+    CXXRecordDecl *recordDecl = m_objectTypeDecls[i];
+    if (recordDecl == nullptr) {
+      return;
+    }
+
+    // This is a variation of AddObjectMethods using the new table.
+    const HLSL_INTRINSIC *pIntrinsic = nullptr;
+    const HLSL_INTRINSIC *pPrior = nullptr;
+    UINT64 lookupCookie = 0;
+    CA2W wideTypeName(typeName);
+    HRESULT found = table->LookupIntrinsic(wideTypeName, L"*", &pIntrinsic,
+                                           &lookupCookie);
+    while (pIntrinsic != nullptr && SUCCEEDED(found)) {
+      if (!AreIntrinsicTemplatesEquivalent(pIntrinsic, pPrior)) {
+        AddObjectIntrinsicTemplate(recordDecl, startDepth, pIntrinsic);
+        // NOTE: this only works with the current implementation because
+        // intrinsics are alive as long as the table is alive.
+        pPrior = pIntrinsic;
+      }
+      found = table->LookupIntrinsic(wideTypeName, L"*", &pIntrinsic,
+                                     &lookupCookie);
+    }
+  }
+
+  // Adds the methods of every table registered since the object type at index
+  // i was last brought up to date.
+  void AddPendingIntrinsicTableMethods(unsigned i) {
+    for (; m_objectIntrinsicTableCount[i] < m_intrinsicTables.size();
+         m_objectIntrinsicTableCount[i]++)
+      AddIntrinsicTableMethods(
+          m_intrinsicTables[m_objectIntrinsicTableCount[i]], i);
+  }
+
+  // Function intrinsics are added on-demand, objects get template methods.
+  // Object types are declared incomplete and only get their methods when
+  // CompleteType is first called for them, so only the ones that are already
+  // complete need the table's methods now.
+  void AddIntrinsicTableMethods() {
+    m_deferIntrinsicTableMethods = true;
     for (unsigned i = 0; i < _countof(g_ArBasicKindsAsTypes); i++) {
-      // Grab information already processed by AddObjectTypes.
-      ArBasicKind kind = g_ArBasicKindsAsTypes[i];
-      const char *typeName = g_ArBasicTypeNames[kind];
-      uint8_t templateArgCount = g_ArBasicKindsTemplateCount[i];
-      DXASSERT(templateArgCount <= 3, "otherwise a new case has been added");
-      int startDepth = (templateArgCount == 0) ? 0 : 1;
       CXXRecordDecl *recordDecl = m_objectTypeDecls[i];
-      if (recordDecl == nullptr) {
+      if (recordDecl == nullptr || !recordDecl->isCompleteDefinition())
         continue;
-      }
-
-      // This is a variation of AddObjectMethods using the new table.
-      const HLSL_INTRINSIC *pIntrinsic = nullptr;
-      const HLSL_INTRINSIC *pPrior = nullptr;
-      UINT64 lookupCookie = 0;
-      CA2W wideTypeName(typeName);
-      HRESULT found = table->LookupIntrinsic(wideTypeName, L"*", &pIntrinsic,
-                                             &lookupCookie);
-      while (pIntrinsic != nullptr && SUCCEEDED(found)) {
-        if (!AreIntrinsicTemplatesEquivalent(pIntrinsic, pPrior)) {
-          AddObjectIntrinsicTemplate(recordDecl, startDepth, pIntrinsic);
-          // NOTE: this only works with the current implementation because
-          // intrinsics are alive as long as the table is alive.
-          pPrior = pIntrinsic;
-        }
-        found = table->LookupIntrinsic(wideTypeName, L"*", &pIntrinsic,
-                                       &lookupCookie);
-      }
+      AddPendingIntrinsicTableMethods(i);
     }
   }
 
   void RegisterIntrinsicTable(IDxcIntrinsicTable *table) {
     DXASSERT_NOMSG(table != nullptr);
     m_intrinsicTables.push_back(table);
-    // If already initialized, add methods immediately.
+    m_extensionIntrinsics.clear();
+    // If already initialized, add methods to complete object types now.
     if (m_sema != nullptr) {
-      AddIntrinsicTableMethods(table);
+      AddIntrinsicTableMethods();
     }
   }
 
@@ -4934,7 +5079,7 @@ public:
       DXASSERT(match != &g_ArBasicKindsAsTypes[_countof(g_ArBasicKindsAsTypes)],
                "otherwise can't find constant in basic kinds");
       size_t index = match - g_ArBasicKindsAsTypes;
-      return m_context->getTagDeclType(this->m_objectTypeDecls[index]);
+      return m_context->getTagDeclType(GetObjectTypeDecl(index));
     }
 
     case AR_OBJECT_SAMPLER1D:
@@ -5178,20 +5323,69 @@ public:
   bool IsValidObjectElement(LPCSTR tableName, IntrinsicOp op,
                             QualType objectElement);
 
+  // Returns every intrinsic the external tables have for the given type and
+  // function name, in table order. The tables are only queried the first time
+  // a name is looked up.
+  llvm::ArrayRef<ExtensionIntrinsic>
+  LookupExtensionIntrinsics(StringRef typeName, StringRef functionName) {
+    if (m_intrinsicTables.empty())
+      return llvm::ArrayRef<ExtensionIntrinsic>();
+
+    std::string key = typeName.str();
+    key += '\0';
+    key += functionName;
+    auto insertResult = m_extensionIntrinsics.insert(
+        std::make_pair(StringRef(key), std::vector<ExtensionIntrinsic>()));
+    std::vector<ExtensionIntrinsic> &intrinsics =
+        insertResult.first->getValue();
+    if (!insertResult.second)
+      return intrinsics;
+
+    CA2WEX<> wideTypeName(typeName.str().c_str());
+    CA2WEX<> wideFunctionName(functionName.str().c_str());
+    for (unsigned i = 0; i < m_intrinsicTables.size(); ++i) {
+      const HLSL_INTRINSIC *pIntrinsic = nullptr;
+      UINT64 lookupCookie = 0;
+      while (SUCCEEDED(m_intrinsicTables[i]->LookupIntrinsic(
+                 wideTypeName, wideFunctionName, &pIntrinsic,
+                 &lookupCookie)) &&
+             pIntrinsic != nullptr) {
+        intrinsics.push_back(ExtensionIntrinsic{i, pIntrinsic});
+      }
+    }
+    return intrinsics;
+  }
+
   // Returns the iterator with the first entry that matches the requirement
   IntrinsicDefIter FindIntrinsicByNameAndArgCount(const HLSL_INTRINSIC *table,
                                                   size_t tableSize,
                                                   StringRef typeName,
                                                   StringRef nameIdentifier,
                                                   size_t argumentCount) {
-    // This is implemented by a linear scan for now.
-    // We tested binary search on tables, and there was no performance gain on
-    // samples probably for the following reasons.
-    // 1. The tables are not big enough to make noticable difference
-    // 2. The user of this function assumes that it returns the first entry in
-    // the table that matches name and argument count. So even in the binary
-    // search, we have to scan backwards until the entry does not match the name
-    // or arg count. For linear search this is not a problem
+    IntrinsicTableDefIter tableIter = IntrinsicTableDefIter::CreateStart(
+        m_intrinsicTables, LookupExtensionIntrinsics(typeName, nameIdentifier),
+        argumentCount);
+
+    // The generated tables keep the entries for a name together, and come
+    // with a perfect hash from the name to that range.
+    if (const HLSL_INTRINSIC_NAME_INDEX *index =
+            FindIntrinsicNameIndex(table)) {
+      DXASSERT_NOMSG(index->uTableCount == tableSize);
+      if (const HLSL_INTRINSIC_NAME_RANGE *range =
+              LookupIntrinsicNameRange(*index, nameIdentifier)) {
+        for (unsigned i = range->uFirst; i < range->uFirst + range->uCount;
+             i++) {
+          const HLSL_INTRINSIC *pIntrinsic = &table[i];
+          if (IsVariadicIntrinsicFunction(pIntrinsic) ||
+              pIntrinsic->uNumArgs == 1 + argumentCount)
+            return IntrinsicDefIter::CreateStart(table, tableSize, pIntrinsic,
+                                                 tableIter);
+        }
+      }
+      return IntrinsicDefIter::CreateStart(table, tableSize, table + tableSize,
+                                           tableIter);
+    }
+
     for (unsigned int i = 0; i < tableSize; i++) {
       const HLSL_INTRINSIC *pIntrinsic = &table[i];
 
@@ -5205,16 +5399,12 @@ public:
         continue;
       }
 
-      return IntrinsicDefIter::CreateStart(
-          table, tableSize, pIntrinsic,
-          IntrinsicTableDefIter::CreateStart(m_intrinsicTables, typeName,
-                                             nameIdentifier, argumentCount));
+      return IntrinsicDefIter::CreateStart(table, tableSize, pIntrinsic,
+                                           tableIter);
     }
 
-    return IntrinsicDefIter::CreateStart(
-        table, tableSize, table + tableSize,
-        IntrinsicTableDefIter::CreateStart(m_intrinsicTables, typeName,
-                                           nameIdentifier, argumentCount));
+    return IntrinsicDefIter::CreateStart(table, tableSize, table + tableSize,
+                                         tableIter);
   }
 
   bool AddOverloadedCallCandidates(UnresolvedLookupExpr *ULE,
@@ -6024,6 +6214,11 @@ public:
     ArBasicKind kind = g_ArBasicKindsAsTypes[idx];
     uint8_t templateArgCount = g_ArBasicKindsTemplateCount[idx];
 
+    // Extension table methods come first, as they did when they were added
+    // eagerly while initializing Sema.
+    if (m_deferIntrinsicTableMethods)
+      AddPendingIntrinsicTableMethods(idx);
+
     int startDepth = 0;
 
     if (templateArgCount > 0) {
@@ -13363,6 +13558,16 @@ hlsl::CaculateInitListArraySizeForHLSL(clang::Sema *sema,
   }
 }
 
+bool hlsl::HasBodyOrSkippedBody(const clang::FunctionDecl *FD) {
+  if (FD->hasBody())
+    return true;
+  for (const clang::FunctionDecl *Redecl : FD->redecls()) {
+    if (Redecl->hasSkippedBody())
+      return true;
+  }
+  return false;
+}
+
 // NRVO unsafe for a variety of cases in HLSL
 // - vectors/matrix with bool component types
 // - attributes not captured to QualType, such as precise and globallycoherent
@@ -607,7 +607,7 @@ void hlsl::DiagnoseTranslationUnit(clang::Sema *self) {
         return;
       }
       pEntryPointDecl = NL.Found;
-      if (!pEntryPointDecl || !pEntryPointDecl->hasBody()) {
+      if (!pEntryPointDecl || !hlsl::HasBodyOrSkippedBody(pEntryPointDecl)) {
         unsigned id =
             Diags.getCustomDiagID(clang::DiagnosticsEngine::Level::Error,
                                   "missing entry point definition");
@@ -667,7 +667,7 @@ void hlsl::DiagnoseTranslationUnit(clang::Sema *self) {
             FDecl->getAttr<HLSLPatchConstantFuncAttr>()) {
       NameLookup NL = GetSingleFunctionDeclByName(self, attr->getFunctionName(),
                                                   /*checkPatch*/ true);
-      if (!NL.Found || !NL.Found->hasBody()) {
+      if (!NL.Found || !hlsl::HasBodyOrSkippedBody(NL.Found)) {
         self->Diag(attr->getLocation(),
                    diag::err_hlsl_missing_patch_constant_function)
             << attr->getFunctionName();
@@ -0,0 +1,28 @@
+// RUN: %dxc -T lib_6_3 %s -Fc %t.ll
+// RUN: FileCheck --input-file=%t.ll %s
+// RUN: %dxc -T lib_6_3 %s -Fo %t.dxil
+// RUN: %dxc -dumpbin %t.dxil -function PSMain -Fc %t.PSMain.ll
+// RUN: FileCheck --input-file=%t.PSMain.ll %s -check-prefix=FUNC
+
+// -Fc writes the disassembly into the file while it is printed, for whole
+// programs and for a single function.
+// CHECK: ; Resource Bindings:
+// CHECK: Buf
+// CHECK: define void @CSMain()
+// CHECK: define void @PSMain()
+// CHECK: !dx.entryPoints =
+
+// FUNC: ; Resource Bindings:
+// FUNC-NOT: define
+// FUNC: define void @PSMain()
+// FUNC-NOT: define
+// FUNC: !dx.entryPoints =
+
+RWByteAddressBuffer Buf : register(u0);
+
+[shader("compute")]
+[numthreads(8, 1, 1)]
+void CSMain(uint id : SV_DispatchThreadID) { Buf.Store(id * 4, id); }
+
+[shader("pixel")]
+float4 PSMain(uint id : ID) : SV_Target { return Buf.Load(id * 4); }
@@ -0,0 +1,23 @@
+// RUN: %dxc -T lib_6_3 %s -Fo %t.dxil
+// RUN: %dxc -dumpbin %t.dxil -function PSMain | FileCheck %s
+// RUN: not %dxc -dumpbin %t.dxil -function Missing 2>&1 | FileCheck %s -check-prefix=MISSING
+
+// Module-level comments are still printed, but only the requested function
+// body is disassembled.
+// CHECK: ; Resource Bindings:
+// CHECK: Buf
+// CHECK-NOT: define
+// CHECK: define void @PSMain()
+// CHECK: ret void
+// CHECK-NOT: define
+
+// MISSING: function 'Missing' not found in module
+
+RWByteAddressBuffer Buf : register(u0);
+
+[shader("compute")]
+[numthreads(8, 1, 1)]
+void CSMain(uint id : SV_DispatchThreadID) { Buf.Store(id * 4, id); }
+
+[shader("pixel")]
+float4 PSMain(uint id : ID) : SV_Target { return Buf.Load(id * 4); }
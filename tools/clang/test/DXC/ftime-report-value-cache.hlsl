@@ -0,0 +1,14 @@
+// RUN: %dxc -E main -T ps_6_0 %s -ftime-report | FileCheck %s
+
+// Lookups in the DXIL value cache are reported with the pass timings.
+
+// CHECK: DXIL Value Cache
+// CHECK: Value lookups: {{[0-9]+}} hits, {{[0-9]+}} misses
+
+float4 main(float4 a : A) : SV_Target {
+  float4 result = 0;
+  [unroll]
+  for (int i = 0; i < 4; i++)
+    result += a * i;
+  return result;
+}
@@ -0,0 +1,22 @@
+// RUN: %dxc -E main -T ps_6_0 %s -ftime-trace -ftime-trace-pass-costs -ftime-trace-granularity=2147483647 | FileCheck %s
+// RUN: %dxc -E main -T ps_6_0 %s -ftime-trace | FileCheck %s -check-prefix=NOCOST
+
+// Pass sections carry instruction counts, and are kept even when they are
+// shorter than the time trace granularity. So are the sections they are
+// nested in.
+// CHECK: { "traceEvents": [
+// CHECK-DAG: "name":"RunFunctionPass", "args":{ "detail":"{{[^"]+}}", "function":"main", "instsBefore":{{[0-9]+}}, "instsAfter":{{[0-9]+}}} }
+// CHECK-DAG: "name":"OptFunction", "args":{ "detail":"main"} }
+// Module passes list the functions whose size they changed.
+// CHECK-DAG: "name":"RunModulePass", "args":{ "detail":"{{[^"]+}}", "instsBefore":{{[0-9]+}}, "instsAfter":{{[0-9]+}}, "functions":[]} }
+// CHECK-DAG: "name":"RunModulePass", "args":{ "detail":"{{[^"]+}}", "instsBefore":{{[0-9]+}}, "instsAfter":{{[0-9]+}}, "functions":[{ "function":"main", "instsBefore":{{[0-9]+}}, "instsAfter":{{[0-9]+}}}{{.*}}]} }
+
+// NOCOST: { "traceEvents": [
+// NOCOST-NOT: "instsBefore"
+
+float4 main(float4 a : A, float4 b : B) : SV_Target {
+  float4 r = a;
+  for (int i = 0; i < 4; ++i)
+    r = r * b + a;
+  return r;
+}
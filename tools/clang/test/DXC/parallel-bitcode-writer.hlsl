@@ -0,0 +1,34 @@
+// RUN: %dxc -T lib_6_3 %s -Fo %t.serial.dxil
+// RUN: %dxc -T lib_6_3 %s -opt-enable parallel-bitcode-writer -Fo %t.parallel.dxil
+// RUN: cmp %t.serial.dxil %t.parallel.dxil
+
+// Force several workers so the splicing runs even on a single core machine,
+// and cover the debug module written for the PDB.
+// RUN: %dxc -T lib_6_3 %s -Zi -Qembed_debug -Fo %t.serial.zi.dxil
+// RUN: %dxc -T lib_6_3 %s -Zi -Qembed_debug -opt-enable parallel-bitcode-writer -opt-select parallel-bitcode-writer-threads 3 -Fo %t.parallel.zi.dxil
+// RUN: cmp %t.serial.zi.dxil %t.parallel.zi.dxil
+// RUN: %dxc -T lib_6_3 %s -Zi -Fd %t.serial.pdb -Fo %t.serial.fd.dxil
+// RUN: %dxc -T lib_6_3 %s -Zi -opt-enable parallel-bitcode-writer -opt-select parallel-bitcode-writer-threads 8 -Fd %t.parallel.pdb -Fo %t.parallel.fd.dxil
+// RUN: cmp %t.serial.fd.dxil %t.parallel.fd.dxil
+
+// Encoding function blocks on worker threads must not change the container.
+
+RWByteAddressBuffer Buf : register(u0);
+
+[noinline] float Scale(float x, uint i) { return x * Buf.Load(i * 4); }
+
+export float Sum(uint n) {
+  float s = 0;
+  for (uint i = 0; i < n; i++)
+    s += Scale(i, i);
+  return s;
+}
+
+export void Store(uint i, float v) { Buf.Store(i * 4, asuint(Scale(v, i))); }
+
+[shader("compute")]
+[numthreads(8, 1, 1)]
+void CSMain(uint id : SV_DispatchThreadID) { Store(id, Sum(id)); }
+
+[shader("pixel")]
+float4 PSMain(uint id : ID) : SV_Target { return Sum(id).xxxx; }
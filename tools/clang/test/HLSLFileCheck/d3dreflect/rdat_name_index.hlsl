@@ -0,0 +1,22 @@
+// RUN: %dxilver 1.9 | %dxc -T lib_6_9 %s | %D3DReflect %s | FileCheck %s
+// RUN: %dxilver 1.8 | %dxc -T lib_6_8 -validator-version 1.8 %s | %D3DReflect %s | FileCheck %s -check-prefix=NOINDEX
+
+// Functions and subobjects are indexed by name once experimental RDAT parts
+// are allowed. Older validators get the same RDAT without the index.
+
+// CHECK: DxilRuntimeData (size = {{[0-9]+}} bytes):
+// CHECK: RecordTable (stride = {{[0-9]+}} bytes) FunctionTable[2] = {
+// CHECK: RecordTable (stride = {{[0-9]+}} bytes) SubobjectTable[1] = {
+// CHECK: NameIndex (entries = {{[0-9]+}}, buckets = {{[0-9]+}})
+
+// NOINDEX: DxilRuntimeData (size = {{[0-9]+}} bytes):
+// NOINDEX-NOT: NameIndex
+
+GlobalRootSignature grs = {"CBV(b0)"};
+
+RWByteAddressBuffer Buf : register(u0);
+
+export float Scale(float x) { return x * 2; }
+
+[shader("raygeneration")]
+void RayGen() { Buf.Store(0, asuint(Scale(1))); }
@@ -0,0 +1,22 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// Confirm that a loop with a trip count known up front and an early exit is
+// fully unrolled, with the exit reached from every iteration.
+
+// CHECK: @main
+// CHECK: call %dx.types.ResRet.i32 @dx.op.bufferLoad.i32(i32 68, %dx.types.Handle %{{.*}}, i32 0,
+// CHECK: call %dx.types.ResRet.i32 @dx.op.bufferLoad.i32(i32 68, %dx.types.Handle %{{.*}}, i32 1,
+// CHECK: call %dx.types.ResRet.i32 @dx.op.bufferLoad.i32(i32 68, %dx.types.Handle %{{.*}}, i32 255,
+// CHECK-NOT: @dx.op.bufferLoad.i32(i32 68, %dx.types.Handle %{{.*}}, i32 256,
+
+Buffer<uint> buf;
+uint g_key;
+
+uint main() : SV_Target {
+  [unroll]
+  for (uint i = 0; i < 256; i++) {
+    if (buf[i] == g_key)
+      return i;
+  }
+  return 1000;
+}
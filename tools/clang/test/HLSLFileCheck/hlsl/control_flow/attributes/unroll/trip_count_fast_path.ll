@@ -0,0 +1,41 @@
+; RUN: %opt %s -dxil-loop-unroll -S | FileCheck %s
+
+; The trip count of the latch is known, so the body is cloned four times and
+; the unrolled iterations are folded by the unroller itself: the induction
+; variable becomes a constant in each of them and no latch compare is left.
+
+; CHECK: @main
+; CHECK: call void @use(float 0.000000e+00)
+; CHECK: call void @use(float 1.000000e+00)
+; CHECK: call void @use(float 2.000000e+00)
+; CHECK: call void @use(float 3.000000e+00)
+; CHECK-NOT: call void @use(
+; CHECK-NOT: icmp
+; CHECK: ret void
+
+target datalayout = "e-m:e-p:32:32-i1:32-i8:32-i16:32-i32:32-i64:64-f16:32-f32:32-f64:64-n8:16:32:64"
+target triple = "dxil-ms-dx"
+
+declare void @use(float) #0
+
+; Function Attrs: nounwind
+define void @main() #0 {
+entry:
+  br label %for.body
+
+for.body:
+  %i.0 = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %conv = uitofp i32 %i.0 to float
+  call void @use(float %conv)
+  %inc = add nuw nsw i32 %i.0, 1
+  %cmp = icmp ult i32 %inc, 4
+  br i1 %cmp, label %for.body, label %for.end, !llvm.loop !0
+
+for.end:
+  ret void
+}
+
+attributes #0 = { nounwind }
+
+!0 = distinct !{!0, !1}
+!1 = !{!"llvm.loop.unroll.full"}
@@ -0,0 +1,19 @@
+// RUN: %dxilver 1.6 | %dxc -T lib_6_3 -Fo %t.lib_6_3 %s
+// RUN: %dxilver 1.6 | %dxl -E ps_main -T ps_6_6 %t.lib_6_3 %s | FileCheck %s
+// RUN: %dxilver 1.6 | %dxl -T lib_6_6 %t.lib_6_3 %s | FileCheck %s
+
+// The dxil operation declarations copied into the linked module must be found
+// by lookups after linking. Linking lib_6_3 to 6.6 only annotates the handles
+// if the createHandleForLib declaration is in the op cache.
+
+// CHECK: call %dx.types.Handle @dx.op.annotateHandle(i32 216, %dx.types.Handle %{{.+}}, %dx.types.ResourceProperties { i32 13, i32 4 })
+// CHECK: declare %dx.types.Handle @dx.op.annotateHandle(
+// CHECK-NOT: declare %dx.types.Handle @dx.op.annotateHandle(
+
+float a;
+
+[shader("pixel")]
+float ps_main() : SV_TARGET
+{
+  return a;
+}
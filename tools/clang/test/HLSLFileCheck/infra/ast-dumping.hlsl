@@ -18,20 +18,11 @@ void main() {
 // IMPLICIT: CXXRecordDecl {{0x[0-9a-fA-F]+}} <<invalid sloc>> <invalid sloc> implicit class vector definition
 // IMPLICIT: CXXRecordDecl {{0x[0-9a-fA-F]+}} <<invalid sloc>> <invalid sloc> implicit class matrix definition
 
-// This set of checks verifies that the implicit decls for buffers are
-// incomplete by looking at the `Buffer` type which is unused in this code and
-// verifying it doesn't have any methods.
+// Object types that are just a record or template with a handle field are
+// only declared when their name is first looked up. The `Buffer` type is
+// unused in this code, so it is not declared at all.
 
-// IMPLICIT-NOT: CXXRecordDecl {{0x[0-9a-fA-F]+}} <<invalid sloc>> <invalid sloc> implicit class Buffer
-// IMPLICIT: ClassTemplateDecl {{0x[0-9a-fA-F]+}} <<invalid sloc>> <invalid sloc> implicit Buffer
-// IMPLICIT-NEXT: TemplateTypeParmDecl {{0x[0-9a-fA-F]+}} <<invalid sloc>> <invalid sloc> class element
-// IMPLICIT-NEXT: TemplateArgument type 'vector<float, 4>':'vector<float, 4>'
-// IMPLICIT-NEXT: CXXRecordDecl {{0x[0-9a-fA-F]+}} <<invalid sloc>> <invalid sloc> implicit class Buffer
-// IMPLICIT-NEXT: FinalAttr {{0x[0-9a-fA-F]+}} <<invalid sloc>> Implicit final
-// IMPLICIT-NEXT: HLSLResourceAttr {{0x[0-9a-fA-F]+}} <<invalid sloc>> Implicit 10 0
-// IMPLICIT-NEXT: FieldDecl {{0x[0-9a-fA-F]+}} <<invalid sloc>> <invalid sloc> implicit h 'element'
-// IMPLICIT-NOT: CXXMethodDecl
-// IMPLICIT: CXXRecordDecl
+// IMPLICIT-NOT: ClassTemplateDecl {{0x[0-9a-fA-F]+}} <<invalid sloc>> <invalid sloc> implicit Buffer
 
 
 // This tests to verfy that the RWBuffer _is_ completed with method definitions.
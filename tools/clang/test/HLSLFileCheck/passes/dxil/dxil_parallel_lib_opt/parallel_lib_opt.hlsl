@@ -0,0 +1,37 @@
+// RUN: %dxc -T lib_6_3 /opt-enable parallel-lib-opt %s | FileCheck %s
+
+// Each export is optimized in its own partition and merged back. The two
+// exports give two partitions whatever the number of cores. Struct types
+// must map back to the module's own types, and both bodies must come back
+// optimized: the loops unrolled and the arithmetic folded.
+
+// CHECK-NOT: %struct.Data.{{[0-9]+}} =
+// CHECK: define void @"\01?first@@YAXXZ"()
+// CHECK: call void @dx.op.rawBufferStore.i32(i32 140, %dx.types.Handle %{{.*}}, i32 0, i32 0, i32 12
+// CHECK-NOT: br
+// CHECK: ret void
+// CHECK: define void @"\01?second@@YAXXZ"()
+// CHECK: call void @dx.op.rawBufferStore.f32(i32 140, %dx.types.Handle %{{.*}}, i32 1, i32 4, float 6.000000e+00
+// CHECK-NOT: br
+// CHECK: ret void
+
+struct Data {
+  int i;
+  float f;
+};
+
+RWStructuredBuffer<Data> Buf;
+
+export void first() {
+  int sum = 0;
+  for (int i = 0; i < 4; ++i)
+    sum += 3;
+  Buf[0].i = sum;
+}
+
+export void second() {
+  float v = 1.0;
+  for (int i = 0; i < 3; ++i)
+    v += 1.0;
+  Buf[1].f = v * 1.5;
+}
@@ -0,0 +1,37 @@
+// RUN: %dxc -T lib_6_3 /opt-enable parallel-lib-opt -ftime-trace -ftime-trace-granularity=0 %s | FileCheck %s
+
+// The time trace profiler is not thread-safe, so with -ftime-trace the
+// library is optimized on the calling thread. The pass shows up in the
+// trace, and both exports still come back optimized.
+
+// CHECK: define void @"\01?first@@YAXXZ"()
+// CHECK: call void @dx.op.rawBufferStore.i32(i32 140, %dx.types.Handle %{{.*}}, i32 0, i32 0, i32 12
+// CHECK-NOT: br
+// CHECK: ret void
+// CHECK: define void @"\01?second@@YAXXZ"()
+// CHECK: call void @dx.op.rawBufferStore.f32(i32 140, %dx.types.Handle %{{.*}}, i32 1, i32 4, float 6.000000e+00
+// CHECK-NOT: br
+// CHECK: ret void
+// CHECK: { "traceEvents": [
+// CHECK: "name":"RunModulePass", "args":{ "detail":"DXIL parallel library optimization"} }
+
+struct Data {
+  int i;
+  float f;
+};
+
+RWStructuredBuffer<Data> Buf;
+
+export void first() {
+  int sum = 0;
+  for (int i = 0; i < 4; ++i)
+    sum += 3;
+  Buf[0].i = sum;
+}
+
+export void second() {
+  float v = 1.0;
+  for (int i = 0; i < 3; ++i)
+    v += 1.0;
+  Buf[1].f = v * 1.5;
+}
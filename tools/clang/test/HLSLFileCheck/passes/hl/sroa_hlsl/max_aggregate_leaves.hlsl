@@ -0,0 +1,19 @@
+// RUN: %dxc -T ps_6_0 -E main %s | FileCheck %s -check-prefix=SPLIT
+// RUN: %dxc -T ps_6_0 -E main %s -opt-select sroa-max-aggregate-leaves 64 | FileCheck %s -check-prefix=KEEP
+
+// By default the array of vectors is split into one array per component.
+// SPLIT: alloca [32 x float]
+
+// With a leaf limit below 128, the element-accessed array is kept whole and
+// flattened into a single dynamically indexed array instead.
+// KEEP-NOT: alloca [32 x float]
+// KEEP: alloca [128 x float]
+// KEEP-NOT: alloca [32 x float]
+
+float4 main(uint i : I, uint j : J, float4 v : V) : SV_Target {
+  float4 arr[32];
+  for (uint k = 0; k < 32; k++)
+    arr[k] = v * k;
+  arr[i] = v;
+  return arr[j];
+}
@@ -0,0 +1,98 @@
+; RUN: %dxopt %s -hlsl-passes-resume -scalarrepl-param-hlsl -S | FileCheck %s -check-prefix=SPLIT
+; RUN: %dxopt %s -hlsl-passes-resume -scalarrepl-param-hlsl,MaxAggregateLeaves=16 -S | FileCheck %s -check-prefix=LOOP
+; RUN: %dxopt %s -hlsl-passes-resume -scalarrepl-param-hlsl,MemoryBudgetKB=1 -S | FileCheck %s -check-prefix=LOOP
+
+; Produced from the following HLSL:
+;   struct S { float4 f; float4 g; };
+;   static uint idx;
+;   static float4 result;
+;
+;   [numthreads(1, 1, 1)]
+;   void main() {
+;     S a[64];
+;     a[idx].f = 1;
+;     S b[64] = a;
+;     a[idx].g = 2;
+;     b[idx].g = 3;
+;     result = b[idx].f;
+;   }
+
+; By default the copy of the array of structs is unrolled into one copy per
+; element.
+; SPLIT: getelementptr inbounds {{.*}}, i32 0, i32 63
+
+; Over the leaf limit or the memory budget, the copy is done in a loop and the
+; per-field arrays of vectors are kept whole.
+; LOOP: alloca [64 x <4 x float>]
+; LOOP-NOT: i32 63
+; LOOP: array.cpy:
+; LOOP-NEXT: %array.cpy.idx = phi i32 [ 0, %entry ], [ %{{.*}}, %array.cpy ]
+; LOOP-NOT: i32 63
+; LOOP: br i1 %{{.*}}, label %array.cpy.end, label %array.cpy
+; LOOP-NOT: i32 63
+; LOOP: ret void
+
+target datalayout = "e-m:e-p:32:32-i1:32-i8:32-i16:32-i32:32-i64:64-f16:32-f32:32-f64:64-n8:16:32:64"
+target triple = "dxil-ms-dx"
+
+%ConstantBuffer = type opaque
+%struct.S = type { <4 x float>, <4 x float> }
+
+@idx = internal global i32 0, align 4
+@result = internal global <4 x float> zeroinitializer, align 4
+@"$Globals" = external constant %ConstantBuffer
+
+; Function Attrs: nounwind
+define void @main() #0 {
+entry:
+  %a = alloca [64 x %struct.S], align 4
+  %b = alloca [64 x %struct.S], align 4
+  %0 = load i32, i32* @idx, align 4
+  %a.f = getelementptr inbounds [64 x %struct.S], [64 x %struct.S]* %a, i32 0, i32 %0, i32 0
+  store <4 x float> <float 1.000000e+00, float 1.000000e+00, float 1.000000e+00, float 1.000000e+00>, <4 x float>* %a.f, align 4
+  %1 = bitcast [64 x %struct.S]* %b to i8*
+  %2 = bitcast [64 x %struct.S]* %a to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %1, i8* %2, i64 2048, i32 1, i1 false)
+  %a.g = getelementptr inbounds [64 x %struct.S], [64 x %struct.S]* %a, i32 0, i32 %0, i32 1
+  store <4 x float> <float 2.000000e+00, float 2.000000e+00, float 2.000000e+00, float 2.000000e+00>, <4 x float>* %a.g, align 4
+  %b.g = getelementptr inbounds [64 x %struct.S], [64 x %struct.S]* %b, i32 0, i32 %0, i32 1
+  store <4 x float> <float 3.000000e+00, float 3.000000e+00, float 3.000000e+00, float 3.000000e+00>, <4 x float>* %b.g, align 4
+  %b.f = getelementptr inbounds [64 x %struct.S], [64 x %struct.S]* %b, i32 0, i32 %0, i32 0
+  %3 = load <4 x float>, <4 x float>* %b.f, align 4
+  store <4 x float> %3, <4 x float>* @result, align 4
+  ret void
+}
+
+; Function Attrs: nounwind
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8* nocapture, i8* nocapture readonly, i64, i32, i1) #0
+
+attributes #0 = { nounwind }
+
+!pauseresume = !{!0}
+!dx.version = !{!1}
+!dx.valver = !{!2}
+!dx.shaderModel = !{!3}
+!dx.typeAnnotations = !{!4, !8}
+!dx.entryPoints = !{!12}
+!dx.fnprops = !{!16}
+!dx.options = !{!17, !18}
+
+!0 = !{!"hlsl-hlemit", !"hlsl-hlensure"}
+!1 = !{i32 1, i32 0}
+!2 = !{i32 1, i32 8}
+!3 = !{!"cs", i32 6, i32 0}
+!4 = !{i32 0, %struct.S undef, !5}
+!5 = !{i32 32, !6, !7}
+!6 = !{i32 6, !"f", i32 3, i32 0, i32 7, i32 9}
+!7 = !{i32 6, !"g", i32 3, i32 16, i32 7, i32 9}
+!8 = !{i32 1, void ()* @main, !9}
+!9 = !{!10}
+!10 = !{i32 1, !11, !11}
+!11 = !{}
+!12 = !{void ()* @main, !"main", null, !13, null}
+!13 = !{null, null, !14, null}
+!14 = !{!15}
+!15 = !{i32 0, %ConstantBuffer* @"$Globals", !"$Globals", i32 0, i32 -1, i32 1, i32 0, null}
+!16 = !{void ()* @main, i32 5, i32 1, i32 1, i32 1}
+!17 = !{i32 64}
+!18 = !{i32 -1}
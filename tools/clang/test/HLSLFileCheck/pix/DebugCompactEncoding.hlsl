@@ -0,0 +1,21 @@
+// RUN: %dxc -EMain -Tps_6_0 %s | %opt -S -dxil-annotate-with-virtual-regs -hlsl-dxil-debug-instrumentation,compact=1 | %FileCheck %s
+
+// Check that the compact encoding is announced, that bools are reported with
+// the packed type code and that they are bit-packed into a single DWORD:
+
+// CHECK: Encoding:Compact
+// CHECK: Block#0:
+// CHECK-SAME: ,1,{{[0-9]+}},a;
+
+// The compact block header: Flags=1, Type=249 (DXILStepBlock), BlockIndex=0
+// CHECK: call void @dx.op.rawBufferStore.i32(i32 140, %dx.types.Handle %PIX_DebugUAV_Handle, i32 %{{.*}}, i32 undef, i32 63760
+// CHECK: zext i1 %{{.*}} to i32
+// CHECK: shl i32 %{{.*}}, 1
+// CHECK: or i32
+
+[RootSignature("")]
+float4 Main(float4 pos : SV_Position) : SV_Target {
+  bool a = pos.x > 1;
+  bool b = pos.y > 2;
+  return (a && b) ? float4(1, 1, 1, 1) : float4(0, 0, 0, 0);
+}
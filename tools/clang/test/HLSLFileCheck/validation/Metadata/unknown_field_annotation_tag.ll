@@ -0,0 +1,40 @@
+; The metadata loader asserts on unknown tags in assert builds.
+; UNSUPPORTED: asserts
+; RUN: %dxv %s | FileCheck %s
+
+; Type annotations are only parsed on first access. Make sure an unknown tag
+; in a struct field annotation is still reported by the validator.
+
+; CHECK: error: Metadata error encountered in non-critical metadata (such as Type Annotations).
+
+target datalayout = "e-m:e-p:32:32-i1:32-i8:32-i16:32-i32:32-i64:64-f16:32-f32:32-f64:64-n8:16:32:64"
+target triple = "dxil-ms-dx"
+
+%struct.S = type { float }
+
+define void @main() {
+  ret void
+}
+
+!dx.version = !{!0}
+!dx.valver = !{!0}
+!dx.shaderModel = !{!1}
+!dx.typeAnnotations = !{!2, !5}
+!dx.entryPoints = !{!9}
+
+!0 = !{i32 1, i32 0}
+!1 = !{!"cs", i32 6, i32 0}
+!2 = !{i32 0, %struct.S undef, !3}
+!3 = !{i32 4, !4}
+; Arg #1: FieldName Tag (6)
+; Arg #2: field name
+; Arg #3: INVALID Tag (99)
+; Arg #4: value
+!4 = !{i32 6, !"f", i32 99, i32 1}
+!5 = !{i32 1, void ()* @main, !6}
+!6 = !{!7}
+!7 = !{i32 1, !8, !8}
+!8 = !{}
+!9 = !{void ()* @main, !"main", null, null, !10}
+!10 = !{i32 4, !11}
+!11 = !{i32 1, i32 1, i32 1}
@@ -0,0 +1,14 @@
+// RUN: %dxc -Tlib_6_3 -verify %s
+
+// Object types that are just a record or template with a handle field are
+// declared on first lookup of their name. Qualified lookup, lookup through a
+// typedef and typo correction find them as if they were declared up front.
+
+::RWBuffer<float> Out;
+typedef ::Texture2D<float4> Tex2D;
+Tex2D Tex;
+ByteAdressBuffer Raw; // expected-error {{unknown type name 'ByteAdressBuffer'; did you mean 'ByteAddressBuffer'?}}
+
+export void main(uint i) {
+  Out[i] = Tex.Load(int3(i, 0, 0)).x + Raw.Load(i);
+}
@@ -1255,6 +1255,10 @@ namespace DotNetDxc
 
         // Used to indicate that compilation should occur on the caller's thread.
         DxcTranslationUnitFlags_UseCallerThread = 0x800,
+
+        // Used to indicate that the bodies of non-template functions declared in
+        // files included from the main file's preamble should be skipped.
+        DxcTranslationUnitFlags_SkipPreambleFunctionBodies = 0x1000,
     };
 
     [ComImport]
@@ -134,6 +134,7 @@ private:
   bool UpdatePartRequired();
   void WriteHeader(IDxcBlobEncoding *pDisassembly, IDxcBlob *pCode,
                    llvm::Twine &pVariableName, LPCWSTR pPath);
+  bool DisassembleToFile(IDxcBlob *pBlob);
   HRESULT ReadFileIntoPartContent(hlsl::DxilFourCC fourCC, LPCWSTR fileName,
                                   IDxcBlob **ppResult);
 
@@ -413,6 +414,25 @@ int DxcContext::ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob,
       std::string Message = "Disassembly failed";
       IFT(pLibrary->CreateBlobWithEncodingOnHeapCopy(
           (LPBYTE)&Message[0], Message.size(), CP_ACP, &pDisassembleResult));
+    } else if (m_Opts.OutputHeader.empty() && !m_Opts.AssemblyCode.empty() &&
+               m_Opts.DefaultTextCodePage == DXC_CP_UTF8 &&
+               DisassembleToFile(pBlob)) {
+      return retVal;
+    } else if (!m_Opts.DisassembleFunction.empty()) {
+      CComPtr<IDxcFunctionDisassembler> pDisassembler;
+      CComPtr<IDxcResult> pResult;
+      IFT(CreateInstance(CLSID_DxcCompiler, &pDisassembler));
+      DxcBuffer buffer = {pBlob->GetBufferPointer(), pBlob->GetBufferSize(),
+                          0};
+      std::string functionName = m_Opts.DisassembleFunction.str();
+      IFT(pDisassembler->DisassembleFunction(&buffer, functionName.c_str(),
+                                             IID_PPV_ARGS(&pResult)));
+      WriteOperationErrorsToConsole(pResult, m_Opts.OutputWarnings);
+      HRESULT status;
+      IFT(pResult->GetStatus(&status));
+      IFT(status);
+      IFT(pResult->GetOutput(DXC_OUT_DISASSEMBLY,
+                             IID_PPV_ARGS(&pDisassembleResult), nullptr));
     } else {
       CComPtr<IDxcCompiler> pCompiler;
       IFT(CreateInstance(CLSID_DxcCompiler, &pCompiler));
@@ -447,6 +467,31 @@ int DxcContext::ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob,
   return retVal;
 }
 
+// Writes the disassembly straight into the -Fc file as it is printed, so the
+// listing is never held in memory as a whole. Returns false if the compiler
+// cannot disassemble into a stream.
+bool DxcContext::DisassembleToFile(IDxcBlob *pBlob) {
+  CComPtr<IDxcStreamDisassembler> pDisassembler;
+  if (FAILED(CreateInstance(CLSID_DxcCompiler, &pDisassembler)))
+    return false;
+
+  StringRefWide fileName(m_Opts.AssemblyCode);
+  CComPtr<IStream> pFile;
+  IFT_Data(hlsl::CreateFileWriteStream(fileName, &pFile), fileName);
+
+  DxcBuffer buffer = {pBlob->GetBufferPointer(), pBlob->GetBufferSize(), 0};
+  std::string functionName = m_Opts.DisassembleFunction.str();
+  CComPtr<IDxcResult> pResult;
+  IFT(pDisassembler->DisassembleToStream(
+      &buffer, functionName.empty() ? nullptr : functionName.c_str(), pFile,
+      IID_PPV_ARGS(&pResult)));
+  WriteOperationErrorsToConsole(pResult, m_Opts.OutputWarnings);
+  HRESULT status;
+  IFT(pResult->GetStatus(&status));
+  IFT(status);
+  return true;
+}
+
 // Given a dxil container, update the dxil container by processing container
 // specific options.
 void DxcContext::UpdatePart(IDxcBlob *pSource, IDxcBlob **ppResult) {
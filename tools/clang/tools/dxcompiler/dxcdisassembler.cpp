@@ -37,6 +37,7 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include <assert.h> // Needed for DxilPipelineStateValidation.h
 
 using namespace llvm;
@@ -54,7 +55,7 @@ bool SigElementHasStream(const DxilProgramSignatureElement &pSignature) {
 }
 
 void PrintSignature(LPCSTR pName, const DxilProgramSignature *pSignature,
-                    bool bIsInput, raw_string_ostream &OS, StringRef comment) {
+                    bool bIsInput, raw_ostream &OS, StringRef comment) {
   OS << comment << "\n"
      << comment << " " << pName << " signature:\n"
      << comment << "\n"
@@ -267,7 +268,7 @@ void PrintSignature(LPCSTR pName, const DxilProgramSignature *pSignature,
   OS << comment << "\n";
 }
 
-void PintCompMaskNameCompact(raw_string_ostream &OS, unsigned CompMask) {
+void PintCompMaskNameCompact(raw_ostream &OS, unsigned CompMask) {
   char Mask[5];
   memset(Mask, '\0', sizeof(Mask));
   unsigned idx = 0;
@@ -283,7 +284,7 @@ void PintCompMaskNameCompact(raw_string_ostream &OS, unsigned CompMask) {
 }
 
 void PrintDxilSignature(LPCSTR pName, const DxilSignature &Signature,
-                        raw_string_ostream &OS, StringRef comment) {
+                        raw_ostream &OS, StringRef comment) {
   const std::vector<std::unique_ptr<DxilSignatureElement>> &sigElts =
       Signature.GetElements();
   if (sigElts.size() == 0)
@@ -361,7 +362,7 @@ static_assert(_countof(g_pOptFeatureInfoNames) == OptFeatureInfoCount,
               "g_pOptFeatureInfoNames needs to be updated");
 
 void PrintFeatureInfo(const DxilShaderFeatureInfo *pFeatureInfo,
-                      raw_string_ostream &OS, StringRef comment) {
+                      raw_ostream &OS, StringRef comment) {
   uint64_t featureFlags = pFeatureInfo->FeatureFlags;
   if (!featureFlags)
     return;
@@ -385,7 +386,7 @@ void PrintFeatureInfo(const DxilShaderFeatureInfo *pFeatureInfo,
 }
 
 void PrintResourceFormat(DxilResourceBase &res, unsigned alignment,
-                         raw_string_ostream &OS) {
+                         raw_ostream &OS) {
   switch (res.GetClass()) {
   case DxilResourceBase::Class::CBuffer:
   case DxilResourceBase::Class::Sampler:
@@ -415,7 +416,7 @@ void PrintResourceFormat(DxilResourceBase &res, unsigned alignment,
 }
 
 void PrintResourceDim(DxilResourceBase &res, unsigned alignment,
-                      raw_string_ostream &OS) {
+                      raw_ostream &OS) {
   switch (res.GetClass()) {
   case DxilResourceBase::Class::CBuffer:
   case DxilResourceBase::Class::Sampler:
@@ -457,7 +458,7 @@ void PrintResourceDim(DxilResourceBase &res, unsigned alignment,
   }
 }
 
-void PrintResourceBinding(DxilResourceBase &res, raw_string_ostream &OS,
+void PrintResourceBinding(DxilResourceBase &res, raw_ostream &OS,
                           StringRef comment) {
   OS << comment << " " << left_justify(res.GetGlobalName(), 31);
 
@@ -483,7 +484,7 @@ void PrintResourceBinding(DxilResourceBase &res, raw_string_ostream &OS,
     OS << right_justify("unbounded", 6) << "\n";
 }
 
-void PrintResourceBindings(DxilModule &M, raw_string_ostream &OS,
+void PrintResourceBindings(DxilModule &M, raw_ostream &OS,
                            StringRef comment) {
   OS << comment << "\n"
      << comment << " Resource Bindings:\n"
@@ -550,7 +551,7 @@ void PrintInputsContributingToOutputs(
   }
 }
 
-void PrintViewIdState(DxilModule &M, raw_string_ostream &OS,
+void PrintViewIdState(DxilModule &M, raw_ostream &OS,
                       StringRef comment) {
   if (!M.GetModule()->getNamedMetadata("dx.viewIdState"))
     return;
@@ -687,7 +688,7 @@ static const char *HitGroupTypeToString(DXIL::HitGroupType type) {
   return "<invalid HitGroupType>";
 }
 
-template <typename _T> void PrintFlags(raw_string_ostream &OS, uint32_t Flags) {
+template <typename _T> void PrintFlags(raw_ostream &OS, uint32_t Flags) {
   if (!Flags) {
     OS << "0";
     return;
@@ -702,7 +703,7 @@ template <typename _T> void PrintFlags(raw_string_ostream &OS, uint32_t Flags) {
   }
 }
 
-void PrintSubobjects(const DxilSubobjects &subobjects, raw_string_ostream &OS,
+void PrintSubobjects(const DxilSubobjects &subobjects, raw_ostream &OS,
                      StringRef comment) {
   if (subobjects.GetSubobjects().empty())
     return;
@@ -822,7 +823,7 @@ void PrintSubobjects(const DxilSubobjects &subobjects, raw_string_ostream &OS,
 }
 
 void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
-                       const DataLayout *DL, raw_string_ostream &OS,
+                       const DataLayout *DL, raw_ostream &OS,
                        StringRef comment, StringRef varName, unsigned offset,
                        unsigned indent, unsigned arraySize,
                        unsigned sizeOfStruct = 0);
@@ -863,7 +864,7 @@ void PrintTypeAndName(llvm::Type *Ty, DxilFieldAnnotation &annotation,
 
 void PrintFieldLayout(llvm::Type *Ty, DxilFieldAnnotation &annotation,
                       DxilTypeSystem &typeSys, const DataLayout *DL,
-                      raw_string_ostream &OS, StringRef comment,
+                      raw_ostream &OS, StringRef comment,
                       unsigned offset, unsigned indent, unsigned offsetIndent,
                       unsigned sizeToPrint = 0) {
   if (Ty->isStructTy() && !annotation.HasMatrixAnnotation()) {
@@ -933,7 +934,7 @@ void PrintFieldLayout(llvm::Type *Ty, DxilFieldAnnotation &annotation,
 
 // null DataLayout => assume constant buffer layout
 void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
-                       const DataLayout *DL, raw_string_ostream &OS,
+                       const DataLayout *DL, raw_ostream &OS,
                        StringRef comment, StringRef varName, unsigned offset,
                        unsigned indent, unsigned offsetIndent,
                        unsigned sizeOfStruct) {
@@ -980,7 +981,7 @@ void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
 }
 
 void PrintStructBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
-                                 const DataLayout &DL, raw_string_ostream &OS,
+                                 const DataLayout &DL, raw_ostream &OS,
                                  StringRef comment) {
   const unsigned offsetIndent = 50;
 
@@ -1027,7 +1028,7 @@ void PrintStructBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
 }
 
 void PrintTBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
-                            raw_string_ostream &OS, StringRef comment) {
+                            raw_ostream &OS, StringRef comment) {
   const unsigned offsetIndent = 50;
   llvm::Type *Ty = buf->GetHLSLType()->getPointerElementType();
   // For TextureBuffer<> buf[2], the array size is in Resource binding count
@@ -1053,7 +1054,7 @@ void PrintTBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
 }
 
 void PrintCBufferDefinition(DxilCBuffer *buf, DxilTypeSystem &typeSys,
-                            raw_string_ostream &OS, StringRef comment) {
+                            raw_ostream &OS, StringRef comment) {
   const unsigned offsetIndent = 50;
   llvm::Type *Ty = buf->GetHLSLType()->getPointerElementType();
   // For ConstantBuffer<> buf[2], the array size is in Resource binding count
@@ -1079,7 +1080,7 @@ void PrintCBufferDefinition(DxilCBuffer *buf, DxilTypeSystem &typeSys,
   OS << comment << "\n";
 }
 
-void PrintBufferDefinitions(DxilModule &M, raw_string_ostream &OS,
+void PrintBufferDefinitions(DxilModule &M, raw_ostream &OS,
                             StringRef comment) {
   OS << comment << "\n"
      << comment << " Buffer Definitions:\n"
@@ -1354,7 +1355,7 @@ public:
 void PrintPipelineStateValidationRuntimeInfo(const char *pBuffer,
                                              const uint32_t uBufferSize,
                                              DXIL::ShaderKind shaderKind,
-                                             raw_string_ostream &OS,
+                                             raw_ostream &OS,
                                              StringRef comment) {
   OS << comment << "\n"
      << comment << " Pipeline Runtime Information: \n"
@@ -1370,7 +1371,8 @@ void PrintPipelineStateValidationRuntimeInfo(const char *pBuffer,
 
 namespace dxcutil {
 
-HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
+HRESULT Disassemble(IDxcBlob *pProgram, raw_ostream &Stream,
+                    StringRef FunctionName) {
   CComPtr<IDxcBlob> pPdbContainerBlob;
   {
     CComPtr<IStream> pStream;
@@ -1508,20 +1510,43 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
     }
   }
 
+  // Load the modules lazily: function bodies are only parsed when they are
+  // going to be printed, and never for the reflection module, which is only
+  // used for its metadata.
   std::string DiagStr;
   llvm::LLVMContext llvmContext;
-  std::unique_ptr<llvm::Module> pModule(dxilutil::LoadModuleFromBitcode(
-      llvm::StringRef(pIL, pILLength), llvmContext, DiagStr));
+  std::unique_ptr<llvm::Module> pModule(dxilutil::LoadModuleFromBitcodeLazy(
+      llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(pIL, pILLength), "",
+                                       false),
+      llvmContext, DiagStr));
   if (pModule.get() == nullptr) {
     return DXC_E_IR_VERIFICATION_FAILED;
   }
+  if (FunctionName.empty() ? pModule->materializeAll()
+                           : pModule->materializeMetadata()) {
+    return DXC_E_IR_VERIFICATION_FAILED;
+  }
 
   std::unique_ptr<llvm::Module> pReflectionModule;
   if (pReflectionIL && pReflectionILLength) {
-    pReflectionModule = dxilutil::LoadModuleFromBitcode(
-        llvm::StringRef(pReflectionIL, pReflectionILLength), llvmContext,
-        DiagStr);
-    if (pReflectionModule.get() == nullptr) {
+    pReflectionModule = dxilutil::LoadModuleFromBitcodeLazy(
+        llvm::MemoryBuffer::getMemBuffer(
+            llvm::StringRef(pReflectionIL, pReflectionILLength), "", false),
+        llvmContext, DiagStr);
+    if (pReflectionModule.get() == nullptr ||
+        pReflectionModule->materializeMetadata()) {
+      return DXC_E_IR_VERIFICATION_FAILED;
+    }
+  }
+
+  llvm::Function *pFunction = nullptr;
+  if (!FunctionName.empty()) {
+    pFunction = pModule->getFunction(FunctionName);
+    if (pFunction == nullptr) {
+      throw hlsl::Exception(E_INVALIDARG, "function '" + FunctionName.str() +
+                                              "' not found in module");
+    }
+    if (pFunction->materialize()) {
       return DXC_E_IR_VERIFICATION_FAILED;
     }
   }
@@ -1570,7 +1595,10 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
     }
   }
   DxcAssemblyAnnotationWriter w;
-  pModule->print(Stream, &w);
+  if (pFunction)
+    pFunction->print(Stream, &w);
+  else
+    pModule->print(Stream, &w);
   // if (pReflectionModule) {
   //   Stream << "\n========== Reflection Module from STAT part ==========\n";
   //   pReflectionModule->print(Stream, &w);
@@ -199,13 +199,17 @@ DxcLinker::RegisterLibrary(LPCWSTR pLibName, // Name of the library.
 
     raw_stream_ostream DiagStream(pDiagStream);
 
+    // The linker only keeps the debug module when the library has one, so
+    // avoid parsing the stripped program bitcode in that case.
     IFR(ValidateLoadModuleFromContainerLazy(
         pBlob->GetBufferPointer(), pBlob->GetBufferSize(), pModule,
-        pDebugModule, m_Ctx, m_Ctx, DiagStream));
+        pDebugModule, m_Ctx, m_Ctx, DiagStream,
+        /*bSkipProgramIfDebug*/ true));
 
-    // add an entry into the library to compiler version part map
     const hlsl::DxilContainerHeader *pHeader = hlsl::IsDxilContainerLike(
         pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+
+    // add an entry into the library to compiler version part map
     const DxilPartHeader *pDPH = hlsl::GetDxilPartByType(
         pHeader, hlsl::DxilFourCC::DFCC_CompilerVersion);
     if (pDPH) {
@@ -415,6 +419,8 @@ HRESULT STDMETHODCALLTYPE DxcLinker::Link(
             SerializeFlags, pOutputStream, 0, opts.DebugFile, &Diag,
             &ShaderHashContent, pReflectionStream, pRootSigStream, nullptr,
             nullptr);
+        inputs.BitcodeWriterThreads = opts.OptToggles.GetSelectUnsigned(
+            hlsl::options::SELECT_PARALLEL_BITCODE_WRITER_THREADS, 0);
         if (needsValidation) {
           valHR = dxcutil::ValidateAndAssembleToContainer(inputs);
         } else {
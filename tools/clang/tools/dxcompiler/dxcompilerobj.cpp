@@ -23,6 +23,7 @@
 #include "clang/Lex/HLSLMacroExpander.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/SemaHLSL.h"
+#include "llvm/Analysis/DxilValueCache.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Support/TimeProfiler.h"
@@ -458,6 +459,8 @@ static HRESULT ErrorWithString(const std::string &error, REFIID riid,
 class DxcCompiler : public IDxcCompiler3,
                     public IDxcLangExtensions3,
                     public IDxcContainerEvent,
+                    public IDxcFunctionDisassembler,
+                    public IDxcStreamDisassembler,
                     public IDxcVersionInfo3,
 #ifdef SUPPORT_QUERY_GIT_COMMIT_INFO
                     public IDxcVersionInfo2
@@ -498,7 +501,9 @@ public:
                                            void **ppvObject) override {
     HRESULT hr = DoBasicQueryInterface<IDxcCompiler3, IDxcLangExtensions,
                                        IDxcLangExtensions2, IDxcLangExtensions3,
-                                       IDxcContainerEvent, IDxcVersionInfo
+                                       IDxcContainerEvent,
+                                       IDxcFunctionDisassembler,
+                                       IDxcStreamDisassembler, IDxcVersionInfo
 #ifdef SUPPORT_QUERY_GIT_COMMIT_INFO
                                        ,
                                        IDxcVersionInfo2
@@ -1047,6 +1052,8 @@ public:
               pRootSigStream, pRootSignatureBlob, pPrivateBlob);
 
           inputs.pVersionInfo = static_cast<IDxcVersionInfo *>(this);
+          inputs.BitcodeWriterThreads = opts.OptToggles.GetSelectUnsigned(
+              hlsl::options::SELECT_PARALLEL_BITCODE_WRITER_THREADS, 0);
 
           if (needsValidation) {
             valHR = dxcutil::ValidateAndAssembleToContainer(inputs);
@@ -1227,9 +1234,13 @@ public:
           if (!opts.SourceInDebugModule) { // If we are using old PDB format
                                            // where sources are in debug module,
                                            // do not generate source info at all
+            const bool bParallelDeflate = opts.OptToggles.IsEnabled(
+                hlsl::options::TOGGLE_PARALLEL_DEFLATE);
             debugSourceInfoWriter.Write(opts.TargetProfile, opts.EntryPoint,
                                         compiler.getCodeGenOpts(),
-                                        compiler.getSourceManager());
+                                        compiler.getSourceManager(),
+                                        opts.SourceCompressPerFile,
+                                        bParallelDeflate);
             pSourceInfo = debugSourceInfoWriter.GetPart();
           }
 
@@ -1250,7 +1261,11 @@ public:
             IFT(CreateMemoryStream(DxcGetThreadMallocNoRef(),
                                    &pDebugBlobStorage));
             raw_stream_ostream outStream(pDebugBlobStorage.p);
-            WriteBitcodeToFile(debugModule.get(), outStream, true);
+            WriteBitcodeForContainer(
+                debugModule.get(), outStream, true,
+                hlsl::options::ComputeSerializeDxilFlags(opts),
+                opts.OptToggles.GetSelectUnsigned(
+                    hlsl::options::SELECT_PARALLEL_BITCODE_WRITER_THREADS, 0));
             outStream.flush();
             IFT(pDebugBlobStorage.QueryInterface(&pDebugProgramBlob));
           }
@@ -1340,6 +1355,41 @@ public:
       REFIID riid,
       LPVOID *ppResult // IDxcResult: status, disassembly text, and errors
       ) override {
+    return DisassembleImpl(pObject, StringRef(), nullptr, riid, ppResult);
+  }
+
+  // Disassemble a single function of a program.
+  virtual HRESULT STDMETHODCALLTYPE DisassembleFunction(
+      const DxcBuffer
+          *pObject, // Program to disassemble: dxil container or bitcode.
+      LPCSTR pFunctionName, // Name of the function to disassemble.
+      REFIID riid,
+      LPVOID *ppResult // IDxcResult: status, disassembly text, and errors
+      ) override {
+    if (pFunctionName == nullptr || *pFunctionName == '\0')
+      return E_INVALIDARG;
+    return DisassembleImpl(pObject, pFunctionName, nullptr, riid, ppResult);
+  }
+
+  // Disassemble a program into a caller stream.
+  virtual HRESULT STDMETHODCALLTYPE DisassembleToStream(
+      const DxcBuffer
+          *pObject, // Program to disassemble: dxil container or bitcode.
+      LPCSTR pFunctionName, // Optional name of the function to disassemble.
+      IStream *pOutput,     // Receives the disassembly text.
+      REFIID riid,
+      LPVOID *ppResult // IDxcResult: status and errors
+      ) override {
+    if (pOutput == nullptr)
+      return E_INVALIDARG;
+    return DisassembleImpl(pObject,
+                           pFunctionName ? pFunctionName : StringRef(),
+                           pOutput, riid, ppResult);
+  }
+
+  // Disassembles into pOutput if set, otherwise into the result blob.
+  HRESULT DisassembleImpl(const DxcBuffer *pObject, StringRef FunctionName,
+                          IStream *pOutput, REFIID riid, LPVOID *ppResult) {
     if (pObject == nullptr || ppResult == nullptr)
       return E_INVALIDARG;
     if (!(IsEqualIID(riid, __uuidof(IDxcResult)) ||
@@ -1362,18 +1412,41 @@ public:
       ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
       IFTLLVM(pts.error_code());
 
-      std::string StreamStr;
-      raw_string_ostream Stream(StreamStr);
-
       CComPtr<IDxcBlobEncoding> pProgram;
       IFT(hlsl::DxcCreateBlob(pObject->Ptr, pObject->Size, true, false, false,
                               0, nullptr, &pProgram))
-      IFC(dxcutil::Disassemble(pProgram, Stream));
 
-      IFT(DxcResult::Create(S_OK, DXC_OUT_DISASSEMBLY,
-                            {DxcOutputObject::StringOutput(
-                                DXC_OUT_DISASSEMBLY, CP_UTF8, StreamStr.c_str(),
-                                StreamStr.size(), DxcOutNoName)},
+      if (pOutput) {
+        {
+          raw_istream_ostream Stream(pOutput);
+          IFC(dxcutil::Disassemble(pProgram, Stream, FunctionName));
+        }
+        IFT(DxcResult::Create(S_OK, DXC_OUT_NONE, {}, &pResult));
+        IFT(pResult->QueryInterface(riid, ppResult));
+        return S_OK;
+      }
+
+      // Print straight into the memory stream that backs the result blob, so
+      // the listing is never held in a string and copied out afterwards.
+      CComPtr<AbstractMemoryStream> pDisassemblyStream;
+      IFT(CreateMemoryStream(m_pMalloc, &pDisassemblyStream));
+      {
+        raw_stream_ostream Stream(pDisassemblyStream.p);
+        IFC(dxcutil::Disassemble(pProgram, Stream, FunctionName));
+        Stream << '\0';
+      }
+
+      CComPtr<IDxcBlob> pDisassemblyBlob;
+      CComPtr<IDxcBlobEncoding> pDisassembly;
+      IFT(pDisassemblyStream.QueryInterface(&pDisassemblyBlob));
+      IFT(DxcCreateBlobWithEncodingSet(m_pMalloc, pDisassemblyBlob, CP_UTF8,
+                                       &pDisassembly));
+
+      // The text is already null-terminated UTF-8; skip the translation copy.
+      DxcOutputObject disassemblyOutput;
+      disassemblyOutput.kind = DXC_OUT_DISASSEMBLY;
+      IFT(disassemblyOutput.SetObject(pDisassembly, /*codePage*/ 0));
+      IFT(DxcResult::Create(S_OK, DXC_OUT_DISASSEMBLY, {disassemblyOutput},
                             &pResult));
       IFT(pResult->QueryInterface(riid, ppResult));
 
@@ -1893,7 +1966,8 @@ HRESULT DxcCompilerAdapter::WrapCompile(
     dxcutil::ReadOptsAndValidate(mainArgs, opts, pOutputStream,
                                  &pOperationResult, finished);
     if (!opts.TimeTrace.empty())
-      llvm::timeTraceProfilerInitialize(opts.TimeTraceGranularity);
+      llvm::timeTraceProfilerInitialize(opts.TimeTraceGranularity,
+                                        opts.TimeTracePassCosts);
     if (finished) {
       IFT(pOperationResult->QueryInterface(ppResult));
       return S_OK;
@@ -1943,6 +2017,7 @@ HRESULT DxcCompilerAdapter::WrapCompile(
       std::string TimeReport;
       raw_string_ostream OS(TimeReport);
       llvm::TimerGroup::printAll(OS);
+      llvm::printDxilValueCacheReport(OS);
       IFT(pResult->SetOutputString(DXC_OUT_TIME_REPORT, TimeReport.c_str(),
                                    TimeReport.size()));
     }
@@ -289,12 +289,18 @@ private:
   struct Source_File {
     CComPtr<IDxcBlobWide> Name;
     CComPtr<IDxcBlobEncoding> Content;
+    // Index of the source in m_pSourceInfoReader while Content has not been
+    // created yet.
+    unsigned ReaderIndex = UINT_MAX;
   };
 
   CComPtr<IDxcBlob> m_InputBlob;
   CComPtr<IDxcBlob> m_pDebugProgramBlob;
   CComPtr<IDxcBlob> m_ContainerBlob;
   std::vector<Source_File> m_SourceFiles;
+  // Reads the legacy source info part out of m_ContainerBlob, so sources are
+  // only decompressed when they are asked for.
+  std::unique_ptr<hlsl::SourceInfoReader> m_pSourceInfoReader;
 
   CComPtr<IDxcBlobWide> m_EntryPoint;
   CComPtr<IDxcBlobWide> m_TargetProfile;
@@ -347,6 +353,7 @@ private:
     m_InputBlob = nullptr;
     m_ContainerBlob = nullptr;
     m_SourceFiles.clear();
+    m_pSourceInfoReader.reset();
     m_Name = nullptr;
     m_MainFileName = nullptr;
     m_HashBlob = nullptr;
@@ -413,20 +420,37 @@ private:
     return ret;
   }
 
-  HRESULT AddSource(StringRef name, StringRef content) {
-    Source_File source;
-    IFR(hlsl::DxcCreateBlob(content.data(), content.size(),
-                            /*bPinned*/ false, /*bCopy*/ true,
-                            /*encodingKnown*/ true, CP_UTF8, m_pMalloc,
-                            &source.Content));
+  HRESULT CreateSourceContent(StringRef content,
+                              IDxcBlobEncoding **ppContent) {
+    return hlsl::DxcCreateBlob(content.data(), content.size(),
+                               /*bPinned*/ false, /*bCopy*/ true,
+                               /*encodingKnown*/ true, CP_UTF8, m_pMalloc,
+                               ppContent);
+  }
 
+  HRESULT AddSourceName(StringRef name, Source_File &source) {
     std::string normalizedPath = hlsl::NormalizePath(name);
     IFR(Utf8ToBlobWide(normalizedPath, &source.Name));
     // First file is the main file
     if (m_SourceFiles.empty()) {
       m_MainFileName = source.Name;
     }
+    return S_OK;
+  }
+
+  HRESULT AddSource(StringRef name, StringRef content) {
+    Source_File source;
+    IFR(CreateSourceContent(content, &source.Content));
+    IFR(AddSourceName(name, source));
+    m_SourceFiles.push_back(std::move(source));
+    return S_OK;
+  }
 
+  // Adds source i of m_pSourceInfoReader; its content is read in GetSource.
+  HRESULT AddDeferredSource(unsigned i) {
+    Source_File source;
+    source.ReaderIndex = i;
+    IFR(AddSourceName(m_pSourceInfoReader->GetSourceName(i), source));
     m_SourceFiles.push_back(std::move(source));
     return S_OK;
   }
@@ -702,7 +726,8 @@ private:
       case hlsl::DFCC_ShaderSourceInfo: {
         const hlsl::DxilSourceInfo *header =
             (const hlsl::DxilSourceInfo *)(part + 1);
-        hlsl::SourceInfoReader reader;
+        m_pSourceInfoReader.reset(new hlsl::SourceInfoReader());
+        hlsl::SourceInfoReader &reader = *m_pSourceInfoReader;
         if (!reader.Init(header, part->PartSize)) {
           Reset();
           return E_FAIL;
@@ -714,11 +739,9 @@ private:
           IFR(AddArgPair(pair.Name, pair.Value));
         }
 
-        // Sources
-        for (unsigned i = 0; i < reader.GetSourcesCount(); i++) {
-          hlsl::SourceInfoReader::Source source_data = reader.GetSource(i);
-          IFR(AddSource(source_data.Name, source_data.Content));
-        }
+        // Sources. Their content is decompressed on first access.
+        for (unsigned i = 0; i < reader.GetSourcesCount(); i++)
+          IFR(AddDeferredSource(i));
 
       } break;
 
@@ -934,7 +957,15 @@ public:
     if (!ppResult)
       return E_POINTER;
     *ppResult = nullptr;
-    return m_SourceFiles[uIndex].Content.QueryInterface(ppResult);
+    Source_File &source = m_SourceFiles[uIndex];
+    if (!source.Content) {
+      DXASSERT_NOMSG(m_pSourceInfoReader);
+      hlsl::SourceInfoReader::Source source_data;
+      if (!m_pSourceInfoReader->GetSource(source.ReaderIndex, source_data))
+        return E_FAIL;
+      IFR(CreateSourceContent(source_data.Content, &source.Content));
+    }
+    return source.Content.QueryInterface(ppResult);
   }
 
   virtual HRESULT STDMETHODCALLTYPE
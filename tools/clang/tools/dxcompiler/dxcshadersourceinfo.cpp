@@ -21,6 +21,7 @@
 #include "dxc/Support/HLSLOptions.h"
 #include "dxc/Support/Path.h"
 #include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/WorkerThreads.h"
 
 using namespace hlsl;
 using Buffer = SourceInfoWriter::Buffer;
@@ -33,6 +34,84 @@ static size_t PointerByteOffset(const void *a, const void *b) {
   return (const uint8_t *)a - (const uint8_t *)b;
 }
 
+// Reads the content of an entry that has at most `size` bytes available.
+static bool
+ReadContentEntry(const hlsl::DxilSourceInfo_SourceContentsEntry *entry,
+                 size_t size, llvm::StringRef *pContent) {
+  if (sizeof(*entry) > size)
+    return false;
+  if (sizeof(*entry) + entry->ContentSizeInBytes > size)
+    return false;
+  if (entry->AlignedSizeInBytes > size)
+    return false;
+
+  const char *ptr = (const char *)(entry + 1);
+  if (entry->ContentSizeInBytes > 0) {
+    // Fail if not null terminated
+    if (ptr[entry->ContentSizeInBytes - 1] != '\0')
+      return false;
+    *pContent = llvm::StringRef(ptr, entry->ContentSizeInBytes - 1);
+  }
+  return true;
+}
+
+bool SourceInfoReader::InitCompressedContents(
+    const hlsl::DxilSourceInfo_SourceContents *header) {
+  const hlsl::DxilSourceInfo_SourceContentsIndexEntry *index =
+      (const hlsl::DxilSourceInfo_SourceContentsIndexEntry *)(header + 1);
+  const size_t indexSizeInBytes = (size_t)header->Count * sizeof(*index);
+  if (indexSizeInBytes > header->EntriesSizeInBytes)
+    return false;
+  const uint8_t *streams = (const uint8_t *)(index + header->Count);
+  const size_t streamsSizeInBytes =
+      header->EntriesSizeInBytes - indexSizeInBytes;
+
+  assert(m_Sources.size() == 0 || m_Sources.size() == header->Count);
+  m_Sources.resize(header->Count);
+  m_CompressedContents.resize(header->Count);
+  m_UncompressedContents.resize(header->Count);
+
+  // Only check the index here; the streams are decompressed on demand.
+  for (unsigned i = 0; i < header->Count; i++) {
+    const hlsl::DxilSourceInfo_SourceContentsIndexEntry &entry = index[i];
+    if (entry.OffsetInBytes > streamsSizeInBytes)
+      return false;
+    if (entry.SizeInBytes > streamsSizeInBytes - entry.OffsetInBytes)
+      return false;
+    if (entry.SizeInBytes > entry.UncompressedSizeInBytes)
+      return false;
+    m_CompressedContents[i].IndexEntry = &entry;
+    m_CompressedContents[i].Stream = streams + entry.OffsetInBytes;
+  }
+  return true;
+}
+
+bool SourceInfoReader::GetSource(unsigned i, Source &source) const {
+  if (i < m_CompressedContents.size() && m_CompressedContents[i].IndexEntry) {
+    const CompressedContent &compressed = m_CompressedContents[i];
+    const hlsl::DxilSourceInfo_SourceContentsIndexEntry *indexEntry =
+        compressed.IndexEntry;
+    const void *entry = compressed.Stream;
+    if (indexEntry->SizeInBytes != indexEntry->UncompressedSizeInBytes) {
+      Buffer &uncompressed = m_UncompressedContents[i];
+      uncompressed.resize(indexEntry->UncompressedSizeInBytes);
+      if (hlsl::ZlibResult::Success !=
+          ZlibDecompress(DxcGetThreadMallocNoRef(), compressed.Stream,
+                         indexEntry->SizeInBytes, uncompressed.data(),
+                         uncompressed.size()))
+        return false;
+      entry = uncompressed.data();
+    }
+    if (!ReadContentEntry(
+            (const hlsl::DxilSourceInfo_SourceContentsEntry *)entry,
+            indexEntry->UncompressedSizeInBytes, &m_Sources[i].Content))
+      return false;
+    m_CompressedContents[i] = CompressedContent();
+  }
+  source = m_Sources[i];
+  return true;
+}
+
 bool SourceInfoReader::Init(const hlsl::DxilSourceInfo *SourceInfo,
                             unsigned sourceInfoSize) {
   if (sizeof(*SourceInfo) > sourceInfoSize)
@@ -158,6 +237,13 @@ bool SourceInfoReader::Init(const hlsl::DxilSourceInfo *SourceInfo,
           sectionSizeInBytes)
         return false;
 
+      if (header->CompressType ==
+          hlsl::DxilSourceInfo_SourceContentsCompressType::ZlibPerEntry) {
+        if (!InitCompressedContents(header))
+          return false;
+        break;
+      }
+
       const hlsl::DxilSourceInfo_SourceContentsEntry *firstEntry = nullptr;
       if (header->CompressType ==
           hlsl::DxilSourceInfo_SourceContentsCompressType::Zlib) {
@@ -195,29 +281,12 @@ bool SourceInfoReader::Init(const hlsl::DxilSourceInfo *SourceInfo,
 
       const hlsl::DxilSourceInfo_SourceContentsEntry *entry = firstEntry;
       for (unsigned i = 0; i < header->Count; i++) {
-        if (PointerByteOffset(entry + 1, firstEntry) >
-            header->UncompressedEntriesSizeInBytes)
-          return false;
-        if (PointerByteOffset(entry + 1, firstEntry) +
-                entry->ContentSizeInBytes >
-            header->UncompressedEntriesSizeInBytes)
-          return false;
-        if (PointerByteOffset(entry, firstEntry) + entry->AlignedSizeInBytes >
-            header->UncompressedEntriesSizeInBytes)
+        if (!ReadContentEntry(entry,
+                              header->UncompressedEntriesSizeInBytes -
+                                  PointerByteOffset(entry, firstEntry),
+                              &m_Sources[i].Content))
           return false;
 
-        const void *ptr = entry + 1;
-        if (entry->ContentSizeInBytes > 0) {
-          // Fail if not null terminated
-          if (((const char *)ptr)[entry->ContentSizeInBytes - 1] != '\0')
-            return false;
-          llvm::StringRef content = {
-              (const char *)ptr,
-              entry->ContentSizeInBytes - 1,
-          };
-          m_Sources[i].Content = content;
-        }
-
         entry = (const hlsl::DxilSourceInfo_SourceContentsEntry
                      *)((const uint8_t *)entry + entry->AlignedSizeInBytes);
       }
@@ -274,6 +343,74 @@ static void AppendFileContentEntry(Buffer *buf, llvm::StringRef content) {
   assert(paddedOffset == header.AlignedSizeInBytes);
 }
 
+struct SourceFile {
+  std::string Name;
+  llvm::StringRef Content;
+};
+
+// Sources smaller than this in total are compressed on the calling thread.
+static const size_t kParallelCompressionMinSize = 256 * 1024;
+
+// Compresses each entry into its own stream. A stream is left empty when
+// compression does not make the entry smaller.
+static void CompressEntries(const std::vector<Buffer> &entries,
+                            std::vector<Buffer> &streams,
+                            size_t totalSizeInBytes) {
+  IMalloc *pMalloc = DxcGetThreadMallocNoRef();
+  const unsigned numThreads =
+      totalSizeInBytes >= kParallelCompressionMinSize ? 0 : 1;
+  hlsl::ParallelFor(numThreads, entries.size(), [&](size_t i) {
+    hlsl::ZlibResult result = ZlibCompressAppend(
+        pMalloc, entries[i].data(), entries[i].size(), streams[i]);
+    if (result != hlsl::ZlibResult::Success ||
+        streams[i].size() >= entries[i].size())
+      streams[i].clear();
+  });
+}
+
+static void
+AppendContentsCompressedPerEntry(Buffer *buf,
+                                 const std::vector<SourceFile> &sourceFileList) {
+  const unsigned count = sourceFileList.size();
+  std::vector<Buffer> entries(count);
+  std::vector<Buffer> streams(count);
+  size_t uncompressedSize = 0;
+  for (unsigned i = 0; i < count; i++) {
+    AppendFileContentEntry(&entries[i], sourceFileList[i].Content);
+    uncompressedSize += entries[i].size();
+  }
+  CompressEntries(entries, streams, uncompressedSize);
+
+  // Write the header, and an empty index to fill in once the streams are laid
+  // out.
+  const size_t headerOffset = buf->size();
+  hlsl::DxilSourceInfo_SourceContents header = {};
+  header.CompressType =
+      hlsl::DxilSourceInfo_SourceContentsCompressType::ZlibPerEntry;
+  header.UncompressedEntriesSizeInBytes = uncompressedSize;
+  header.Count = count;
+  Append(buf, &header, sizeof(header));
+
+  const size_t indexOffset = buf->size();
+  std::vector<hlsl::DxilSourceInfo_SourceContentsIndexEntry> index(count);
+  Append(buf, index.data(), count * sizeof(index[0]));
+
+  const size_t streamsOffset = buf->size();
+  for (unsigned i = 0; i < count; i++) {
+    const Buffer &stream = streams[i].empty() ? entries[i] : streams[i];
+    index[i].OffsetInBytes = buf->size() - streamsOffset;
+    index[i].SizeInBytes = stream.size();
+    index[i].UncompressedSizeInBytes = entries[i].size();
+    Append(buf, stream.data(), stream.size());
+    PadBufferToFourBytes(buf, buf->size() - streamsOffset);
+  }
+
+  // Go back and write the index and the header.
+  memcpy(buf->data() + indexOffset, index.data(), count * sizeof(index[0]));
+  header.EntriesSizeInBytes = buf->size() - indexOffset;
+  memcpy(buf->data() + headerOffset, &header, sizeof(header));
+}
+
 static size_t BeginSection(Buffer *buf) {
   const size_t sectionOffset = buf->size();
 
@@ -298,11 +435,6 @@ static void FinishSection(Buffer *buf, const size_t sectionOffset,
   memcpy(buf->data() + sectionOffset, &sectionHeader, sizeof(sectionHeader));
 }
 
-struct SourceFile {
-  std::string Name;
-  llvm::StringRef Content;
-};
-
 static std::vector<SourceFile> ComputeFileList(clang::CodeGenOptions &cgOpts,
                                                clang::SourceManager &srcMgr) {
   std::vector<SourceFile> ret;
@@ -344,7 +476,8 @@ static std::vector<SourceFile> ComputeFileList(clang::CodeGenOptions &cgOpts,
 void SourceInfoWriter::Write(llvm::StringRef targetProfile,
                              llvm::StringRef entryPoint,
                              clang::CodeGenOptions &cgOpts,
-                             clang::SourceManager &srcMgr) {
+                             clang::SourceManager &srcMgr,
+                             bool bCompressPerEntry, bool bParallelDeflate) {
   m_Buffer.clear();
 
   // Write an empty header first.
@@ -400,7 +533,13 @@ void SourceInfoWriter::Write(llvm::StringRef targetProfile,
   ////////////////////////////////////////////////////////////////////
   // Add all file contents in a list.
   ////////////////////////////////////////////////////////////////////
-  {
+  if (bCompressPerEntry) {
+    const size_t sectionOffset = BeginSection(&m_Buffer);
+    AppendContentsCompressedPerEntry(&m_Buffer, sourceFileList);
+    FinishSection(&m_Buffer, sectionOffset,
+                  hlsl::DxilSourceInfoSectionType::SourceContents);
+    mainHeader.SectionCount++;
+  } else {
     const size_t sectionOffset = BeginSection(&m_Buffer);
 
     // Put all the contents in a buffer
@@ -423,7 +562,8 @@ void SourceInfoWriter::Write(llvm::StringRef targetProfile,
     bool bCompressed =
         hlsl::ZlibResult::Success ==
         ZlibCompressAppend(DxcGetThreadMallocNoRef(), uncompressedBuffer.data(),
-                           uncompressedBuffer.size(), m_Buffer);
+                           uncompressedBuffer.size(), m_Buffer,
+                           bParallelDeflate);
 
     // If we compressed the content, go back to rewrite the header to write the
     // correct size in bytes.
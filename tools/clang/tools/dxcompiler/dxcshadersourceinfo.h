@@ -37,10 +37,21 @@ struct SourceInfoReader {
     std::string Value;
   };
 
-  std::vector<Source> m_Sources;
+  // Contents compressed per entry are only decompressed when first requested.
+  struct CompressedContent {
+    const hlsl::DxilSourceInfo_SourceContentsIndexEntry *IndexEntry = nullptr;
+    const uint8_t *Stream = nullptr;
+  };
+
+  mutable std::vector<Source> m_Sources;
+  mutable std::vector<CompressedContent> m_CompressedContents;
+  mutable std::vector<Buffer> m_UncompressedContents;
   std::vector<ArgPair> m_ArgPairs;
 
-  Source GetSource(unsigned i) const { return m_Sources[i]; }
+  // Returns false if the content of the source is corrupt.
+  bool GetSource(unsigned i, Source &source) const;
+  // The name is available without decompressing the content.
+  llvm::StringRef GetSourceName(unsigned i) const { return m_Sources[i].Name; }
   unsigned GetSourcesCount() const { return m_Sources.size(); }
 
   const ArgPair &GetArgPair(unsigned i) const { return m_ArgPairs[i]; }
@@ -48,6 +59,9 @@ struct SourceInfoReader {
 
   // Note: The memory for SourceInfo must outlive this structure.
   bool Init(const hlsl::DxilSourceInfo *SourceInfo, unsigned sourceInfoSize);
+
+private:
+  bool InitCompressedContents(const hlsl::DxilSourceInfo_SourceContents *header);
 };
 
 // Herper for writing the shader source part.
@@ -56,8 +70,12 @@ struct SourceInfoWriter {
   Buffer m_Buffer;
 
   const hlsl::DxilSourceInfo *GetPart() const;
+  // With bCompressPerEntry, each source is compressed on its own, on worker
+  // threads for large inputs, so readers can load a single source. Otherwise,
+  // bParallelDeflate compresses the contents with ZlibCompressParallel.
   void Write(llvm::StringRef targetProfile, llvm::StringRef entryPoint,
-             clang::CodeGenOptions &cgOpts, clang::SourceManager &srcMgr);
+             clang::CodeGenOptions &cgOpts, clang::SourceManager &srcMgr,
+             bool bCompressPerEntry = false, bool bParallelDeflate = false);
 };
 
 } // namespace hlsl
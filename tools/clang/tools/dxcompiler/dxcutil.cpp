@@ -93,13 +93,13 @@ void AssembleToContainer(AssembleInputs &inputs) {
         inputs.pVersionInfo, pContainerStream, inputs.DebugName,
         inputs.SerializeFlags, inputs.pShaderHashOut, inputs.pReflectionOut,
         inputs.pRootSigOut, inputs.pPrivateBlob->GetBufferPointer(),
-        inputs.pPrivateBlob->GetBufferSize());
+        inputs.pPrivateBlob->GetBufferSize(), inputs.BitcodeWriterThreads);
   } else {
     SerializeDxilContainerForModule(
         &inputs.pM->GetOrCreateDxilModule(), inputs.pModuleBitcode,
         inputs.pVersionInfo, pContainerStream, inputs.DebugName,
         inputs.SerializeFlags, inputs.pShaderHashOut, inputs.pReflectionOut,
-        inputs.pRootSigOut);
+        inputs.pRootSigOut, nullptr, 0, inputs.BitcodeWriterThreads);
   }
   inputs.pOutputContainerBlob.Release();
   IFT(pContainerStream.QueryInterface(&inputs.pOutputContainerBlob));
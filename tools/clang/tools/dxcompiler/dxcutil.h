@@ -28,7 +28,7 @@ namespace llvm {
 class LLVMContext;
 class MemoryBuffer;
 class Module;
-class raw_string_ostream;
+class raw_ostream;
 class Twine;
 } // namespace llvm
 
@@ -69,6 +69,9 @@ struct AssembleInputs {
   hlsl::AbstractMemoryStream *pRootSigOut = nullptr;
   CComPtr<IDxcBlob> pRootSigBlob = nullptr;
   CComPtr<IDxcBlob> pPrivateBlob = nullptr;
+  // Threads for SerializeDxilFlags::ParallelBitcodeWriter; zero uses one per
+  // hardware thread.
+  unsigned BitcodeWriterThreads = 0;
 };
 HRESULT ValidateAndAssembleToContainer(AssembleInputs &inputs);
 HRESULT
@@ -77,7 +80,10 @@ ValidateRootSignatureInContainer(IDxcBlob *pRootSigContainer,
 HRESULT SetRootSignature(hlsl::DxilModule *pModule, CComPtr<IDxcBlob> pSource);
 void GetValidatorVersion(unsigned *pMajor, unsigned *pMinor);
 void AssembleToContainer(AssembleInputs &inputs);
-HRESULT Disassemble(IDxcBlob *pProgram, llvm::raw_string_ostream &Stream);
+// When FunctionName is set, only that function's body is loaded and printed;
+// the other function bodies are never materialized.
+HRESULT Disassemble(IDxcBlob *pProgram, llvm::raw_ostream &Stream,
+                    llvm::StringRef FunctionName = llvm::StringRef());
 void ReadOptsAndValidate(hlsl::options::MainArgs &mainArgs,
                          hlsl::options::DxcOpts &opts,
                          hlsl::AbstractMemoryStream *pOutputStream,
@@ -3058,6 +3058,10 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
     = options & CXTranslationUnit_IncludeBriefCommentsInCodeCompletion;
   bool SkipFunctionBodies = options & CXTranslationUnit_SkipFunctionBodies;
   bool ForSerialization = options & CXTranslationUnit_ForSerialization;
+  // HLSL Change Starts
+  bool SkipPreambleFunctionBodies =
+      options & CXTranslationUnit_SkipPreambleFunctionBodies;
+  // HLSL Change Ends
 
   // Configure the diagnostics.
   IntrusiveRefCntPtr<DiagnosticsEngine>
@@ -3132,7 +3136,8 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
       CacheCodeCompletionResults, IncludeBriefCommentsInCodeCompletion,
       /*AllowPCHWithCompilerErrors=*/true, SkipFunctionBodies,
       /*UserFilesAreVolatile=*/true, ForSerialization, &ErrUnit,
-      CXXIdx->HlslLangExtensions)); // HLSL Change - add language extensions
+      CXXIdx->HlslLangExtensions, // HLSL Change - add language extensions
+      SkipPreambleFunctionBodies)); // HLSL Change
 
   // Early failures in LoadFromCommandLine may return with ErrUnit unset.
   if (!Unit && !ErrUnit) {
@@ -32,6 +32,7 @@
 #include "dxcisenseimpl.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MSFileSystem.h"
+#include <deque>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -1014,7 +1015,16 @@ HRESULT DxcIndex::ParseTranslationUnit(const char *source_filename,
       clang_disposeTranslationUnit(tu);
       return E_OUTOFMEMORY;
     }
-    localTU->Initialize(tu);
+    std::shared_ptr<DxcTranslationUnitWorker> worker;
+    try {
+      worker = std::make_shared<DxcTranslationUnitWorker>(
+          m_pMalloc, this, m_index, source_filename, command_line_args,
+          num_command_line_args, options);
+    } catch (...) {
+      clang_disposeTranslationUnit(tu);
+      throw;
+    }
+    localTU->Initialize(tu, std::move(worker));
     *pTranslationUnit = localTU.Detach();
 
     return S_OK;
@@ -1299,25 +1309,33 @@ HRESULT DxcToken::GetSpelling(LPSTR *pValue) {
 DxcTranslationUnit::DxcTranslationUnit(IMalloc *pMalloc)
     : m_dwRef(0), m_pMalloc(pMalloc), m_tu(nullptr) {}
 
-DxcTranslationUnit::~DxcTranslationUnit() {
-  if (m_tu != nullptr) {
-    // TODO: until an interface to file access is defined and implemented,
-    // simply fall back to pure Win32/CRT calls. Also, note that this can throw
-    // / fail in a destructor, which is a big no-no.
-    ::llvm::sys::fs::MSFileSystem *msfPtr;
-    CreateMSFileSystemForDisk(&msfPtr);
-    assert(msfPtr != nullptr);
-    std::unique_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
+static void DisposeTranslationUnit(CXTranslationUnit tu) {
+  // TODO: until an interface to file access is defined and implemented,
+  // simply fall back to pure Win32/CRT calls. Also, note that this can throw
+  // / fail in a destructor, which is a big no-no.
+  ::llvm::sys::fs::MSFileSystem *msfPtr;
+  CreateMSFileSystemForDisk(&msfPtr);
+  assert(msfPtr != nullptr);
+  std::unique_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
 
-    ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
-    assert(!pts.error_code());
+  ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
+  assert(!pts.error_code());
 
-    clang_disposeTranslationUnit(m_tu);
+  clang_disposeTranslationUnit(tu);
+}
+
+DxcTranslationUnit::~DxcTranslationUnit() {
+  if (m_tu != nullptr) {
+    DisposeTranslationUnit(m_tu);
     m_tu = nullptr;
   }
 }
 
-void DxcTranslationUnit::Initialize(CXTranslationUnit tu) { m_tu = tu; }
+void DxcTranslationUnit::Initialize(
+    CXTranslationUnit tu, std::shared_ptr<DxcTranslationUnitWorker> worker) {
+  m_tu = tu;
+  m_worker = std::move(worker);
+}
 
 HRESULT DxcTranslationUnit::GetCursor(IDxcCursor **pCursor) {
   DxcThreadMalloc TM(m_pMalloc);
@@ -1645,6 +1663,356 @@ HRESULT DxcTranslationUnit::CodeCompleteAt(const char *fileName, unsigned line,
   return S_OK;
 }
 
+HRESULT DxcTranslationUnit::Enqueue(DxcIntelliSenseOperation *pOperation,
+                                    IDxcIntelliSenseOperation **ppOperation) {
+  if (m_worker == nullptr)
+    return E_FAIL;
+  HRESULT hr = m_worker->Enqueue(pOperation);
+  if (FAILED(hr))
+    return hr;
+  pOperation->AddRef();
+  *ppOperation = pOperation;
+  return S_OK;
+}
+
+HRESULT DxcTranslationUnit::ReparseAsync(
+    IDxcUnsavedFile **pUnsavedFiles, unsigned numUnsavedFiles,
+    IDxcIntelliSenseOperation **pOperation) {
+  if (pOperation == nullptr)
+    return E_POINTER;
+  *pOperation = nullptr;
+  if (numUnsavedFiles > 0 && pUnsavedFiles == nullptr)
+    return E_INVALIDARG;
+
+  DxcThreadMalloc TM(m_pMalloc);
+  try {
+    CComPtr<DxcIntelliSenseOperation> op =
+        DxcIntelliSenseOperation::Alloc(m_pMalloc);
+    IFROOM(op.p);
+    op->m_kind = DxcIntelliSenseOperation::Kind::Reparse;
+    op->m_unsavedFiles.assign(pUnsavedFiles, pUnsavedFiles + numUnsavedFiles);
+    return Enqueue(op, pOperation);
+  }
+  CATCH_CPP_RETURN_HRESULT();
+}
+
+HRESULT DxcTranslationUnit::CodeCompleteAtAsync(
+    const char *fileName, unsigned line, unsigned column,
+    IDxcUnsavedFile **pUnsavedFiles, unsigned numUnsavedFiles,
+    DxcCodeCompleteFlags options, IDxcIntelliSenseOperation **pOperation) {
+  if (pOperation == nullptr)
+    return E_POINTER;
+  *pOperation = nullptr;
+  if (fileName == nullptr || (numUnsavedFiles > 0 && pUnsavedFiles == nullptr))
+    return E_INVALIDARG;
+
+  DxcThreadMalloc TM(m_pMalloc);
+  try {
+    CComPtr<DxcIntelliSenseOperation> op =
+        DxcIntelliSenseOperation::Alloc(m_pMalloc);
+    IFROOM(op.p);
+    op->m_kind = DxcIntelliSenseOperation::Kind::CodeComplete;
+    op->m_unsavedFiles.assign(pUnsavedFiles, pUnsavedFiles + numUnsavedFiles);
+    op->m_fileName = fileName;
+    op->m_line = line;
+    op->m_column = column;
+    op->m_options = options;
+    return Enqueue(op, pOperation);
+  }
+  CATCH_CPP_RETURN_HRESULT();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool DxcIntelliSenseOperation::IsCancelled() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_cancelled;
+}
+
+void DxcIntelliSenseOperation::Complete(
+    HRESULT status, IDxcTranslationUnit *pTranslationUnit,
+    IDxcCodeCompleteResults *pCodeCompleteResults) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // A cancelled operation has already reported E_ABORT.
+    if (m_cancelled)
+      return;
+    m_status = status;
+    m_translationUnit = pTranslationUnit;
+    m_codeCompleteResults = pCodeCompleteResults;
+  }
+  m_completed.notify_all();
+}
+
+HRESULT DxcIntelliSenseOperation::Cancel() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_status != E_PENDING)
+      return S_OK;
+    m_cancelled = true;
+    m_status = E_ABORT;
+  }
+  m_completed.notify_all();
+  return S_OK;
+}
+
+HRESULT DxcIntelliSenseOperation::Wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_completed.wait(lock, [this] { return m_status != E_PENDING; });
+  return S_OK;
+}
+
+HRESULT DxcIntelliSenseOperation::GetStatus(HRESULT *pStatus) {
+  if (pStatus == nullptr)
+    return E_POINTER;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  *pStatus = m_status;
+  return S_OK;
+}
+
+HRESULT
+DxcIntelliSenseOperation::GetTranslationUnit(IDxcTranslationUnit **pResult) {
+  if (pResult == nullptr)
+    return E_POINTER;
+  *pResult = nullptr;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_translationUnit == nullptr)
+    return FAILED(m_status) ? m_status : E_FAIL;
+  return m_translationUnit.CopyTo(pResult);
+}
+
+HRESULT DxcIntelliSenseOperation::GetCodeCompleteResults(
+    IDxcCodeCompleteResults **pResult) {
+  if (pResult == nullptr)
+    return E_POINTER;
+  *pResult = nullptr;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_codeCompleteResults == nullptr)
+    return FAILED(m_status) ? m_status : E_FAIL;
+  return m_codeCompleteResults.CopyTo(pResult);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct DxcTranslationUnitWorker::State {
+  // Arguments used to parse the file again; the index keeps m_index alive.
+  CComPtr<IMalloc> m_pMalloc;
+  CComPtr<IDxcIndex> m_pIndex;
+  CXIndex m_index;
+  std::string m_fileName;
+  std::vector<std::string> m_args;
+  unsigned m_options;
+  std::weak_ptr<DxcTranslationUnitWorker> m_owner;
+
+  // Guarded by m_mutex.
+  std::mutex m_mutex;
+  std::condition_variable m_wakeup;
+  std::deque<CComPtr<DxcIntelliSenseOperation>> m_queue;
+  DxcIntelliSenseOperation *m_running = nullptr;
+  bool m_stopping = false;
+
+  // Only used on the worker thread. Code completion runs against a
+  // translation unit of its own so that it never touches a translation unit
+  // the caller may be using concurrently.
+  CXTranslationUnit m_completionTU = nullptr;
+  unsigned m_reparseCount = 0;
+  unsigned m_completionReparseCount = 0;
+
+  ~State() {
+    if (m_completionTU != nullptr)
+      DisposeTranslationUnit(m_completionTU);
+  }
+};
+
+DxcTranslationUnitWorker::DxcTranslationUnitWorker(
+    IMalloc *pMalloc, IDxcIndex *pIndex, CXIndex index,
+    const char *sourceFileName, const char *const *commandLineArgs,
+    int numArgs, unsigned options)
+    : m_state(std::make_shared<State>()) {
+  m_state->m_pMalloc = pMalloc;
+  m_state->m_pIndex = pIndex;
+  m_state->m_index = index;
+  if (sourceFileName != nullptr)
+    m_state->m_fileName = sourceFileName;
+  m_state->m_args.assign(commandLineArgs, commandLineArgs + numArgs);
+  m_state->m_options = options;
+}
+
+DxcTranslationUnitWorker::~DxcTranslationUnitWorker() {
+  std::deque<CComPtr<DxcIntelliSenseOperation>> pending;
+  {
+    std::lock_guard<std::mutex> lock(m_state->m_mutex);
+    m_state->m_stopping = true;
+    pending.swap(m_state->m_queue);
+    if (m_state->m_running != nullptr)
+      m_state->m_running->Cancel();
+  }
+  m_state->m_wakeup.notify_one();
+  for (DxcIntelliSenseOperation *op : pending)
+    op->Cancel();
+
+  if (m_thread.joinable()) {
+    // The last translation unit of the lineage may be released by the worker
+    // itself, when it discards the result of a cancelled reparse.
+    if (m_thread.get_id() == std::this_thread::get_id())
+      m_thread.detach();
+    else
+      m_thread.join();
+  }
+}
+
+HRESULT
+DxcTranslationUnitWorker::Enqueue(DxcIntelliSenseOperation *pOperation) {
+  // Superseded operations are released after the lock.
+  std::vector<CComPtr<DxcIntelliSenseOperation>> superseded;
+  std::lock_guard<std::mutex> lock(m_state->m_mutex);
+  try {
+    if (!m_thread.joinable()) {
+      m_state->m_owner = shared_from_this();
+      m_thread = std::thread(Run, m_state);
+    }
+
+    auto &queue = m_state->m_queue;
+    for (auto it = queue.begin(); it != queue.end();) {
+      if ((*it)->m_kind == pOperation->m_kind) {
+        (*it)->Cancel();
+        superseded.push_back(*it);
+        it = queue.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    DxcIntelliSenseOperation *running = m_state->m_running;
+    if (running != nullptr && running->m_kind == pOperation->m_kind)
+      running->Cancel();
+
+    queue.push_back(pOperation);
+  }
+  CATCH_CPP_RETURN_HRESULT();
+  m_state->m_wakeup.notify_one();
+  return S_OK;
+}
+
+void DxcTranslationUnitWorker::Run(std::shared_ptr<State> state) {
+  DxcThreadMalloc TM(state->m_pMalloc);
+  // Release the state before the thread malloc is restored.
+  std::shared_ptr<State> localState(std::move(state));
+  for (;;) {
+    CComPtr<DxcIntelliSenseOperation> op;
+    {
+      std::unique_lock<std::mutex> lock(localState->m_mutex);
+      localState->m_wakeup.wait(lock, [&] {
+        return localState->m_stopping || !localState->m_queue.empty();
+      });
+      if (localState->m_stopping)
+        break;
+      op = localState->m_queue.front();
+      localState->m_queue.pop_front();
+      localState->m_running = op;
+    }
+
+    Execute(*localState, op);
+
+    {
+      std::lock_guard<std::mutex> lock(localState->m_mutex);
+      localState->m_running = nullptr;
+    }
+  }
+}
+
+void DxcTranslationUnitWorker::Execute(State &state,
+                                       DxcIntelliSenseOperation *pOperation) {
+  if (pOperation->IsCancelled())
+    return;
+
+  HRESULT hr = S_OK;
+  CComPtr<IDxcTranslationUnit> tu;
+  CComPtr<IDxcCodeCompleteResults> results;
+  try {
+    // TODO: until an interface to file access is defined and implemented,
+    // simply fall back to pure Win32/CRT calls.
+    ::llvm::sys::fs::MSFileSystem *msfPtr;
+    IFT(CreateMSFileSystemForDisk(&msfPtr));
+    std::unique_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
+
+    ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
+    IFTLLVM(pts.error_code());
+
+    std::vector<const char *> args;
+    for (const std::string &arg : state.m_args)
+      args.push_back(arg.c_str());
+    std::vector<IDxcUnsavedFile *> unsavedFiles(
+        pOperation->m_unsavedFiles.begin(), pOperation->m_unsavedFiles.end());
+    unsigned numUnsavedFiles = unsavedFiles.size();
+    CXUnsavedFile *files;
+    IFT(SetupUnsavedFiles(unsavedFiles.data(), numUnsavedFiles, &files));
+
+    if (pOperation->m_kind == DxcIntelliSenseOperation::Kind::Reparse) {
+      // Parse into a new translation unit, so the caller can keep using the
+      // current one until the new one is ready.
+      CXTranslationUnit cxtu = clang_parseTranslationUnit(
+          state.m_index, state.m_fileName.c_str(), args.data(),
+          (int)args.size(), files, numUnsavedFiles, state.m_options);
+      CComPtr<DxcTranslationUnit> localTU;
+      if (cxtu == nullptr) {
+        hr = E_FAIL;
+      } else if ((localTU = DxcTranslationUnit::Alloc(
+                      DxcGetThreadMallocNoRef())) == nullptr) {
+        clang_disposeTranslationUnit(cxtu);
+        hr = E_OUTOFMEMORY;
+      } else {
+        localTU->Initialize(cxtu, state.m_owner.lock());
+        ++state.m_reparseCount;
+        tu = localTU.p;
+      }
+    } else {
+      // Cached global completion results are computed when parsing, so bring
+      // them up to date with the latest reparse.
+      if (state.m_completionTU != nullptr &&
+          state.m_completionReparseCount != state.m_reparseCount &&
+          (state.m_options & CXTranslationUnit_CacheCompletionResults)) {
+        if (clang_reparseTranslationUnit(
+                state.m_completionTU, numUnsavedFiles, files,
+                clang_defaultReparseOptions(state.m_completionTU)) != 0) {
+          clang_disposeTranslationUnit(state.m_completionTU);
+          state.m_completionTU = nullptr;
+        }
+        state.m_completionReparseCount = state.m_reparseCount;
+      }
+      if (state.m_completionTU == nullptr) {
+        state.m_completionTU = clang_parseTranslationUnit(
+            state.m_index, state.m_fileName.c_str(), args.data(),
+            (int)args.size(), files, numUnsavedFiles, state.m_options);
+        state.m_completionReparseCount = state.m_reparseCount;
+      }
+
+      CXCodeCompleteResults *ccr = nullptr;
+      if (state.m_completionTU != nullptr)
+        ccr = clang_codeCompleteAt(state.m_completionTU,
+                                   pOperation->m_fileName.c_str(),
+                                   pOperation->m_line, pOperation->m_column,
+                                   files, numUnsavedFiles,
+                                   pOperation->m_options);
+      CComPtr<DxcCodeCompleteResults> localResults;
+      if (ccr == nullptr) {
+        hr = E_FAIL;
+      } else if ((localResults = DxcCodeCompleteResults::Alloc(
+                      DxcGetThreadMallocNoRef())) == nullptr) {
+        clang_disposeCodeCompleteResults(ccr);
+        hr = E_OUTOFMEMORY;
+      } else {
+        localResults->Initialize(ccr);
+        results = localResults.p;
+      }
+    }
+
+    CleanupUnsavedFiles(files, numUnsavedFiles);
+  }
+  CATCH_CPP_ASSIGN_HRESULT();
+
+  pOperation->Complete(hr, tu, results);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 HRESULT DxcType::Create(const CXType &type, IDxcType **pObject) {
@@ -1986,6 +2354,8 @@ C_ASSERT((int)DxcCursor_LastExtraDecl == (int)CXCursor_LastExtraDecl);
 
 C_ASSERT((int)DxcTranslationUnitFlags_UseCallerThread ==
          (int)CXTranslationUnit_UseCallerThread);
+C_ASSERT((int)DxcTranslationUnitFlags_SkipPreambleFunctionBodies ==
+         (int)CXTranslationUnit_SkipPreambleFunctionBodies);
 
 C_ASSERT((int)DxcCodeCompleteFlags_IncludeMacros ==
          (int)CXCodeComplete_IncludeMacros);
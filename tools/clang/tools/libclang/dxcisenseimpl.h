@@ -20,6 +20,12 @@
 #include "clang-c/Index.h"
 #include "clang/AST/Decl.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Forward declarations.
 class DxcCursor;
@@ -27,9 +33,11 @@ class DxcDiagnostic;
 class DxcFile;
 class DxcIndex;
 class DxcIntelliSense;
+class DxcIntelliSenseOperation;
 class DxcSourceLocation;
 class DxcSourceRange;
 class DxcTranslationUnit;
+class DxcTranslationUnitWorker;
 class DxcToken;
 struct IMalloc;
 
@@ -315,22 +323,28 @@ public:
   HRESULT STDMETHODCALLTYPE GetSpelling(LPSTR *pValue) override;
 };
 
-class DxcTranslationUnit : public IDxcTranslationUnit {
+class DxcTranslationUnit : public IDxcTranslationUnit2 {
 private:
   DXC_MICROCOM_TM_REF_FIELDS()
   CXTranslationUnit m_tu;
+  std::shared_ptr<DxcTranslationUnitWorker> m_worker;
+
+  HRESULT Enqueue(DxcIntelliSenseOperation *pOperation,
+                  IDxcIntelliSenseOperation **ppOperation);
 
 public:
   DXC_MICROCOM_TM_ADDREF_RELEASE_IMPL()
   DXC_MICROCOM_TM_ALLOC(DxcTranslationUnit)
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
                                            void **ppvObject) override {
-    return DoBasicQueryInterface<IDxcTranslationUnit>(this, iid, ppvObject);
+    return DoBasicQueryInterface<IDxcTranslationUnit, IDxcTranslationUnit2>(
+        this, iid, ppvObject);
   }
 
   DxcTranslationUnit(IMalloc *pMalloc);
   ~DxcTranslationUnit();
-  void Initialize(CXTranslationUnit tu);
+  void Initialize(CXTranslationUnit tu,
+                  std::shared_ptr<DxcTranslationUnitWorker> worker);
 
   HRESULT STDMETHODCALLTYPE GetCursor(IDxcCursor **pCursor) override;
   HRESULT STDMETHODCALLTYPE Tokenize(IDxcSourceRange *range,
@@ -365,6 +379,85 @@ public:
       const char *fileName, unsigned line, unsigned column,
       IDxcUnsavedFile **pUnsavedFiles, unsigned numUnsavedFiles,
       DxcCodeCompleteFlags options, IDxcCodeCompleteResults **pResult) override;
+  HRESULT STDMETHODCALLTYPE
+  ReparseAsync(IDxcUnsavedFile **pUnsavedFiles, unsigned numUnsavedFiles,
+               IDxcIntelliSenseOperation **pOperation) override;
+  HRESULT STDMETHODCALLTYPE CodeCompleteAtAsync(
+      const char *fileName, unsigned line, unsigned column,
+      IDxcUnsavedFile **pUnsavedFiles, unsigned numUnsavedFiles,
+      DxcCodeCompleteFlags options,
+      IDxcIntelliSenseOperation **pOperation) override;
+};
+
+/// <summary>Background operation on the worker of a translation
+/// unit.</summary>
+class DxcIntelliSenseOperation : public IDxcIntelliSenseOperation {
+public:
+  enum class Kind { Reparse, CodeComplete };
+
+private:
+  DXC_MICROCOM_TM_REF_FIELDS()
+  std::mutex m_mutex;
+  std::condition_variable m_completed;
+  HRESULT m_status = E_PENDING;
+  bool m_cancelled = false;
+  CComPtr<IDxcTranslationUnit> m_translationUnit;
+  CComPtr<IDxcCodeCompleteResults> m_codeCompleteResults;
+
+public:
+  // Request parameters, immutable once the operation is queued.
+  Kind m_kind = Kind::Reparse;
+  std::vector<CComPtr<IDxcUnsavedFile>> m_unsavedFiles;
+  std::string m_fileName;
+  unsigned m_line = 0;
+  unsigned m_column = 0;
+  DxcCodeCompleteFlags m_options = DxcCodeCompleteFlags_None;
+
+  DXC_MICROCOM_TM_ADDREF_RELEASE_IMPL()
+  DXC_MICROCOM_TM_CTOR(DxcIntelliSenseOperation)
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+                                           void **ppvObject) override {
+    return DoBasicQueryInterface<IDxcIntelliSenseOperation>(this, iid,
+                                                            ppvObject);
+  }
+
+  bool IsCancelled();
+  /// <summary>Publishes the result unless the operation was
+  /// cancelled.</summary>
+  void Complete(HRESULT status, IDxcTranslationUnit *pTranslationUnit,
+                IDxcCodeCompleteResults *pCodeCompleteResults);
+
+  HRESULT STDMETHODCALLTYPE Cancel() override;
+  HRESULT STDMETHODCALLTYPE Wait() override;
+  HRESULT STDMETHODCALLTYPE GetStatus(HRESULT *pStatus) override;
+  HRESULT STDMETHODCALLTYPE
+  GetTranslationUnit(IDxcTranslationUnit **pResult) override;
+  HRESULT STDMETHODCALLTYPE
+  GetCodeCompleteResults(IDxcCodeCompleteResults **pResult) override;
+};
+
+/// <summary>Parse arguments and worker thread shared by a translation unit and
+/// the translation units produced from it by ReparseAsync.</summary>
+class DxcTranslationUnitWorker
+    : public std::enable_shared_from_this<DxcTranslationUnitWorker> {
+private:
+  struct State;
+  std::shared_ptr<State> m_state;
+  std::thread m_thread;
+
+  static void Run(std::shared_ptr<State> state);
+  static void Execute(State &state, DxcIntelliSenseOperation *pOperation);
+
+public:
+  DxcTranslationUnitWorker(IMalloc *pMalloc, IDxcIndex *pIndex, CXIndex index,
+                           const char *sourceFileName,
+                           const char *const *commandLineArgs, int numArgs,
+                           unsigned options);
+  ~DxcTranslationUnitWorker();
+
+  /// <summary>Queues an operation, cancelling the queued and running
+  /// operations of the same kind. Starts the thread on first use.</summary>
+  HRESULT Enqueue(DxcIntelliSenseOperation *pOperation);
 };
 
 class DxcType : public IDxcType {
@@ -229,6 +229,26 @@ void use_buffer()
   verify(val, load(10));
 }
 
+SHADER_test
+void rematerialize()
+{
+  // Values computed only from constant buffer contents are recomputed after
+  // the continuation, while the loaded values of mixed alignment are saved.
+  int scaled = initialStateId * 2 + 1;
+  bool odd = (scaled & 1) != 0;
+  half hval = load(3);
+  double dval = load(4) + 1e-5;
+  int ival = load(5);
+
+  continuation();
+
+  verify(scaled - initialStateId * 2, 1);
+  verify(odd ? 1 : 0, 1);
+  verify(hval, 3);
+  verify((int)dval, 4);
+  verify(ival, 5);
+}
+
 
 SHADER_test
 void lower_intrinsics()
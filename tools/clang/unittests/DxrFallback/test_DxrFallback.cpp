@@ -748,6 +748,7 @@ int main(int argc, const char *argv[]) {
           {"loop", {-99, 1, 1, -99, -99, -99, -99, 5, 5}},
           {"recursive", {5, 5, 4, 4, 3, 3, 2, 2, 1, 1, 0, 0, 1, 1}},
           {"use_buffer", {-99, 10, 10}},
+          {"rematerialize", {-99, 1, 1, 1, 1, 3, 3, 4, 4, 5, 5}},
           {"lower_intrinsics", {-99, 0, 0}},
           {"local_array", {-99, 4, 4}},
           {"dispatch_idx_and_dims", {0, 0, 1, 1}},
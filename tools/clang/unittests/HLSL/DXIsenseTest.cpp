@@ -106,6 +106,7 @@ protected:
 
   TEST_METHOD(InclusionWhenMissingThenError)
   TEST_METHOD(InclusionWhenValidThenAvailable)
+  TEST_METHOD(InclusionWhenSkipPreambleFunctionBodiesThenBodiesSkipped)
 
   TEST_METHOD(TUWhenGetFileMissingThenFail)
   TEST_METHOD(TUWhenGetFilePresentThenOK)
@@ -115,6 +116,7 @@ protected:
   TEST_METHOD(TUWhenRegionInactiveThenEndIsBeforeEndifHash)
   TEST_METHOD(TUWhenRegionInactiveThenStartIsAtIfdefEol)
   TEST_METHOD(TUWhenUnsaveFileThenOK)
+  TEST_METHOD(TUWhenReparseAsyncThenSnapshotAvailable)
 
   TEST_METHOD(QualifiedNameClass)
   TEST_METHOD(QualifiedNameVariable)
@@ -288,6 +290,61 @@ TEST_F(DXIntellisenseTest, InclusionWhenValidThenAvailable) {
   }
 }
 
+TEST_F(DXIntellisenseTest,
+       InclusionWhenSkipPreambleFunctionBodiesThenBodiesSkipped) {
+  CComPtr<IDxcIntelliSense> isense;
+  CComPtr<IDxcIndex> index;
+  CComPtr<IDxcUnsavedFile> unsaved[2];
+  // The header body has an error that is only reported when it is parsed;
+  // the main file body has one that must always be reported.
+  const char main_text[] = "#include \"inc.h\"\r\n"
+                           "float4 main() : SV_Target {\r\n"
+                           "  return Helper() + MainMissing;\r\n"
+                           "}";
+  const char unsaved_text[] = "float Helper() { return HeaderMissing; }";
+  VERIFY_SUCCEEDED(
+      CompilationResult::DefaultHlslSupport->CreateIntellisense(&isense));
+  VERIFY_SUCCEEDED(isense->CreateIndex(&index));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile(
+      "./inc.h", unsaved_text, strlen(unsaved_text), &unsaved[0]));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile("file.hlsl", main_text,
+                                             strlen(main_text), &unsaved[1]));
+
+  auto GetDiagCount = [&](IDxcTranslationUnit *TU) {
+    unsigned diagCount;
+    VERIFY_SUCCEEDED(TU->GetNumDiagnostics(&diagCount));
+    return diagCount;
+  };
+
+  CComPtr<IDxcTranslationUnit> FullTU;
+  VERIFY_SUCCEEDED(index->ParseTranslationUnit(
+      "file.hlsl", nullptr, 0, &unsaved[0].p, 2,
+      DxcTranslationUnitFlags_UseCallerThread, &FullTU));
+  VERIFY_ARE_EQUAL(2U, GetDiagCount(FullTU));
+
+  // The default editing options do not skip any body.
+  DxcTranslationUnitFlags editingOptions;
+  VERIFY_SUCCEEDED(isense->GetDefaultEditingTUOptions(&editingOptions));
+  CComPtr<IDxcTranslationUnit> EditingTU;
+  VERIFY_SUCCEEDED(index->ParseTranslationUnit("file.hlsl", nullptr, 0,
+                                               &unsaved[0].p, 2,
+                                               editingOptions, &EditingTU));
+  VERIFY_ARE_EQUAL(2U, GetDiagCount(EditingTU));
+
+  CComPtr<IDxcTranslationUnit> TU;
+  VERIFY_SUCCEEDED(index->ParseTranslationUnit(
+      "file.hlsl", nullptr, 0, &unsaved[0].p, 2,
+      (DxcTranslationUnitFlags)(
+          DxcTranslationUnitFlags_UseCallerThread |
+          DxcTranslationUnitFlags_SkipPreambleFunctionBodies),
+      &TU));
+  VERIFY_ARE_EQUAL(1U, GetDiagCount(TU));
+
+  // Reparsing keeps skipping the preamble bodies.
+  VERIFY_SUCCEEDED(TU->Reparse(&unsaved[0].p, 2));
+  VERIFY_ARE_EQUAL(1U, GetDiagCount(TU));
+}
+
 TEST_F(DXIntellisenseTest, TUWhenGetFileMissingThenFail) {
   const char program[] = "int i;";
   CompilationResult result =
@@ -522,6 +579,70 @@ TEST_F(DXIntellisenseTest, TUWhenUnsaveFileThenOK) {
   }
 }
 
+TEST_F(DXIntellisenseTest, TUWhenReparseAsyncThenSnapshotAvailable) {
+  const char fileName[] = "file.hlsl";
+  const char broken_text[] = "float4 main() : SV_Target { return Missing; }";
+  const char fixed_text[] = "struct MyStruct {};\r\n"
+                            "float4 main() : SV_Target { return 0; }";
+  const char completion_text[] = "struct MyStruct {};\r\n"
+                                 "MyStr";
+  CComPtr<IDxcIntelliSense> isense;
+  CComPtr<IDxcIndex> index;
+  CComPtr<IDxcUnsavedFile> broken, fixed, completing;
+  VERIFY_SUCCEEDED(
+      CompilationResult::DefaultHlslSupport->CreateIntellisense(&isense));
+  VERIFY_SUCCEEDED(isense->CreateIndex(&index));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile(fileName, broken_text,
+                                             strlen(broken_text), &broken));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile(fileName, fixed_text,
+                                             strlen(fixed_text), &fixed));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile(
+      fileName, completion_text, strlen(completion_text), &completing));
+
+  CComPtr<IDxcTranslationUnit> TU;
+  VERIFY_SUCCEEDED(index->ParseTranslationUnit(
+      fileName, nullptr, 0, &broken.p, 1,
+      DxcTranslationUnitFlags_UseCallerThread, &TU));
+  CComPtr<IDxcTranslationUnit2> TU2;
+  VERIFY_SUCCEEDED(TU.QueryInterface(&TU2));
+
+  // The second edit cancels the first one unless it has already completed.
+  CComPtr<IDxcIntelliSenseOperation> staleOp, reparseOp;
+  VERIFY_SUCCEEDED(TU2->ReparseAsync(&broken.p, 1, &staleOp));
+  VERIFY_SUCCEEDED(TU2->ReparseAsync(&fixed.p, 1, &reparseOp));
+  VERIFY_SUCCEEDED(staleOp->Wait());
+  VERIFY_SUCCEEDED(reparseOp->Wait());
+  HRESULT status;
+  VERIFY_SUCCEEDED(staleOp->GetStatus(&status));
+  VERIFY_IS_TRUE(status == E_ABORT || status == S_OK);
+  VERIFY_SUCCEEDED(reparseOp->GetStatus(&status));
+  VERIFY_SUCCEEDED(status);
+
+  // The original translation unit is left unchanged.
+  CComPtr<IDxcTranslationUnit> snapshot;
+  VERIFY_SUCCEEDED(reparseOp->GetTranslationUnit(&snapshot));
+  unsigned diagCount;
+  VERIFY_SUCCEEDED(TU->GetNumDiagnostics(&diagCount));
+  VERIFY_ARE_EQUAL(1U, diagCount);
+  VERIFY_SUCCEEDED(snapshot->GetNumDiagnostics(&diagCount));
+  VERIFY_ARE_EQUAL(0U, diagCount);
+
+  CComPtr<IDxcTranslationUnit2> snapshot2;
+  VERIFY_SUCCEEDED(snapshot.QueryInterface(&snapshot2));
+  CComPtr<IDxcIntelliSenseOperation> completeOp;
+  VERIFY_SUCCEEDED(snapshot2->CodeCompleteAtAsync(
+      fileName, 2, 1, &completing.p, 1, DxcCodeCompleteFlags_None,
+      &completeOp));
+  VERIFY_SUCCEEDED(completeOp->Wait());
+  VERIFY_SUCCEEDED(completeOp->GetStatus(&status));
+  VERIFY_SUCCEEDED(status);
+  CComPtr<IDxcCodeCompleteResults> codeCompleteResults;
+  VERIFY_SUCCEEDED(completeOp->GetCodeCompleteResults(&codeCompleteResults));
+  unsigned numResults;
+  VERIFY_SUCCEEDED(codeCompleteResults->GetNumResults(&numResults));
+  VERIFY_IS_GREATER_THAN_OR_EQUAL(numResults, 1u);
+}
+
 TEST_F(DXIntellisenseTest, QualifiedNameClass) {
   char program[] = "class TheClass {\r\n"
                    "};\r\n"
@@ -54,8 +54,10 @@
 #include "dxc/Support/Global.h"
 #include "dxc/Support/dxcapi.use.h"
 #include "dxc/Support/HLSLOptions.h"
+#include "dxc/DxilCompression/DxilCompressionHelpers.h"
 #include "dxc/DxilContainer/DxilContainer.h"
 #include "dxc/DxilContainer/DxilRuntimeReflection.h"
+#include "dxc/DxilHash/DxilHash.h"
 #include <assert.h> // Needed for DxilPipelineStateValidation.h
 #include "dxc/DxilContainer/DxilPipelineStateValidation.h"
 #include "dxc/DXIL/DxilShaderFlags.h"
@@ -104,6 +106,7 @@ public:
   TEST_METHOD(CompileWhenOkThenCheckRDAT)
   TEST_METHOD(CompileWhenOkThenCheckRDAT2)
   TEST_METHOD(CompileWhenOkThenCheckRDATSM69)
+  TEST_METHOD(CompileWhenOkThenCheckRDATNameIndex)
   TEST_METHOD(CompileWhenOkThenCheckReflection1)
   TEST_METHOD(DxcUtils_CreateReflection)
   TEST_METHOD(CheckReflectionQueryInterface)
@@ -118,6 +121,11 @@ public:
   TEST_METHOD(DxilContainerUnitTest)
   TEST_METHOD(DxilContainerCompilerVersionTest)
   TEST_METHOD(ContainerBuilder_AddPrivateForceLast)
+  TEST_METHOD(ContainerBuilder_UntouchedPartsAreCopied)
+  TEST_METHOD(ZlibCompressParallel_RoundTrip)
+  BEGIN_TEST_METHOD(ZlibCompressParallel_Benchmark)
+  TEST_METHOD_PROPERTY(L"Priority", L"1")
+  END_TEST_METHOD()
 
   TEST_METHOD(ReflectionMatchesDXBC_CheckIn)
   BEGIN_TEST_METHOD(ReflectionMatchesDXBC_Full)
@@ -873,6 +881,82 @@ TEST_F(DxilContainerTest, ContainerBuilder_AddPrivateForceLast) {
   VerifyPrivateLast(pNewContainer);
 }
 
+TEST_F(DxilContainerTest, ContainerBuilder_UntouchedPartsAreCopied) {
+  const char *shader = "float4 main() : SV_Target { return 1; }";
+  LPCWSTR args[] = {L"-Zi", L"-Qembed_debug"};
+  CComPtr<IDxcBlob> pProgram;
+  CompileToProgram(shader, L"main", L"ps_6_0", args, _countof(args),
+                   &pProgram);
+  const hlsl::DxilContainerHeader *pOrigHeader =
+      (const hlsl::DxilContainerHeader *)pProgram->GetBufferPointer();
+
+  auto Serialize = [&](IDxcContainerBuilder *pBuilder, IDxcBlob **ppBlob) {
+    CComPtr<IDxcOperationResult> pResult;
+    HRESULT status;
+    VERIFY_SUCCEEDED(pBuilder->SerializeContainer(&pResult));
+    VERIFY_SUCCEEDED(pResult->GetStatus(&status));
+    VERIFY_SUCCEEDED(status);
+    VERIFY_SUCCEEDED(pResult->GetResult(ppBlob));
+  };
+
+  // Without edits, the container must come back unchanged, hash included.
+  CComPtr<IDxcContainerBuilder> pBuilder;
+  CComPtr<IDxcBlob> pSame;
+  VERIFY_SUCCEEDED(
+      m_dllSupport.CreateInstance(CLSID_DxcContainerBuilder, &pBuilder));
+  VERIFY_SUCCEEDED(pBuilder->Load(pProgram));
+  Serialize(pBuilder, &pSame);
+  VERIFY_ARE_EQUAL(pProgram->GetBufferSize(), pSame->GetBufferSize());
+  VERIFY_ARE_EQUAL(0, memcmp(pProgram->GetBufferPointer(),
+                             pSame->GetBufferPointer(),
+                             pProgram->GetBufferSize()));
+
+  // Strip the debug part from the middle of the container and append private
+  // data; every remaining part must be copied byte for byte and the hash
+  // must cover the new layout.
+  std::string data("private");
+  CComPtr<IDxcBlobEncoding> pPrivateData;
+  CreateBlobFromText(data.c_str(), &pPrivateData);
+  CComPtr<IDxcBlob> pEdited;
+  pBuilder.Release();
+  VERIFY_SUCCEEDED(
+      m_dllSupport.CreateInstance(CLSID_DxcContainerBuilder, &pBuilder));
+  VERIFY_SUCCEEDED(pBuilder->Load(pProgram));
+  VERIFY_SUCCEEDED(pBuilder->RemovePart(hlsl::DFCC_ShaderDebugInfoDXIL));
+  VERIFY_SUCCEEDED(pBuilder->AddPart(hlsl::DFCC_PrivateData, pPrivateData));
+  Serialize(pBuilder, &pEdited);
+
+  const hlsl::DxilContainerHeader *pEditedHeader = hlsl::IsDxilContainerLike(
+      pEdited->GetBufferPointer(), pEdited->GetBufferSize());
+  VERIFY_IS_NOT_NULL(pEditedHeader);
+  VERIFY_IS_TRUE(
+      hlsl::IsValidDxilContainer(pEditedHeader, pEdited->GetBufferSize()));
+  VERIFY_ARE_EQUAL(pOrigHeader->PartCount, pEditedHeader->PartCount);
+  for (auto it = hlsl::begin(pEditedHeader), itEnd = hlsl::end(pEditedHeader);
+       it != itEnd; ++it) {
+    const hlsl::DxilPartHeader *pPart = *it;
+    if (pPart->PartFourCC == hlsl::DFCC_PrivateData) {
+      VERIFY_ARE_EQUAL(pPrivateData->GetBufferSize(), pPart->PartSize);
+      continue;
+    }
+    VERIFY_ARE_NOT_EQUAL((uint32_t)hlsl::DFCC_ShaderDebugInfoDXIL,
+                         pPart->PartFourCC);
+    const hlsl::DxilPartHeader *pOrigPart =
+        hlsl::GetDxilPartByType(pOrigHeader, pPart->PartFourCC);
+    VERIFY_IS_NOT_NULL(pOrigPart);
+    VERIFY_ARE_EQUAL(pOrigPart->PartSize, pPart->PartSize);
+    VERIFY_ARE_EQUAL(0, memcmp(hlsl::GetDxilPartData(pOrigPart),
+                               hlsl::GetDxilPartData(pPart), pPart->PartSize));
+  }
+
+  const uint32_t hashOffset = offsetof(hlsl::DxilContainerHeader, Version);
+  BYTE digest[DXIL_CONTAINER_HASH_SIZE];
+  ComputeHashRetail((const BYTE *)pEditedHeader + hashOffset,
+                    pEditedHeader->ContainerSizeInBytes - hashOffset, digest);
+  VERIFY_ARE_EQUAL(0, memcmp(digest, pEditedHeader->Hash.Digest,
+                             DXIL_CONTAINER_HASH_SIZE));
+}
+
 TEST_F(DxilContainerTest, CompileWhenOKThenIncludesSignatures) {
   char program[] =
       "struct PSInput {\r\n"
@@ -1726,6 +1810,73 @@ TEST_F(DxilContainerTest, CompileWhenOkThenCheckRDATSM69) {
   IFTBOOLMSG(blobFound, E_FAIL, "failed to find RDAT blob after compiling");
 }
 
+TEST_F(DxilContainerTest, CompileWhenOkThenCheckRDATNameIndex) {
+  if (m_ver.SkipDxilVersion(1, 9))
+    return;
+  const char *shader =
+      "GlobalRootSignature grs = {\"CBV(b0)\"};"
+      "RWByteAddressBuffer b_buf;"
+      "export float function0(float x) { return x + 1; }"
+      "export float function1(float x) { return x * 2; }"
+      "export float function1(int x) { return x * 3; }"
+      "[shader(\"raygeneration\")]"
+      "void RayGenMain() { b_buf.Store(0, function0(1) + function1(2)); }";
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcOperationResult> pResult;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText(shader, &pSource);
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"hlsl.hlsl", L"main",
+                                      L"lib_6_9", nullptr, 0, nullptr, 0,
+                                      nullptr, &pResult));
+  HRESULT hrStatus;
+  VERIFY_SUCCEEDED(pResult->GetStatus(&hrStatus));
+  VERIFY_SUCCEEDED(hrStatus);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+
+  const hlsl::DxilContainerHeader *pContainer = hlsl::IsDxilContainerLike(
+      pProgram->GetBufferPointer(), pProgram->GetBufferSize());
+  VERIFY_IS_NOT_NULL(pContainer);
+  const hlsl::DxilPartHeader *pPart =
+      hlsl::GetDxilPartByType(pContainer, hlsl::DxilFourCC::DFCC_RuntimeData);
+  VERIFY_IS_NOT_NULL(pPart);
+
+  using namespace hlsl::RDAT;
+  DxilRuntimeData context;
+  VERIFY_IS_TRUE(
+      context.InitFromRDAT(hlsl::GetDxilPartData(pPart), pPart->PartSize));
+  VERIFY_IS_TRUE(context.Validate());
+
+  // Every name must resolve through the index to the same record a scan of
+  // the table finds first.
+  const NameIndexReader &nameIndex = context.GetContext().NameIndex;
+  VERIFY_IS_TRUE(nameIndex.Indexes(RuntimeDataPartType::FunctionTable));
+  VERIFY_IS_TRUE(nameIndex.Indexes(RuntimeDataPartType::SubobjectTable));
+  auto funcTable = context.GetFunctionTable();
+  for (uint32_t i = 0; i < funcTable.Count(); ++i) {
+    for (const char *name :
+         {funcTable[i].getName(), funcTable[i].getUnmangledName()}) {
+      uint32_t first = 0;
+      while (!RecordNameMatches(funcTable[first], name))
+        first++;
+      auto found = funcTable.FindByName(name);
+      VERIFY_IS_TRUE(found);
+      VERIFY_ARE_EQUAL_STR(found.getName(), funcTable[first].getName());
+    }
+  }
+  VERIFY_IS_TRUE(funcTable.FindByName("RayGenMain").getShaderKind() ==
+                 hlsl::DXIL::ShaderKind::RayGeneration);
+  VERIFY_IS_FALSE(funcTable.FindByName("function2"));
+
+  auto subobjectTable = context.GetSubobjectTable();
+  VERIFY_ARE_EQUAL(subobjectTable.Count(), 1U);
+  VERIFY_IS_TRUE(subobjectTable.FindByName("grs").getKind() ==
+                 hlsl::DXIL::SubobjectKind::GlobalRootSignature);
+  VERIFY_IS_FALSE(subobjectTable.FindByName("function0"));
+}
+
 TEST_F(DxilContainerTest, CompileWhenOkThenCheckRDAT2) {
   if (m_ver.SkipDxilVersion(1, 3))
     return;
@@ -3013,6 +3164,84 @@ TEST_F(DxilContainerTest, DxilContainerCompilerVersionTest) {
   }
 }
 
+// Builds a compressible buffer that looks roughly like the source and debug
+// data that ends up in PDB parts.
+static std::vector<uint8_t> CreateCompressionTestData(size_t size) {
+  static const char Text[] =
+      "float4 main(float4 pos : SV_Position) : SV_Target {\n"
+      "  return tex.Sample(samp, pos.xy * scale) + bias;\n"
+      "}\n";
+  std::vector<uint8_t> data(size);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = Text[i % (sizeof(Text) - 1)] ^ ((seed >> 16) % 61 == 0);
+  }
+  return data;
+}
+
+TEST_F(DxilContainerTest, ZlibCompressParallel_RoundTrip) {
+  CComPtr<IMalloc> pMalloc;
+  VERIFY_SUCCEEDED(DxcCoGetMalloc(1, &pMalloc));
+
+  // Cover the serial fallback, an exact multiple of the block size and a
+  // partial last block.
+  const size_t sizes[] = {1000, 4 * hlsl::ZlibParallelBlockSize,
+                          5 * hlsl::ZlibParallelBlockSize + 1234};
+  for (size_t size : sizes) {
+    std::vector<uint8_t> data = CreateCompressionTestData(size);
+
+    std::vector<uint8_t> compressed;
+    VERIFY_ARE_EQUAL(hlsl::ZlibResult::Success,
+                     hlsl::ZlibCompressAppend(pMalloc, data.data(), size,
+                                              compressed, /*bParallel*/ true));
+
+    std::vector<uint8_t> decompressed(size);
+    VERIFY_ARE_EQUAL(hlsl::ZlibResult::Success,
+                     hlsl::ZlibDecompress(pMalloc, compressed.data(),
+                                          compressed.size(),
+                                          decompressed.data(), size));
+    VERIFY_IS_TRUE(data == decompressed);
+
+    // The output must not depend on how many threads did the work.
+    std::vector<uint8_t> singleThreaded;
+    size_t singleThreadedSize = 0;
+    VERIFY_ARE_EQUAL(
+        hlsl::ZlibResult::Success,
+        hlsl::ZlibCompressParallel(
+            pMalloc, data.data(), size, &singleThreaded,
+            [](void *pUserData, size_t requiredSize) -> void * {
+              auto *pBuffer = (std::vector<uint8_t> *)pUserData;
+              pBuffer->resize(requiredSize);
+              return pBuffer->data();
+            },
+            &singleThreadedSize, /*NumThreads*/ 1));
+    singleThreaded.resize(singleThreadedSize);
+    VERIFY_IS_TRUE(compressed == singleThreaded);
+  }
+}
+
+TEST_F(DxilContainerTest, ZlibCompressParallel_Benchmark) {
+  CComPtr<IMalloc> pMalloc;
+  VERIFY_SUCCEEDED(DxcCoGetMalloc(1, &pMalloc));
+
+  const size_t size = 64 * 1024 * 1024;
+  std::vector<uint8_t> data = CreateCompressionTestData(size);
+
+  for (bool bParallel : {false, true}) {
+    std::vector<uint8_t> compressed;
+    auto start = std::chrono::steady_clock::now();
+    VERIFY_ARE_EQUAL(hlsl::ZlibResult::Success,
+                     hlsl::ZlibCompressAppend(pMalloc, data.data(), size,
+                                              compressed, bParallel));
+    auto end = std::chrono::steady_clock::now();
+    auto dur =
+        std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    LogCommentFmt(L"%s: %u bytes in %u ms", bParallel ? L"parallel" : L"serial",
+                  (unsigned)compressed.size(), (unsigned)dur.count());
+  }
+}
+
 TEST_F(DxilContainerTest, DxilContainerUnitTest) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcBlobEncoding> pSource;
@@ -27,6 +27,8 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Regex.h"
 
+#include <thread>
+
 using namespace hlsl;
 using namespace llvm;
 
@@ -73,6 +75,10 @@ public:
 
   TEST_METHOD(CanonicalSystemValueSemantic)
 
+  // Deferred metadata loading tests.
+  TEST_METHOD(DeferredTypeSystemAfterErase)
+  TEST_METHOD(DeferredMetadataConcurrentLoad)
+
   void VerifyValidatorVersionFails(LPCWSTR shaderModel,
                                    const std::vector<LPCWSTR> &arguments,
                                    const std::vector<LPCSTR> &expectedErrors);
@@ -640,3 +646,71 @@ TEST_F(DxilModuleTest, CanonicalSystemValueSemantic) {
                      1, 4, 0, 0, 0, {0});
   VERIFY_ARE_EQUAL_STR("SV_Position", newElt->GetSemanticName().data());
 }
+
+static const char DeferredMetadataLib[] =
+    "struct S { float4 a; int b; };\n"
+    "RWStructuredBuffer<S> Buf;\n"
+    "GlobalRootSignature grs = { \"CBV(b0)\" };\n"
+    "export void first() { Buf[0].b = 1; }\n"
+    "export void second() { Buf[1].a = 2; }\n";
+
+TEST_F(DxilModuleTest, DeferredTypeSystemAfterErase) {
+  Compiler c(m_dllSupport);
+  if (c.SkipDxil_Test(1, 3))
+    return;
+  c.Compile(DeferredMetadataLib, L"lib_6_3");
+
+  size_t NumAnnotations =
+      c.GetDxilModule().GetTypeSystem().GetFunctionAnnotationMap().size();
+
+  // Reload, and erase a function before its annotation has been parsed.
+  DxilModule &DM = c.GetDxilModule();
+  Function *First = DM.GetModule()->getFunction("\01?first@@YAXXZ");
+  Function *Second = DM.GetModule()->getFunction("\01?second@@YAXXZ");
+  VERIFY_IS_NOT_NULL(First);
+  VERIFY_IS_NOT_NULL(Second);
+  First->eraseFromParent();
+
+  DxilTypeSystem &DTS = DM.GetTypeSystem();
+  VERIFY_ARE_EQUAL(NumAnnotations - 1, DTS.GetFunctionAnnotationMap().size());
+  VERIFY_IS_NOT_NULL(DTS.GetFunctionAnnotation(Second));
+  VERIFY_IS_FALSE(DM.HasMetadataErrors());
+}
+
+TEST_F(DxilModuleTest, DeferredMetadataConcurrentLoad) {
+  Compiler c(m_dllSupport);
+  if (c.SkipDxil_Test(1, 3))
+    return;
+  c.Compile(DeferredMetadataLib, L"lib_6_3");
+
+  // Const readers on several threads all trigger the deferred loads.
+  const DxilModule &DM = c.GetDxilModule();
+  const Function *Second = DM.GetModule()->getFunction("\01?second@@YAXXZ");
+  VERIFY_IS_NOT_NULL(Second);
+  struct Seen {
+    size_t NumStructs = 0;
+    bool HasFunction = false;
+    size_t NumSubobjects = 0;
+  };
+  std::vector<Seen> Results(4);
+  std::vector<std::thread> Threads;
+  for (Seen &Result : Results) {
+    Threads.emplace_back([&DM, Second, &Result] {
+      const DxilTypeSystem &DTS = DM.GetTypeSystem();
+      Result.NumStructs = DTS.GetStructAnnotationMap().size();
+      Result.HasFunction = DTS.GetFunctionAnnotation(Second) != nullptr;
+      if (const DxilSubobjects *Subobjects = DM.GetSubobjects())
+        Result.NumSubobjects = Subobjects->GetSubobjects().size();
+    });
+  }
+  for (std::thread &Thread : Threads)
+    Thread.join();
+
+  size_t NumStructs = DM.GetTypeSystem().GetStructAnnotationMap().size();
+  VERIFY_IS_TRUE(NumStructs > 0);
+  for (const Seen &Result : Results) {
+    VERIFY_ARE_EQUAL(NumStructs, Result.NumStructs);
+    VERIFY_IS_TRUE(Result.HasFunction);
+    VERIFY_ARE_EQUAL(1u, Result.NumSubobjects);
+  }
+}
@@ -49,6 +49,8 @@ public:
   TEST_METHOD(RunLinkFailNoDefine)
   TEST_METHOD(RunLinkFailReDefine)
   TEST_METHOD(RunLinkGlobalInit)
+  TEST_METHOD(RunLinkGlobalInitTwiceWithDebugInfo)
+  TEST_METHOD(RunLinkFailDebugInfoWithoutDxil)
   TEST_METHOD(RunLinkNoAlloca)
   TEST_METHOD(RunLinkMatArrayParam)
   TEST_METHOD(RunLinkMatParam)
@@ -435,6 +437,49 @@ TEST_F(LinkerTest, RunLinkGlobalInit) {
        {"dx.op.cbufferLoad"}, {});
 }
 
+TEST_F(LinkerTest, RunLinkGlobalInitTwiceWithDebugInfo) {
+  // The library is linked from its debug module. Linking it again reuses the
+  // function table and used globals collected by the first link, so the
+  // static initializer must still be found.
+  LPCWSTR option[] = {L"-Zi", L"-Qembed_debug"};
+  CComPtr<IDxcBlob> pEntryLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_global.hlsl", &pEntryLib, option,
+             L"lib_6_3");
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+
+  LPCWSTR libName = L"entry";
+  RegisterDxcModule(libName, pEntryLib, pLinker);
+
+  Link(L"test", L"ps_6_0", pLinker, {libName}, {"dx.op.cbufferLoad"}, {});
+  Link(L"test", L"ps_6_0", pLinker, {libName}, {"dx.op.cbufferLoad"}, {});
+}
+
+TEST_F(LinkerTest, RunLinkFailDebugInfoWithoutDxil) {
+  LPCWSTR option[] = {L"-Zi", L"-Qembed_debug"};
+  CComPtr<IDxcBlob> pEntryLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_global.hlsl", &pEntryLib, option,
+             L"lib_6_3");
+
+  // Rename the DXIL part so only the debug part holds a module.
+  std::string container((const char *)pEntryLib->GetBufferPointer(),
+                        pEntryLib->GetBufferSize());
+  DxilContainerHeader *pHeader =
+      IsDxilContainerLike(&container[0], container.size());
+  VERIFY_IS_NOT_NULL(pHeader);
+  VERIFY_IS_NOT_NULL(GetDxilPartByType(pHeader, DFCC_ShaderDebugInfoDXIL));
+  DxilPartHeader *pPart = GetDxilPartByType(pHeader, DFCC_DXIL);
+  VERIFY_IS_NOT_NULL(pPart);
+  pPart->PartFourCC = DXC_FOURCC('X', 'X', 'X', 'X');
+  CComPtr<IDxcBlob> pNoDxilLib;
+  MultiByteStringToBlob(m_dllSupport, container, CP_ACP, &pNoDxilLib);
+
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+  VERIFY_ARE_EQUAL(DXC_E_CONTAINER_MISSING_DXIL,
+                   pLinker->RegisterLibrary(L"entry", pNoDxilLib));
+}
+
 TEST_F(LinkerTest, RunLinkFailReDefineGlobal) {
   LPCWSTR option[] = {L"-default-linkage", L"external"};
   CComPtr<IDxcBlob> pEntryLib;
@@ -14,6 +14,7 @@
 
 #include <array>
 #include <set>
+#include <thread>
 
 #include "dxc/DxilContainer/DxilContainer.h"
 #include "dxc/Support/WinIncludes.h"
@@ -142,6 +143,7 @@ public:
 
   TEST_METHOD(CompileWhenDebugThenDIPresent)
   TEST_METHOD(CompileDebugPDB)
+  TEST_METHOD(DiaFindLinesMatchesLineTable)
 
   TEST_METHOD(DiaLoadBadBitcodeThenFail)
   TEST_METHOD(DiaLoadDebugThenOK)
@@ -200,6 +202,7 @@ public:
   TEST_METHOD(DxcPixDxilDebugInfo_VariableScopes_ScopeBraces)
   TEST_METHOD(DxcPixDxilDebugInfo_VariableScopes_Function)
   TEST_METHOD(DxcPixDxilDebugInfo_VariableScopes_Member)
+  TEST_METHOD(DxcPixDxilDebugInfo_LiveVariables_CachedMatchesUncached)
 
   dxc::DxCompilerDllLoader m_dllSupport;
   VersionSupportInfo m_ver;
@@ -954,6 +957,124 @@ TEST_F(PixDiaTest, CompileWhenDebugThenDIPresent) {
 #endif
 }
 
+// findLinesByRVA and findLinesByLinenum use indexes built by the session;
+// their results must match a scan of the full line number table.
+TEST_F(PixDiaTest, DiaFindLinesMatchesLineTable) {
+  CComPtr<IDiaDataSource> pDiaSource;
+  VERIFY_SUCCEEDED(CreateDiaSourceForCompile(
+      "float4 main(float4 pos : SV_Position) : SV_Target {\r\n"
+      "  float4 local = abs(pos);\r\n"
+      "  local.x += sin(pos.y);\r\n"
+      "  if (local.x > 1) local.y = cos(local.x); else local.z = 2;\r\n"
+      "  return local;\r\n"
+      "}",
+      &pDiaSource));
+
+  CComPtr<IDiaSession> pSession;
+  VERIFY_SUCCEEDED(pDiaSource->openSession(&pSession));
+
+  struct LineEntry {
+    DWORD rva;
+    DWORD line;
+    DWORD lineEnd;
+    DWORD fileId;
+  };
+  std::vector<LineEntry> table;
+  {
+    CComPtr<IDiaEnumTables> pEnumTables;
+    VERIFY_SUCCEEDED(pSession->getEnumTables(&pEnumTables));
+    CComPtr<IDiaTable> pTable;
+    ULONG fetched;
+    while (SUCCEEDED(pEnumTables->Next(1, &pTable, &fetched)) &&
+           fetched == 1) {
+      CComPtr<IDiaEnumLineNumbers> pLineTable;
+      if (SUCCEEDED(pTable.QueryInterface(&pLineTable))) {
+        CComPtr<IDiaLineNumber> pLine;
+        while (SUCCEEDED(pLineTable->Next(1, &pLine, &fetched)) &&
+               fetched == 1) {
+          LineEntry entry;
+          VERIFY_SUCCEEDED(pLine->get_relativeVirtualAddress(&entry.rva));
+          VERIFY_SUCCEEDED(pLine->get_lineNumber(&entry.line));
+          VERIFY_SUCCEEDED(pLine->get_lineNumberEnd(&entry.lineEnd));
+          VERIFY_SUCCEEDED(pLine->get_sourceFileId(&entry.fileId));
+          table.push_back(entry);
+          pLine.Release();
+        }
+      }
+      pTable.Release();
+    }
+  }
+  VERIFY_IS_TRUE(!table.empty());
+
+  auto ReadRvas = [](IDiaEnumLineNumbers *pEnumLineNumbers) {
+    std::vector<DWORD> rvas;
+    CComPtr<IDiaLineNumber> pLine;
+    ULONG fetched;
+    while (SUCCEEDED(pEnumLineNumbers->Next(1, &pLine, &fetched)) &&
+           fetched == 1) {
+      DWORD rva;
+      VERIFY_SUCCEEDED(pLine->get_relativeVirtualAddress(&rva));
+      rvas.push_back(rva);
+      pLine.Release();
+    }
+    return rvas;
+  };
+
+  // Every rva with line info is found on its own, with its own line.
+  DWORD maxRva = 0;
+  std::vector<DWORD> tableRvas;
+  for (const LineEntry &entry : table) {
+    CComPtr<IDiaEnumLineNumbers> pLines;
+    VERIFY_SUCCEEDED(pSession->findLinesByRVA(entry.rva, 1, &pLines));
+    std::vector<DWORD> rvas = ReadRvas(pLines);
+    VERIFY_ARE_EQUAL(1u, rvas.size());
+    VERIFY_ARE_EQUAL(entry.rva, rvas[0]);
+    maxRva = std::max(maxRva, entry.rva);
+    tableRvas.push_back(entry.rva);
+  }
+
+  // A range covering every instruction returns the same rvas in rva order;
+  // ranges that run past the last instruction are rejected.
+  std::sort(tableRvas.begin(), tableRvas.end());
+  {
+    CComPtr<IDiaEnumLineNumbers> pLines;
+    VERIFY_SUCCEEDED(pSession->findLinesByRVA(0, maxRva + 1, &pLines));
+    VERIFY_IS_TRUE(ReadRvas(pLines) == tableRvas);
+  }
+  {
+    CComPtr<IDiaEnumLineNumbers> pLines;
+    VERIFY_ARE_EQUAL(E_INVALIDARG,
+                     pSession->findLinesByRVA(maxRva, 2, &pLines));
+  }
+
+  // Lookups by line in the main file match the table entries spanning it.
+  CComPtr<IDiaEnumSourceFiles> pFiles;
+  VERIFY_SUCCEEDED(
+      pSession->findFile(nullptr, L"source.hlsl", nsNone, &pFiles));
+  CComPtr<IDiaSourceFile> pFile;
+  ULONG fetched;
+  VERIFY_SUCCEEDED(pFiles->Next(1, &pFile, &fetched));
+  VERIFY_ARE_EQUAL(1u, fetched);
+  DWORD fileId;
+  VERIFY_SUCCEEDED(pFile->get_uniqueId(&fileId));
+
+  for (DWORD line = 1; line <= 7; ++line) {
+    std::vector<DWORD> expected;
+    for (const LineEntry &entry : table) {
+      if (entry.fileId == fileId && entry.line <= line &&
+          line <= entry.lineEnd)
+        expected.push_back(entry.rva);
+    }
+    CComPtr<IDiaEnumLineNumbers> pLines;
+    HRESULT hr = pSession->findLinesByLinenum(nullptr, pFile, line, 0, &pLines);
+    VERIFY_ARE_EQUAL(expected.empty() ? S_FALSE : S_OK, hr);
+    std::vector<DWORD> actual = ReadRvas(pLines);
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    VERIFY_IS_TRUE(actual == expected);
+  }
+}
+
 // Test that the new PDB format still works with Dia
 TEST_F(PixDiaTest, CompileDebugPDB) {
   const char *hlsl = R"(
@@ -3807,4 +3928,120 @@ void CSMain()
   CheckVariableExistsAtThisInstruction(dxilDebugger, instructionOffset, L"j");
 }
 
+static std::vector<std::wstring>
+GetLiveVariableNames(IDxcPixDxilDebugInfo *dxilDebugger,
+                     DWORD instructionOffset) {
+  std::vector<std::wstring> Names;
+  CComPtr<IDxcPixDxilLiveVariables> DxcPixDxilLiveVariables;
+  if (FAILED(dxilDebugger->GetLiveVariablesAt(instructionOffset,
+                                              &DxcPixDxilLiveVariables))) {
+    // Instructions without a debug location have no live variables; keep
+    // them distinguishable from an empty live set.
+    Names.push_back(L"<failed>");
+    return Names;
+  }
+  DWORD count = 0;
+  if (FAILED(DxcPixDxilLiveVariables->GetCount(&count)))
+    return Names;
+  for (DWORD i = 0; i < count; ++i) {
+    CComPtr<IDxcPixVariable> DxcPixVariable;
+    CComBSTR Name;
+    if (FAILED(DxcPixDxilLiveVariables->GetVariableByIndex(i,
+                                                           &DxcPixVariable)) ||
+        FAILED(DxcPixVariable->GetName(&Name))) {
+      Names.push_back(L"<error>");
+      continue;
+    }
+    Names.push_back(std::wstring(Name));
+  }
+  return Names;
+}
+
+TEST_F(PixDiaTest, DxcPixDxilDebugInfo_LiveVariables_CachedMatchesUncached) {
+  if (m_ver.SkipDxilVersion(1, 6))
+    return;
+
+  const char *hlsl = R"(RWStructuredBuffer<int> intRWUAV: register(u0);
+static int globalInt;
+int Inlined(int a)
+{
+    int b = a * 2;
+    return b + globalInt;
+}
+[shader("compute")]
+[numthreads(1,1,1)]
+void CSMain()
+{
+    globalInt = intRWUAV.Load(1);
+    int zero = intRWUAV.Load(0);
+    int two = Inlined(zero);
+    for (int i = 0; i < two; ++i)
+    {
+        int one = intRWUAV.Load(i);
+        two += Inlined(one);
+    }
+    {
+        int zero = two;
+        intRWUAV[1] = zero;
+    }
+    intRWUAV[0] = two;
+}
+)";
+
+  CComPtr<IDiaDataSource> pDiaDataSource;
+  CompileAndRunAnnotationAndLoadDiaSource(m_dllSupport, hlsl, L"lib_6_6",
+                                          nullptr, &pDiaDataSource, {L"-Od"});
+  CComPtr<IDiaSession> session;
+  VERIFY_SUCCEEDED(pDiaDataSource->openSession(&session));
+  CComPtr<IDxcPixDxilDebugInfoFactory> Factory;
+  VERIFY_SUCCEEDED(session->QueryInterface(IID_PPV_ARGS(&Factory)));
+
+  CComPtr<IDxcPixDxilDebugInfo> dxilDebugger;
+  VERIFY_SUCCEEDED(Factory->NewDxcPixDxilDebugInfo(&dxilDebugger));
+
+  std::vector<DWORD> Offsets;
+  auto lines = SplitAndPreserveEmptyLines(std::string(hlsl), '\n');
+  for (DWORD line = 1; line <= static_cast<DWORD>(lines.size()); ++line) {
+    CComPtr<IDxcPixDxilInstructionOffsets> instructionOffsets;
+    if (SUCCEEDED(dxilDebugger->InstructionOffsetsFromSourceLocation(
+            defaultFilename, line, 0, &instructionOffsets))) {
+      for (DWORD i = 0; i < instructionOffsets->GetCount(); ++i)
+        Offsets.push_back(instructionOffsets->GetOffsetByIndex(i));
+    }
+  }
+  VERIFY_IS_TRUE(!Offsets.empty());
+
+  // Each query on a fresh debug info computes its live set from scratch.
+  std::vector<std::vector<std::wstring>> Expected;
+  for (DWORD Offset : Offsets) {
+    CComPtr<IDxcPixDxilDebugInfo> Uncached;
+    VERIFY_SUCCEEDED(Factory->NewDxcPixDxilDebugInfo(&Uncached));
+    Expected.push_back(GetLiveVariableNames(Uncached, Offset));
+  }
+
+  // Query the shared debug info from several threads, each starting at a
+  // different instruction, so most answers come from cache entries that were
+  // filled for another instruction or by another thread.
+  const size_t ThreadCount = 4;
+  std::vector<std::vector<std::vector<std::wstring>>> Actual(
+      ThreadCount, std::vector<std::vector<std::wstring>>(Offsets.size()));
+  std::vector<std::thread> Threads;
+  for (size_t t = 0; t < ThreadCount; ++t) {
+    Threads.emplace_back([&, t]() {
+      for (size_t n = 0; n < Offsets.size(); ++n) {
+        size_t i = (n + t * Offsets.size() / ThreadCount) % Offsets.size();
+        Actual[t][i] = GetLiveVariableNames(dxilDebugger, Offsets[i]);
+      }
+    });
+  }
+  for (std::thread &Thread : Threads)
+    Thread.join();
+
+  for (size_t t = 0; t < ThreadCount; ++t) {
+    for (size_t i = 0; i < Offsets.size(); ++i) {
+      VERIFY_IS_TRUE(Actual[t][i] == Expected[i]);
+    }
+  }
+}
+
 #endif
@@ -7267,7 +7267,20 @@ class db_dxil(object):
             "scalarrepl-param-hlsl",
             "SROA_Parameter_HLSL",
             "Scalar Replacement of Aggregates HLSL (parameters)",
-            [],
+            [
+                {
+                    "n": "MaxAggregateLeaves",
+                    "t": "unsigned",
+                    "c": 1,
+                    "d": "Copy arrays with more leaves than this in a loop and keep element-accessed arrays of vectors whole; 0 is no limit.",
+                },
+                {
+                    "n": "MemoryBudgetKB",
+                    "t": "unsigned",
+                    "c": 1,
+                    "d": "Estimated KB of IR unrolled aggregate copies may add before arrays are treated as oversized; 0 is no limit.",
+                },
+            ],
         )
         add_pass(
             "static-global-to-alloca",
@@ -7549,6 +7562,34 @@ class db_dxil(object):
             "Mutate resource to handle",
             [],
         )
+        add_pass(
+            "dxil-parallel-lib-opt",
+            "DxilParallelLibOpt",
+            "Run scalar optimizations on library partitions in parallel",
+            [
+                {"n": "OptLevel", "t": "unsigned", "d": "Optimization level"},
+                {"n": "SizeLevel", "t": "unsigned", "d": "Size optimization level"},
+                {"n": "DisableUnrollLoops", "t": "bool", "d": "Disable loop unrolling"},
+                {"n": "ResMayAlias", "t": "bool", "d": "Resources may alias"},
+                {
+                    "n": "ScanLimit",
+                    "t": "unsigned",
+                    "d": "Dead store elimination scan limit",
+                },
+                {"n": "EnableGVN", "t": "bool", "d": "Run GVN"},
+                {
+                    "n": "AggressiveReassociation",
+                    "t": "bool",
+                    "d": "Run aggressive reassociation",
+                },
+                {"n": "NoSink", "t": "bool", "d": "Disable instcombine sinking"},
+                {
+                    "n": "MaxThreads",
+                    "t": "unsigned",
+                    "d": "Maximum number of partitions; 0 uses the hardware concurrency",
+                },
+            ],
+        )
 
         category_lib = "llvm"
         add_pass(
@@ -1162,6 +1162,130 @@ def get_hlsl_intrinsics():
     return result
 
 
+def hash_hlsl_intrinsic_name(name, seed):
+    # Must match HashIntrinsicName() emitted by get_hlsl_intrinsic_name_index.
+    h = (0x811C9DC5 ^ ((seed * 0x9E3779B9) & 0xFFFFFFFF)) & 0xFFFFFFFF
+    for c in name.encode("ascii"):
+        h ^= c
+        h = (h * 0x01000193) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    return h
+
+
+def build_hlsl_intrinsic_name_hash(names):
+    # Hash-and-displace perfect hash: each name falls in bucket
+    # hash(name, 0) % len(names), and each bucket gets the first seed that
+    # sends all of its names to distinct unused slots hash(name, seed) %
+    # len(names).
+    count = len(names)
+    buckets = [[] for _ in range(count)]
+    for n in names:
+        buckets[hash_hlsl_intrinsic_name(n, 0) % count].append(n)
+    seeds = [0] * count
+    slots = [None] * count
+    for b in sorted(range(count), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            break
+        for seed in range(1, 0x10000):
+            taken = [hash_hlsl_intrinsic_name(n, seed) % count for n in buckets[b]]
+            if len(set(taken)) == len(taken) and all(
+                slots[t] is None for t in taken
+            ):
+                break
+        else:
+            raise RuntimeError("no perfect hash seed for intrinsic bucket %d" % b)
+        seeds[b] = seed
+        for n, t in zip(buckets[b], taken):
+            slots[t] = n
+    return seeds, slots
+
+
+def get_hlsl_intrinsic_name_index():
+    db = get_db_hlsl()
+    tables = []
+    for i in sorted(db.intrinsics, key=lambda x: x.key):
+        if not tables or tables[-1][0] != i.ns:
+            tables.append((i.ns, i.vulkanSpecific, []))
+        name = i.params[0].name
+        if name == i.name and i.hidden:
+            name = "$hidden$" + name
+        tables[-1][2].append(name)
+
+    result = "\n".join(
+        [
+            "",
+            "//",
+            "// Name index: a perfect hash from intrinsic name to the range of",
+            "// entries with that name in each table above.",
+            "//",
+            "",
+            "struct HLSL_INTRINSIC_NAME_RANGE {",
+            "  UINT16 uFirst; // Index of the first entry with the name",
+            "  UINT16 uCount; // Count of entries with the name",
+            "};",
+            "",
+            "struct HLSL_INTRINSIC_NAME_INDEX {",
+            "  const HLSL_INTRINSIC *pTable;",
+            "  UINT uTableCount;",
+            "  const UINT16 *pSeeds; // Seed per bucket, one bucket per slot",
+            "  const HLSL_INTRINSIC_NAME_RANGE *pSlots;",
+            "  UINT uSlotCount;",
+            "};",
+            "",
+            "static inline UINT HashIntrinsicName(const char *name, size_t length,",
+            "                                     UINT seed) {",
+            "  UINT h = 0x811C9DC5u ^ (seed * 0x9E3779B9u);",
+            "  for (size_t i = 0; i < length; ++i) {",
+            "    h ^= (unsigned char)name[i];",
+            "    h *= 0x01000193u;",
+            "  }",
+            "  h ^= h >> 16;",
+            "  h *= 0x85EBCA6Bu;",
+            "  h ^= h >> 13;",
+            "  return h;",
+            "}",
+            "",
+            "",
+        ]
+    )
+    registry = ""
+    for ns, vk, names in tables:
+        distinct = []
+        ranges = {}
+        for idx, name in enumerate(names):
+            if name in ranges:
+                first, count = ranges[name]
+                assert first + count == idx, "entries for %s not contiguous" % name
+                ranges[name] = (first, count + 1)
+            else:
+                distinct.append(name)
+                ranges[name] = (idx, 1)
+        seeds, slots = build_hlsl_intrinsic_name_hash(distinct)
+        text = "static const UINT16 g_%s_NameSeeds[] = {\n" % ns
+        text += "".join("    %d,\n" % seed for seed in seeds)
+        text += "};\n\n"
+        text += "static const HLSL_INTRINSIC_NAME_RANGE g_%s_NameSlots[] = {\n" % ns
+        text += "".join(
+            "    {%d, %d}, // %s\n" % (ranges[n][0], ranges[n][1], n) for n in slots
+        )
+        text += "};\n\n"
+        entry = (
+            "    {g_%s, _countof(g_%s), g_%s_NameSeeds, g_%s_NameSlots, %d},\n"
+            % (ns, ns, ns, ns, len(slots))
+        )
+        if vk:
+            text = "#ifdef ENABLE_SPIRV_CODEGEN\n" + text + "#endif // ENABLE_SPIRV_CODEGEN\n\n"
+            entry = "#ifdef ENABLE_SPIRV_CODEGEN\n" + entry + "#endif // ENABLE_SPIRV_CODEGEN\n"
+        result += text
+        registry += entry
+    result += "static const HLSL_INTRINSIC_NAME_INDEX g_IntrinsicNameIndices[] = {\n"
+    result += registry
+    result += "};\n\n"
+    return result
+
+
 # SPIRV Change Starts
 def wrap_with_ifdef_if_vulkan_specific(intrinsic, text):
     if intrinsic.vulkanSpecific:
@@ -129,6 +129,7 @@ def writeDxilIntrinsicTables(args):
     out = openOutput(args)
     printHeader(out, "gen_intrin_main_tables_15.h")
     out.write(get_hlsl_intrinsics())
+    out.write(get_hlsl_intrinsic_name_index())
     out.write(get_hlsl_intrinsic_stats())
     return 0
 